@@ -11,25 +11,52 @@
  * Then you connect the other side of the resistors together at a breadboard.
  * Connect a capacitor (10 uF?) in series with the resistors, and the other side of the cap to the speaker.
  * The other side of the speaker go to ground.
+ *
+ * The chords are written ahead into a command queue, with the time of each one.
+ * The engine plays them on the timer clock, so every note of a chord starts
+ * together and the rhythm does not depend on what loop() is doing.
  * 
  * 
  * Andrei Alves Cardoso, 18/07/2018
  * Updated 22/07/2018
+ * Updated 17/10/2026
  *
  */
 
 #include <fxPwm.h>
 
-//Frequencies of musical notes
-//Formula: f = 440.0 * (2^(n/12))
+//Periods of musical notes, in microseconds.
+//Formula: f = 440.0 * (2^(n/12)), period = 1000000 / f
 //Where n is the relative half-step from A4 at 440.0 Hz.
-#define FREQUENCY_B3  246.9
-#define FREQUENCY_C4  261.6
-#define FREQUENCY_D4  293.7
-#define FREQUENCY_Ds4 311.1
-#define FREQUENCY_F4  349.2
-#define FREQUENCY_G4  392.0
-#define FREQUENCY_Gs4 415.3
+#define PERIOD_B3  4050
+#define PERIOD_C4  3822
+#define PERIOD_D4  3405
+#define PERIOD_Ds4 3214
+#define PERIOD_F4  2863
+#define PERIOD_G4  2551
+#define PERIOD_Gs4 2408
+
+//50% duty cycle.
+#define DUTY 0x8000
+
+//Timed commands played by the engine.
+fxPwm_Queue song;
+
+//Queues a note (or silence, with period 0) on a pin at the current time of the song.
+//If the queue is full, waits for the engine to play the oldest commands.
+void note(UINT8 pin, TIME_US period) {
+  while(!song.Push(pin, period, DUTY, period!=0)) {
+  }
+}
+
+//Queues a chord of up to four notes, and advances the time of the song.
+void chord(TIME_US p2, TIME_US p3, TIME_US p4, TIME_US p5, TIME_US duration) {
+  note(2, p2);
+  note(3, p3);
+  note(4, p4);
+  note(5, p5);
+  song.Wait(duration);
+}
 
 void setup() {
   //Initialize fxPwm library with four output.
@@ -41,50 +68,26 @@ void setup() {
   fxPwm.RegisterPort(3);
   fxPwm.RegisterPort(4);
   fxPwm.RegisterPort(5);
+
+  //The engine runs the queue. The song starts now.
+  fxPwm.SetQueue(&song);
+  song.Sync();
 }
 
 void loop() {
   //500 ms silent
-  fxPwm.DisableAll();
-  delay(500);
-  fxPwm.EnableAll();
+  chord(0, 0, 0, 0, 500000);
 
   //C minor
-  fxPwm.SetFrequency(2, FREQUENCY_C4);
-  fxPwm.SetFrequency(3, FREQUENCY_Ds4);
-  fxPwm.SetFrequency(4, FREQUENCY_G4);
-  delay(1000);
-
+  chord(PERIOD_C4, PERIOD_Ds4, PERIOD_G4, 0, 1000000);
   //F minor
-  fxPwm.SetFrequency(2, FREQUENCY_C4);
-  fxPwm.SetFrequency(3, FREQUENCY_F4);
-  fxPwm.SetFrequency(4, FREQUENCY_Gs4);
-  delay(1000);
-
+  chord(PERIOD_C4, PERIOD_F4, PERIOD_Gs4, 0, 1000000);
   //C minor
-  fxPwm.SetFrequency(2, FREQUENCY_C4);
-  fxPwm.SetFrequency(3, FREQUENCY_Ds4);
-  fxPwm.SetFrequency(4, FREQUENCY_G4);
-  delay(1000);
-
+  chord(PERIOD_C4, PERIOD_Ds4, PERIOD_G4, 0, 1000000);
   //G
-  fxPwm.SetFrequency(2, FREQUENCY_B3);
-  fxPwm.SetFrequency(3, FREQUENCY_D4);
-  fxPwm.SetFrequency(4, FREQUENCY_G4);
-  delay(1000);
-
+  chord(PERIOD_B3, PERIOD_D4, PERIOD_G4, 0, 1000000);
   //G/7
-  fxPwm.SetFrequency(2, FREQUENCY_B3);
-  fxPwm.SetFrequency(3, FREQUENCY_D4);
-  fxPwm.SetFrequency(4, FREQUENCY_F4);
-  fxPwm.SetFrequency(5, FREQUENCY_G4);
-  delay(1000);
-
+  chord(PERIOD_B3, PERIOD_D4, PERIOD_F4, PERIOD_G4, 1000000);
   //C minor
-  fxPwm.SetFrequency(2, FREQUENCY_C4);
-  fxPwm.SetFrequency(3, FREQUENCY_Ds4);
-  fxPwm.SetFrequency(4, FREQUENCY_G4);
-  fxPwm.SetFrequency(5, 0.0);
-  delay(1500);
-  
+  chord(PERIOD_C4, PERIOD_Ds4, PERIOD_G4, 0, 1500000);
 }
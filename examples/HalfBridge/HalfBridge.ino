@@ -0,0 +1,58 @@
+/* fxPwm Half Bridge
+ * 
+ * Drives the high side and low side inputs of a half bridge (pins 5 and 6)
+ * with complementary outputs, locked to the same 1 kHz period.
+ * The low side only turns on a dead time after the high side turns off,
+ * and turns off a dead time before the high side turns on again.
+ * Both pins are one group in the scheduler, so changing the duty cycle
+ * never makes them drift apart.
+ *
+ * Check your driver datasheet for the dead time it needs. The dead time is
+ * given in timer clocks (see fxPwm.GetNsPerTimerClock()), and the real dead
+ * time is never shorter than it, but may be longer, as this is software PWM.
+ * 
+ * Andrei Alves Cardoso, 17/10/2026
+ *
+ */
+
+#include <fxPwm.h>
+
+#define PIN_HIGH_SIDE 5
+#define PIN_LOW_SIDE  6
+
+//Dead time, in nanoseconds.
+#define DEAD_TIME_NS  2000
+
+fxPwm_LockGroup bridge;
+UINT8 highSide;
+UINT8 lowSide;
+
+void setup() {
+  fxPwm.Initialize();
+  fxPwm.Start();
+
+  //The group takes one port of the library.
+  fxPwm.RegisterGroup(&bridge);
+  highSide = bridge.AddPin(PIN_HIGH_SIDE);
+  lowSide = bridge.AddPin(PIN_LOW_SIDE);
+
+  bridge.SetFrequency(1000.0);
+  bridge.SetDuty(highSide, 0.5);
+  //Low side is the complement of the high side.
+  bridge.SetComplement(lowSide, highSide, (DEAD_TIME_NS + fxPwm.GetNsPerTimerClock() - 1)/fxPwm.GetNsPerTimerClock());
+
+  bridge.Enable();
+}
+
+void loop() {
+  //Sweep the duty cycle slowly. The low side follows.
+  float duty;
+  for(duty=0.1;duty<0.9;duty+=0.01){
+    bridge.SetDuty(highSide, duty);
+    delay(20);
+  }
+  for(duty=0.9;duty>0.1;duty-=0.01){
+    bridge.SetDuty(highSide, duty);
+    delay(20);
+  }
+}
@@ -0,0 +1,46 @@
+/* fxPwm LED Panel
+ *
+ * Drives 18 LEDs (pins 2 to 13 and A0 to A5) at 10-bit brightness with the
+ * fxPwmBcm engine, and runs a slow wave of brightness across them.
+ * The interrupt writes whole PORTx registers once per bit of brightness,
+ * so its cost depends on the number of registers (3 here), not on the
+ * number of LEDs.
+ *
+ * Andrei Alves Cardoso, 17/10/2026
+ *
+ */
+
+#include <fxPwmBcm.h>
+
+//10 bits of brightness on all pins of an Uno.
+fxPwmBcm<10, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19> leds;
+
+#define FIRST_PIN 2
+#define NUM_LEDS  18
+
+void setup() {
+  //Initialize and start the engine. Do not use fxPwm.Start() with it.
+  leds.Initialize();
+  //About 200 frames per second.
+  leds.SetFramePeriod(5000);
+  leds.Start();
+  leds.EnableAll();
+}
+
+void loop() {
+  static unsigned int phase = 0;
+
+  //All LEDs change in the same frame.
+  leds.BeginUpdate();
+  for(unsigned char t=0;t<NUM_LEDS;t++){
+    //Triangle wave, shifted from one LED to the next.
+    unsigned int x = (phase + t*114) & 2047;
+    unsigned int level = (x<1024)?(x):(2047 - x);
+    //Squared, as brightness looks linear to the eye that way.
+    leds.SetLevel(FIRST_PIN + t, (unsigned int)(((unsigned long)level*level)>>10));
+  }
+  leds.EndUpdate();
+
+  phase += 8;
+  delay(10);
+}
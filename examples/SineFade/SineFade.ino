@@ -1,6 +1,8 @@
-/* fxPwm Blink
+/* fxPwm Sine Fade
  * 
- * Fades a LED with an frequency of 1 Hz.
+ * Fades a LED with a frequency of 1 Hz.
+ * The fade is a trajectory that the engine advances once per PWM period,
+ * from a sine table in flash: loop() has nothing to do.
  * 
  * Andrei Alves Cardoso, 18/07/2018
  *
@@ -8,8 +10,12 @@
 
 #include <fxPwm.h>
 
-//Frequency of the brightness, Hz.
-float frequency=1.0;
+//PWM period and fade period, in microseconds.
+#define PWM_PERIOD  3333
+#define FADE_PERIOD 1000000
+
+//Brightness trajectory of the LED.
+fxPwm_Trajectory fade;
 
 void setup() {
   //Initialize fxPwm library.
@@ -19,11 +25,12 @@ void setup() {
   //Register the LED_BUILTIN pin.
   fxPwm.RegisterPort(LED_BUILTIN);
 
-  //Sets the initial PWM frequency.
-  fxPwm.SetFrequency(LED_BUILTIN, 300.0);
+  //Sets the PWM period (about 300 Hz).
+  fxPwm.SetPeriod(LED_BUILTIN, PWM_PERIOD);
 
-  //Maps the duty cycle to go from -1.0 at 0% to +1.0 at 100%, the standard sine function range.
-  fxPwm.SetMap(LED_BUILTIN, 0.0, -1.0, 1.0, 1.0);
+  //Runs the built-in sine table (0% to 100% and back) once every FADE_PERIOD.
+  fade.Table(fxPwm_SineTable, fxPwm_SINE_TABLE_BITS, fxPwm_Trajectory::Increment(PWM_PERIOD, FADE_PERIOD));
+  fxPwm.SetTrajectory(LED_BUILTIN, &fade);
   
   //Enable LED_BUILTIN pin.
   fxPwm.EnablePin(LED_BUILTIN);
@@ -31,11 +38,5 @@ void setup() {
 
 
 void loop() {
-  //Get current time.
-  float t = ((float)fxPwm.Micros()/1000000.0);
-  //Calculate current brightness from a sine function.
-  float brightness=sin(6.28*frequency*t);
-  //Se duty cycle to change brightness.
-  fxPwm.SetDuty(LED_BUILTIN, brightness);
-  //Go on forever.
+  //Nothing to do: the duty cycle changes at the start of each PWM period.
 }
@@ -0,0 +1,55 @@
+/* fxPwm Siren
+ * 
+ * Plays a siren on a buzzer: a rising sweep from 440 Hz to 880 Hz,
+ * repeated twice per second, then a falling glide back after 5 seconds.
+ * The engine changes the frequency once per PWM period: loop() only
+ * decides which sweep comes next.
+ * 
+ * Andrei Alves Cardoso, 17/10/2026
+ *
+ */
+
+#include <fxPwm.h>
+
+//Buzzer pin.
+#define BUZZER 8
+
+//Periods of 440 Hz and 880 Hz, in microseconds.
+#define PERIOD_LOW  2272
+#define PERIOD_HIGH 1136
+
+//Frequency sweep of the buzzer.
+fxPwm_Glide siren;
+
+void setup() {
+  //Initialize fxPwm library.
+  fxPwm.Initialize();
+  fxPwm.Start();
+  
+  //Register the buzzer pin, at 50% duty cycle.
+  fxPwm.RegisterPort(BUZZER);
+  fxPwm.SetPeriod(BUZZER, PERIOD_LOW);
+  fxPwm.SetDuty(BUZZER, 0.5);
+
+  //Chirp: 440 Hz up to 880 Hz in 0.5 s, starting again every time it gets there.
+  //The exponential sweep moves the pitch by the same number of semitones per second.
+  siren.Exponential(PERIOD_LOW, PERIOD_HIGH, 500000, TRUE);
+  fxPwm.SetGlide(BUZZER, &siren);
+  
+  //Enable buzzer pin.
+  fxPwm.EnablePin(BUZZER);
+}
+
+
+void loop() {
+  delay(5000);
+
+  //Falls back to 440 Hz in 2 s, linearly in the period, and stays there.
+  siren.Linear(siren.GetPeriod(), PERIOD_LOW, 2000000, FALSE);
+  while(!siren.IsDone()) {
+  }
+  delay(1000);
+
+  //Siren again.
+  siren.Exponential(PERIOD_LOW, PERIOD_HIGH, 500000, TRUE);
+}
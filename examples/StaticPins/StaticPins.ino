@@ -0,0 +1,37 @@
+/* fxPwm Static Pins
+ * 
+ * Drives 4 pins (2, 3, 4 and 5) with the fxPwmStatic engine.
+ * The pins are fixed at compile time, so the interrupt writes straight
+ * to the PORTx registers, without looking up ports at run time.
+ * The functions are the same as the ones of fxPwm, without RegisterPort.
+ * 
+ * Andrei Alves Cardoso, 17/10/2026
+ *
+ */
+
+#include <fxPwmStatic.h>
+
+//The PWM pins.
+fxPwmStatic<2, 3, 4, 5> pwm;
+
+void setup() {
+  //Initialize and start the engine. Do not use fxPwm.Start() with it.
+  pwm.Initialize();
+  pwm.Start();
+
+  //Same frequency, different duty cycles.
+  pwm.SetFrequency(2, 500.0);
+  pwm.SetFrequency(3, 500.0);
+  pwm.SetFrequency(4, 500.0);
+  pwm.SetFrequency(5, 500.0);
+  pwm.SetDuty(2, 0.125);
+  pwm.SetDuty(3, 0.25);
+  pwm.SetDuty(4, 0.5);
+  pwm.SetDuty(5, 0.75);
+
+  pwm.EnableAll();
+}
+
+void loop() {
+  //Nothing to do. The pins keep modulating.
+}
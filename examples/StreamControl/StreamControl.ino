@@ -0,0 +1,50 @@
+/* fxPwm Stream Control
+ * 
+ * Lets a computer (or another board) drive 4 PWM pins (2, 3, 4 and 5)
+ * over the serial port, with the compact binary protocol of fxPwm_Stream.h.
+ * 
+ * Each frame is: 0x7E, header, records, CRC-8.
+ * The header holds the operation (bits 6..4), the number of records (bits 3..0)
+ * and the commit flag (bit 7). Every record starts with the pin number.
+ * For example, the frame below sets pin 2 to 1000 us and 25% (duty16 0x4000),
+ * and commits it:
+ *   7E B1 02 E8 03 00 00 40 <crc>
+ * 
+ * Frames are read straight from the serial receive buffer, a few bytes per loop(),
+ * and the changes of every frame until a commit take effect together.
+ * On the sending side, fxPwm_Encoder builds the frames:
+ *   fxPwm_Encoder encoder(Serial);
+ *   encoder.PeriodDuty(2, 1000, 0x4000);
+ *   encoder.PeriodDuty(3, 1000, 0xC000);
+ *   encoder.Commit();
+ * 
+ * Andrei Alves Cardoso, 17/10/2026
+ *
+ */
+
+#include <fxPwm.h>
+#include <fxPwm_Stream.h>
+
+//Reads frames and hands them to fxPwm.
+fxPwm_Parser parser;
+
+void setup() {
+  Serial.begin(115200);
+
+  //Initialize fxPwm library with four outputs, at 1 kHz and 0%.
+  fxPwm.Initialize();
+  fxPwm.Start();
+  for(UINT8 pin = 2; pin <= 5; pin++) {
+    fxPwm.RegisterPort(pin);
+    fxPwm.SetPeriod(pin, 1000);
+    fxPwm.SetDuty16(pin, 0);
+  }
+  fxPwm.EnableAll();
+}
+
+void loop() {
+  //Reads whatever arrived. Returns the number of frames applied.
+  parser.Poll(Serial);
+
+  //Other work can go here: frames may arrive in pieces, the parser keeps its place.
+}
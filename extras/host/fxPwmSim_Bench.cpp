@@ -0,0 +1,421 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwmSim_Bench.cpp
+ *  Bateria de medições da biblioteca fxPwm contra o simulador
+ *  de host. Percorre uma matriz de quantidade de portas,
+ *  frequências e distribuições de ciclo de trabalho, e mede
+ *  interrupções por segundo, ciclos de CPU por borda, pior
+ *  interrupção, atraso das bordas (pior e p99) e o custo das
+ *  funções de atualização.
+ *  A saída é CSV, uma medida por linha, para comparar entre
+ *  versões:
+ *    bench,scheduler,ports,freq_hz,duty,metric,value
+ *  Tudo que é medido em ciclos do simulador é determinístico.
+ *  Só as medidas *_host_ns dependem da máquina.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: casos com todas as portas na mesma frequência, com e sem escalonamento de fase. Pior interrupção.
+ *  17-10-2026: modulador BCM (fxPwmBcm) com 8 a 62 canais, a 8 e 12 bits.
+ *  17-10-2026: portas repartidas entre o TIMER1 e o TIMER3 (AddShard).
+ *  17-10-2026: com fxPwm_NO_HEAP, os motores usam um fxPwm_Storage.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <fxPwm.h>
+#include <fxPwmBcm.h>
+
+#if defined(fxPwm_NO_HEAP) && fxPwm_PortPoolSize<32
+#error "Sem heap, as portas do benchmark vêm do pool: use DEFINES=\"-DfxPwm_NO_HEAP -DfxPwm_PortPoolSize=32\"."
+#endif
+
+//Matriz de casos.
+static const UINT8 portCounts[]   = {1, 2, 4, 8, 16, 32};
+static const UINT16 frequencies[] = {50, 500, 1000, 5000};
+#define NUM_PORT_COUNTS   (sizeof(portCounts)/sizeof(portCounts[0]))
+#define NUM_FREQUENCIES   (sizeof(frequencies)/sizeof(frequencies[0]))
+
+//Distribuições de ciclo de trabalho.
+//half: todas em 50%. spread: espalhadas entre 0% e 100%, sem os extremos.
+//edge: perto e em cima dos extremos (1%, 99%, 0%, 100%, 50%).
+enum BenchDuty{
+  DUTY_HALF,
+  DUTY_SPREAD,
+  DUTY_EDGE,
+  NUM_DUTIES
+};
+static const char *dutyNames[NUM_DUTIES] = {"half", "spread", "edge"};
+
+//Modos de cada caso (coluna bench).
+//run: cada porta fica 1% acima da anterior, para que as bordas não andem juntas.
+//same: todas as portas na mesma frequência, começando juntas.
+//stagger: como same, com escalonamento de fase (SetStagger).
+//shard: como run, com as portas repartidas entre o fxPwm e um motor no TIMER3 (AddShard).
+enum BenchMode{
+  MODE_RUN,
+  MODE_SAME,
+  MODE_STAGGER,
+  MODE_SHARD,
+  NUM_MODES
+};
+static const char *modeNames[NUM_MODES] = {"run", "same", "stagger", "shard"};
+
+//Motor que recebe metade das portas no modo shard.
+static fxPwm_T1 shard(fxPwm_TIMER3);
+
+//Primeiro pino usado. Pinos em sequência, 8 por porta simulada.
+#define FIRST_PIN 2
+//Desvio de frequência entre portas consecutivas, no modo run.
+#define DETUNE 0.01
+
+//Tempo de acomodação e tempo medido, em ciclos de CPU.
+#define WARMUP_CYCLES   (F_CPU/50)
+#define MEASURE_CYCLES  (F_CPU/5)
+
+//Repetições das medidas de custo das funções. Vale a menor média.
+#define API_ROUNDS 5
+#define API_CALLS  2000
+
+//Bordas observadas em cada pino, em ciclos de CPU.
+struct PinEdges{
+  std::vector<UINT64> rises;
+  std::vector<UINT64> falls;
+};
+
+static PinEdges edges[fxPwm_MaxPorts];
+static UINT8 numPins;
+static BOOL recording;
+
+//Recebe as mudanças das portas simuladas. Pino p fica na porta p/8, bit p%8.
+static void OnPortChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  if(recording==FALSE){
+    return;
+  }
+  BYTE changed = before^after;
+  UINT8 bit;
+  for(bit=0;bit<8;bit++){
+    if((changed&(1<<bit))==0){
+      continue;
+    }
+    INT16 index = (INT16)(port*8+bit) - FIRST_PIN;
+    if(index<0 || index>=numPins){
+      continue;
+    }
+    if(after&(1<<bit)){
+      edges[index].rises.push_back(cycle);
+    }else{
+      edges[index].falls.push_back(cycle);
+    }
+  }
+}
+
+//Acrescenta os atrasos de uma sequência de bordas, que deveriam vir a cada period ciclos.
+//O atraso de cada borda é medido contra a borda mais adiantada da sequência.
+static void CollectLateness(const std::vector<UINT64> &seq, UINT64 period, std::vector<UINT64> *out){
+  if(seq.size()<2){
+    return;
+  }
+  INT64 best = 0;
+  size_t k;
+  for(k=0;k<seq.size();k++){
+    INT64 offset = (INT64)(seq[k] - seq[0]) - (INT64)(k*period);
+    best = (k==0 || offset<best)?(offset):(best);
+  }
+  for(k=0;k<seq.size();k++){
+    INT64 offset = (INT64)(seq[k] - seq[0]) - (INT64)(k*period);
+    out->push_back((UINT64)(offset - best));
+  }
+}
+
+//Imprime uma linha do CSV.
+static void Report(const char *bench, UINT8 ports, UINT16 freq, const char *duty, const char *metric, double value){
+  printf("%s,%u,%u,%u,%s,%s,%.3f\n", bench, (unsigned)fxPwm_Scheduler, ports, freq, duty, metric, value);
+}
+
+//Ciclo de trabalho de 16 bits da porta index de count, na distribuição dada.
+static UINT16 BenchDuty16(BenchDuty duty, UINT8 index, UINT8 count){
+  static const UINT16 edge[] = {655, 64880, 0, fxPwm_DUTY16_MAX, fxPwm_DUTY16_MAX/2};
+  switch(duty){
+    case DUTY_SPREAD: return (UINT16)(((UINT32)fxPwm_DUTY16_MAX*(index+1))/(count+1));
+    case DUTY_EDGE:   return edge[index%(sizeof(edge)/sizeof(edge[0]))];
+    default:          return fxPwm_DUTY16_MAX/2;
+  }
+}
+
+//Começa do zero com count portas registradas, habilitadas, na frequência base dada.
+static void Setup(UINT8 count, UINT16 freq, BenchDuty duty, BenchMode mode){
+  fxPwm.Free();
+  shard.Free();
+  fxPwmSim.Reset();
+  fxPwmSim.observer = OnPortChange;
+  recording = FALSE;
+
+#ifdef fxPwm_NO_HEAP
+  //Sem heap: as tabelas ficam em memória estática, e as portas no pool (fxPwm_PortPoolSize).
+  static fxPwm_Storage<fxPwm_MaxPorts> storage;
+  static fxPwm_Storage<fxPwm_MaxPorts> shardStorage;
+  fxPwm.Initialize(storage);
+#else
+  fxPwm.Initialize();
+#endif
+  if(mode==MODE_SHARD){
+#ifdef fxPwm_NO_HEAP
+    shard.Initialize(shardStorage);
+#else
+    shard.Initialize();
+#endif
+    fxPwm.AddShard(&shard);
+  }
+  fxPwm.SetStagger((mode==MODE_STAGGER)?(TRUE):(FALSE));
+  fxPwm.Start();
+
+  UINT8 t;
+  numPins = count;
+  for(t=0;t<count;t++){
+    UINT8 pin = FIRST_PIN+t;
+    edges[t].rises.clear();
+    edges[t].falls.clear();
+    fxPwm.RegisterPort(pin);
+    fxPwm.SetPeriod(pin, (TIME_US)(1000000.0/(freq*(1.0 + ((mode==MODE_RUN || mode==MODE_SHARD)?(DETUNE*t):(0.0)))) + 0.5));
+    fxPwm.SetDuty16(pin, BenchDuty16(duty, t, count));
+  }
+  fxPwm.EnableAll();
+}
+
+//Mede o modulador rodando: interrupções, carga, ciclos por borda e atraso das bordas.
+static void BenchRun(UINT8 count, UINT16 freq, BenchDuty duty, BenchMode mode){
+  Setup(count, freq, duty, mode);
+  fxPwmSim.Run(WARMUP_CYCLES);
+
+  fxPwmSim.isrMaxCycles = 0;
+  UINT32 isrStart = fxPwmSim.isrCount;
+  UINT64 isrCyclesStart = fxPwmSim.isrCycles;
+  recording = TRUE;
+  fxPwmSim.Run(MEASURE_CYCLES);
+  recording = FALSE;
+  UINT32 isrCount = fxPwmSim.isrCount - isrStart;
+  UINT64 isrCycles = fxPwmSim.isrCycles - isrCyclesStart;
+
+  //Ciclos de CPU por ciclo do timer.
+  UINT64 cpuPerClk = ((UINT64)fxPwm.GetNsPerTimerClock()*F_CPU)/1000000000;
+  std::vector<UINT64> lateness;
+  UINT64 numEdges = 0;
+  UINT8 t;
+  for(t=0;t<count;t++){
+    UINT64 period = (UINT64)fxPwm.GetPeriodClk(FIRST_PIN+t)*cpuPerClk;
+    numEdges += edges[t].rises.size() + edges[t].falls.size();
+    CollectLateness(edges[t].rises, period, &lateness);
+    CollectLateness(edges[t].falls, period, &lateness);
+  }
+
+  UINT64 p99 = 0, worst = 0;
+  if(!lateness.empty()){
+    std::sort(lateness.begin(), lateness.end());
+    p99 = lateness[(lateness.size()*99)/100];
+    worst = lateness.back();
+  }
+
+  double seconds = (double)MEASURE_CYCLES/F_CPU;
+  const char *name = dutyNames[duty];
+  const char *bench = modeNames[mode];
+  Report(bench, count, freq, name, "isr_per_s", isrCount/seconds);
+  Report(bench, count, freq, name, "cpu_load_pct", 100.0*(double)isrCycles/(double)MEASURE_CYCLES);
+  Report(bench, count, freq, name, "edges_per_s", numEdges/seconds);
+  Report(bench, count, freq, name, "cycles_per_edge", (numEdges==0)?(0.0):((double)isrCycles/(double)numEdges));
+  Report(bench, count, freq, name, "isr_max_cycles", (double)fxPwmSim.isrMaxCycles);
+  Report(bench, count, freq, name, "late_p99_cycles", (double)p99);
+  Report(bench, count, freq, name, "late_max_cycles", (double)worst);
+}
+
+//Quadros por segundo do modulador BCM.
+#define BCM_FRAME_HZ 200
+
+//Tempo em nível ALTO de cada pino no modulador BCM, em ciclos de CPU.
+static UINT64 bcmHigh[NUM_DIGITAL_PINS];
+static UINT64 bcmRise[NUM_DIGITAL_PINS];
+
+//Recebe as mudanças das portas simuladas com o modulador BCM.
+static void OnBcmChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  if(recording==FALSE){
+    return;
+  }
+  BYTE changed = before^after;
+  UINT8 bit;
+  for(bit=0;bit<8;bit++){
+    if((changed&(1<<bit))==0){
+      continue;
+    }
+    if(after&(1<<bit)){
+      bcmRise[port*8+bit] = cycle;
+    }else{
+      bcmHigh[port*8+bit] += cycle - bcmRise[port*8+bit];
+    }
+  }
+}
+
+//Mede o modulador BCM com os canais FIRST_PIN até FIRST_PIN+count-1, com ciclos de trabalho espalhados.
+//O tempo medido é um número inteiro de quadros, de modo que o ciclo de trabalho medido não depende da fase.
+template<UINT8 bits, size_t... I>
+static void BenchBcm(std::index_sequence<I...>){
+  static fxPwmBcm<bits, (UINT8)(FIRST_PIN+I)...> bcm;
+  const UINT8 count = sizeof...(I);
+  char bench[8];
+  snprintf(bench, sizeof(bench), "bcm%u", bits);
+
+  fxPwm.Free();
+  fxPwmSim.Reset();
+  fxPwmSim.observer = OnBcmChange;
+  recording = FALSE;
+
+  bcm.Initialize();
+  bcm.SetFramePeriod(1000000/BCM_FRAME_HZ);
+  bcm.Start();
+  bcm.BeginUpdate();
+  UINT8 t;
+  for(t=0;t<count;t++){
+    bcm.SetDuty16(FIRST_PIN+t, BenchDuty16(DUTY_SPREAD, t, count));
+  }
+  bcm.EnableAll();
+  bcm.EndUpdate();
+  fxPwmSim.Run(WARMUP_CYCLES);
+
+  UINT64 cpuPerClk = ((UINT64)fxPwm.GetNsPerTimerClock()*F_CPU)/1000000000;
+  UINT64 frameCycles = (UINT64)bcm.GetFramePeriodClk()*cpuPerClk;
+  UINT64 window = (MEASURE_CYCLES/frameCycles)*frameCycles;
+  for(t=0;t<count;t++){
+    UINT8 pin = FIRST_PIN+t;
+    bcmHigh[pin] = 0;
+    bcmRise[pin] = fxPwmSim.cycles;
+  }
+
+  fxPwmSim.isrMaxCycles = 0;
+  UINT32 isrStart = fxPwmSim.isrCount;
+  UINT64 isrCyclesStart = fxPwmSim.isrCycles;
+  UINT64 start = fxPwmSim.cycles;
+  recording = TRUE;
+  fxPwmSim.Run(window);
+  recording = FALSE;
+  UINT32 isrCount = fxPwmSim.isrCount - isrStart;
+  UINT64 isrCycles = fxPwmSim.isrCycles - isrCyclesStart;
+
+  //Erro do ciclo de trabalho medido contra o nível pedido, em pontos percentuais.
+  double worst = 0.0;
+  for(t=0;t<count;t++){
+    UINT8 pin = FIRST_PIN+t;
+    if(fxPwmSim.port[pin>>3]&(1<<(pin&0x07))){
+      bcmHigh[pin] += fxPwmSim.cycles - bcmRise[pin];
+    }
+    double error = 100.0*((double)bcmHigh[pin]/(double)(fxPwmSim.cycles - start) - (double)bcm.GetLevel(pin)/(double)((1UL<<bits)-1));
+    worst = std::max(worst, (error<0.0)?(-error):(error));
+  }
+
+  double seconds = (double)window/F_CPU;
+  Report(bench, count, BCM_FRAME_HZ, "spread", "isr_per_s", isrCount/seconds);
+  Report(bench, count, BCM_FRAME_HZ, "spread", "cpu_load_pct", 100.0*(double)isrCycles/(double)window);
+  Report(bench, count, BCM_FRAME_HZ, "spread", "isr_max_cycles", (double)fxPwmSim.isrMaxCycles);
+  Report(bench, count, BCM_FRAME_HZ, "spread", "duty_err_max_pct", worst);
+
+  bcm.Free();
+}
+
+//Tempo do host, em nanossegundos.
+static UINT64 HostNs(){
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Mede o custo das funções de atualização com o modulador rodando, em nanossegundos do host por chamada.
+static void BenchApi(UINT8 count){
+  Setup(count, 1000, DUTY_HALF, MODE_RUN);
+  fxPwmSim.Run(WARMUP_CYCLES);
+
+  double best[3] = {1e30, 1e30, 1e30};
+  UINT8 round;
+  UINT32 call;
+  UINT64 start;
+  for(round=0;round<API_ROUNDS;round++){
+    //Ciclo de trabalho.
+    start = HostNs();
+    for(call=0;call<API_CALLS;call++){
+#ifdef fxPwm_NO_FLOAT
+      fxPwm.SetDuty16(FIRST_PIN + call%count, (call&1)?(16384):(49152));
+#else
+      fxPwm.SetDuty(FIRST_PIN + call%count, (call&1)?(0.25):(0.75));
+#endif
+    }
+    best[0] = std::min(best[0], (double)(HostNs() - start)/API_CALLS);
+    fxPwmSim.Run(F_CPU/1000);
+
+    //Frequência.
+    start = HostNs();
+    for(call=0;call<API_CALLS;call++){
+#ifdef fxPwm_NO_FLOAT
+      fxPwm.SetPeriod(FIRST_PIN + call%count, (call&1)?(1000):(900));
+#else
+      fxPwm.SetFrequency(FIRST_PIN + call%count, (call&1)?(1000.0):(1100.0));
+#endif
+    }
+    best[1] = std::min(best[1], (double)(HostNs() - start)/API_CALLS);
+    fxPwmSim.Run(F_CPU/1000);
+
+    //Habilitação: cada chamada habilita uma porta desabilitada.
+    UINT64 total = 0;
+    for(call=0;call<API_CALLS;call+=count){
+      fxPwm.DisableAll();
+      start = HostNs();
+      UINT8 t;
+      for(t=0;t<count;t++){
+        fxPwm.EnablePin(FIRST_PIN+t);
+      }
+      total += HostNs() - start;
+    }
+    best[2] = std::min(best[2], (double)total/(((API_CALLS+count-1)/count)*count));
+    fxPwmSim.Run(F_CPU/1000);
+  }
+
+#ifdef fxPwm_NO_FLOAT
+  Report("api", count, 1000, "half", "SetDuty16_host_ns", best[0]);
+  Report("api", count, 1000, "half", "SetPeriod_host_ns", best[1]);
+#else
+  Report("api", count, 1000, "half", "SetDuty_host_ns", best[0]);
+  Report("api", count, 1000, "half", "SetFrequency_host_ns", best[1]);
+#endif
+  Report("api", count, 1000, "half", "EnablePin_host_ns", best[2]);
+}
+
+int main(){
+  UINT8 m, p, f, d;
+
+  printf("bench,scheduler,ports,freq_hz,duty,metric,value\n");
+  for(m=0;m<NUM_MODES;m++){
+    for(p=0;p<NUM_PORT_COUNTS;p++){
+      for(f=0;f<NUM_FREQUENCIES;f++){
+        for(d=0;d<NUM_DUTIES;d++){
+          BenchRun(portCounts[p], frequencies[f], (BenchDuty)d, (BenchMode)m);
+        }
+      }
+    }
+  }
+  for(p=0;p<NUM_PORT_COUNTS;p++){
+    BenchApi(portCounts[p]);
+  }
+  BenchBcm<8>(std::make_index_sequence<8>());
+  BenchBcm<8>(std::make_index_sequence<16>());
+  BenchBcm<8>(std::make_index_sequence<32>());
+  BenchBcm<8>(std::make_index_sequence<62>());
+  BenchBcm<12>(std::make_index_sequence<8>());
+  BenchBcm<12>(std::make_index_sequence<16>());
+  BenchBcm<12>(std::make_index_sequence<32>());
+  BenchBcm<12>(std::make_index_sequence<62>());
+
+  fxPwm.Free();
+  shard.Free();
+
+  return 0;
+}
@@ -0,0 +1,471 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwmSim_Main.cpp
+ *  Executa a biblioteca fxPwm contra o simulador de host e
+ *  mostra a frequência e o ciclo de trabalho medidos em cada
+ *  pino, além do custo das interrupções.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: fxPwmSim_STATIC executa os mesmos pinos com o fxPwmStatic.
+ *  17-10-2026: mostra as estatísticas do Tick() quando compilado com fxPwm_STATS.
+ *  17-10-2026: meia ponte com grupo travado: mede o menor tempo morto e as sobreposições.
+ *  17-10-2026: pino em modo PDM: mede o ciclo de trabalho e a quantidade de pulsos.
+ *  17-10-2026: pino com PWM por hardware: mostra a passagem para o timer e a volta para o Tick().
+ *  17-10-2026: protocolo binário: quadros do codificador lidos pelo leitor por uma Stream de laço.
+ *  17-10-2026: com fxPwm_NO_HEAP, o motor usa um fxPwm_Storage.
+ *  17-10-2026: rampa do ciclo de trabalho (fxPwm_Trajectory): mede o tempo ALTO depois do fim da rampa.
+ *  17-10-2026: varredura exponencial do período (fxPwm_Glide): mede o período e o tempo ALTO no fim.
+ *  17-10-2026: comando da fila (fxPwm_Queue) com hora marcada: mede a primeira borda e o período.
+ */
+
+#include <stdio.h>
+#include <fxPwm.h>
+
+#ifdef fxPwmSim_STATIC
+#include <fxPwmStatic.h>
+//Modulador de pinos fixos. Os pinos devem ser os mesmos de pins[].
+static fxPwmStatic<2, 3, 4, LED_BUILTIN> pwm;
+#else
+#include <fxPwm_Port.h>
+#include <fxPwm_Stream.h>
+static fxPwm_T1 &pwm = fxPwm;
+#if defined(fxPwm_NO_HEAP) && fxPwm_PortPoolSize<10
+#error "Sem heap, as portas da demonstração vêm do pool: use DEFINES=\"-DfxPwm_NO_HEAP -DfxPwm_PortPoolSize=10\"."
+#endif
+#endif
+
+//Pinos, frequências e ciclos de trabalho simulados.
+static const UINT8 pins[]         = {2, 3, 4, LED_BUILTIN};
+static const double frequencies[] = {261.6, 311.1, 392.0, 300.0};
+static const double duties[]      = {0.5, 0.5, 0.5, 0.25};
+#define NUM_PINS (sizeof(pins)/sizeof(pins[0]))
+
+//Tempo simulado, em segundos.
+#define SIM_SECONDS 1
+
+//Medições por pino, a partir das bordas observadas.
+struct PinStats{
+  UINT64 firstRise;
+  UINT64 lastRise;
+  UINT64 highCycles;
+  UINT64 lastEdge;
+  UINT32 rises;
+};
+
+static PinStats stats[NUM_PINS];
+
+#ifndef fxPwmSim_STATIC
+//Meia ponte: dois pinos complementares travados no mesmo período, com tempo morto.
+static fxPwm_LockGroup bridge;
+static const UINT8 bridgePins[2] = {5, 6};
+#define BRIDGE_PERIOD_US 1000
+#define BRIDGE_DEAD_CLK  4
+//Ciclos de trabalho do pino A, trocados ao longo da simulação.
+static const UINT16 bridgeDuties[] = {0x8000, 0x2000, 0xE000, 0x0000, 0x4000, 0xFFFF, 0x6000, 0x1000, 0xF000, 0x8000};
+#define NUM_BRIDGE_DUTIES (sizeof(bridgeDuties)/sizeof(bridgeDuties[0]))
+
+//Medições da meia ponte, em ciclos de CPU.
+struct BridgeStats{
+  UINT8 level[2];
+  UINT64 lastFall[2];
+  UINT64 minDead;
+  UINT32 overlaps;
+  UINT32 rises[2];
+};
+
+static BridgeStats bridgeStats = {{0, 0}, {0, 0}, (UINT64)-1, 0, {0, 0}};
+
+//Na subida de um pino, o outro precisa estar BAIXO há pelo menos o tempo morto.
+static void OnBridgeChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  UINT8 t;
+  for(t=0;t<2;t++){
+    if(digitalPinToPort(bridgePins[t])-1!=port){
+      continue;
+    }
+    BYTE mask = digitalPinToBitMask(bridgePins[t]);
+    if(((before^after)&mask)==0){
+      continue;
+    }
+    bridgeStats.level[t] = (after&mask)?(1):(0);
+    if(bridgeStats.level[t]==0){
+      bridgeStats.lastFall[t] = cycle;
+      continue;
+    }
+    bridgeStats.rises[t]++;
+    if(bridgeStats.level[t^1]!=0){
+      bridgeStats.overlaps++;
+    }else if(bridgeStats.rises[t^1]>0 && cycle - bridgeStats.lastFall[t^1]<bridgeStats.minDead){
+      bridgeStats.minDead = cycle - bridgeStats.lastFall[t^1];
+    }
+  }
+}
+
+//Pino em modo PDM, com passo padrão (fxPwm_PdmPeriod).
+static const UINT8 pdmPin = 7;
+#define PDM_DUTY16 0x4CCD
+
+//Medições do pino PDM, em ciclos de CPU.
+struct PdmStats{
+  UINT8 level;
+  UINT64 start;
+  UINT64 lastRise;
+  UINT64 highCycles;
+  UINT32 rises;
+};
+
+static PdmStats pdmStats = {0, 0, 0, 0, 0};
+
+static void OnPdmChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  BYTE mask = digitalPinToBitMask(pdmPin);
+  if(digitalPinToPort(pdmPin)-1!=port || ((before^after)&mask)==0){
+    return;
+  }
+  pdmStats.level = (after&mask)?(1):(0);
+  if(pdmStats.level!=0){
+    pdmStats.lastRise = cycle;
+    pdmStats.rises++;
+  }else{
+    pdmStats.highCycles += cycle - pdmStats.lastRise;
+  }
+}
+
+//Pino com PWM por hardware (como o pino 11 do Uno, no TIMER2), com o período do timer.
+static const UINT8 hwPin = 9;
+#define HW_TIMER     2
+#define HW_PERIOD_US 2040
+#define HW_DUTY16    fxPwm_HW_DUTY16(64)
+//Período que o timer não consegue gerar: o pino volta para o Tick().
+#define HW_SOFT_PERIOD_US 1000
+
+//Período e ciclo de trabalho enviados pelo protocolo binário para o pino hwPin.
+#define STREAM_PERIOD_US 500
+#define STREAM_DUTY16    0x2000
+
+//Medições de um pino só, feitas uma de cada vez depois das principais, em ciclos de CPU.
+struct ProbeStats{
+  UINT8 pin;
+  UINT8 level;
+  UINT64 firstRise;
+  UINT64 lastRise;
+  UINT64 period;
+  UINT64 high;
+  UINT32 rises;
+  //Médias a partir de ProbeMark(): subidas e soma dos tempos ALTOS.
+  UINT64 markRise;
+  UINT32 markRises;
+  UINT64 highSum;
+  UINT32 highCount;
+};
+
+static ProbeStats probe = {0xFF, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+#define CPU_PER_US ((double)F_CPU/1000000.0)
+
+//Guarda a primeira subida, o último período e o último tempo ALTO do pino medido.
+static void OnProbeChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  if(probe.pin==0xFF){
+    return;
+  }
+  BYTE mask = digitalPinToBitMask(probe.pin);
+  if(digitalPinToPort(probe.pin)-1!=port || ((before^after)&mask)==0){
+    return;
+  }
+  probe.level = (after&mask)?(1):(0);
+  if(probe.level!=0){
+    if(probe.rises==0){
+      probe.firstRise = cycle;
+    }else{
+      probe.period = cycle - probe.lastRise;
+    }
+    probe.lastRise = cycle;
+    probe.rises++;
+  }else if(probe.rises>0){
+    probe.high = cycle - probe.lastRise;
+    if(probe.lastRise>=probe.markRise){
+      probe.highSum += probe.high;
+      probe.highCount++;
+    }
+  }
+}
+
+//Passa a medir outro pino, do zero.
+static void ProbePin(UINT8 pin){
+  ProbeStats empty = {pin, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  probe = empty;
+}
+
+//Começa as médias na última subida.
+static void ProbeMark(){
+  probe.markRise = probe.lastRise;
+  probe.markRises = probe.rises;
+  probe.highSum = 0;
+  probe.highCount = 0;
+}
+
+//Período e tempo ALTO médios desde ProbeMark(), em microssegundos.
+static double ProbePeriodUs(){
+  return (probe.rises>probe.markRises)?((double)(probe.lastRise - probe.markRise)/(probe.rises - probe.markRises)/CPU_PER_US):(0.0);
+}
+
+static double ProbeHighUs(){
+  return (probe.highCount>0)?((double)probe.highSum/probe.highCount/CPU_PER_US):(0.0);
+}
+
+//Pino com uma rampa do ciclo de trabalho (fxPwm_Trajectory), medido depois do fim da rampa.
+static const UINT8 trajectoryPin = 10;
+#define TRAJECTORY_PERIOD_US 1000
+#define TRAJECTORY_START16   0x4000
+#define TRAJECTORY_END16     0xC000
+#define TRAJECTORY_PERIODS   100
+
+//Pino com uma varredura exponencial do período (fxPwm_Glide), medido depois do fim da varredura.
+static const UINT8 glidePin = 11;
+#define GLIDE_START_US    1000
+#define GLIDE_END_US      250
+#define GLIDE_DURATION_US 100000
+#define GLIDE_DUTY16      0x8000
+
+//Pino ligado por um comando da fila (fxPwm_Queue), marcado para QUEUE_WAIT_US depois do Sync().
+static const UINT8 queuePin = 12;
+#define QUEUE_WAIT_US   10000
+#define QUEUE_PERIOD_US 500
+#define QUEUE_DUTY16    0x4000
+#endif
+
+//Recebe as mudanças das portas simuladas.
+static void OnPortChange(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle){
+  UINT8 t;
+  for(t=0;t<NUM_PINS;t++){
+    if(digitalPinToPort(pins[t])-1!=port){
+      continue;
+    }
+    BYTE mask = digitalPinToBitMask(pins[t]);
+    if((before^after)&mask){
+      PinStats *s = &stats[t];
+      if(after&mask){
+        //Borda de subida.
+        if(s->rises==0){
+          s->firstRise = cycle;
+        }
+        s->lastRise = cycle;
+        s->rises++;
+      }else if(s->rises>0){
+        //Borda de descida.
+        s->highCycles += cycle - s->lastEdge;
+      }
+      s->lastEdge = cycle;
+    }
+  }
+#ifndef fxPwmSim_STATIC
+  OnBridgeChange(port, before, after, cycle);
+  OnPdmChange(port, before, after, cycle);
+  OnProbeChange(port, before, after, cycle);
+#endif
+}
+
+int main(){
+  fxPwmSim.Reset();
+  fxPwmSim.observer = OnPortChange;
+
+#if defined(fxPwm_NO_HEAP) && !defined(fxPwmSim_STATIC)
+  //Sem heap: as tabelas ficam em memória estática.
+  static fxPwm_Storage<fxPwm_MaxPorts> storage;
+  pwm.Initialize(storage);
+#else
+  pwm.Initialize();
+#endif
+  pwm.Start();
+
+  UINT8 t;
+  for(t=0;t<NUM_PINS;t++){
+#ifndef fxPwmSim_STATIC
+    pwm.RegisterPort(pins[t]);
+#endif
+#ifdef fxPwm_NO_FLOAT
+    //Só as funções inteiras existem.
+    pwm.SetPeriod(pins[t], (TIME_US)(1000000.0/frequencies[t] + 0.5));
+    pwm.SetDuty16(pins[t], (UINT16)(duties[t]*fxPwm_DUTY16_MAX + 0.5));
+#else
+    pwm.SetFrequency(pins[t], frequencies[t]);
+    pwm.SetDuty(pins[t], duties[t]);
+#endif
+  }
+#ifndef fxPwmSim_STATIC
+  //Pino B é o complemento de A.
+  fxPwm.RegisterGroup(&bridge);
+  bridge.AddPin(bridgePins[0]);
+  bridge.AddPin(bridgePins[1]);
+  bridge.SetPeriod(BRIDGE_PERIOD_US);
+  bridge.SetComplement(1, 0, BRIDGE_DEAD_CLK);
+
+  fxPwm.RegisterPort(pdmPin);
+  fxPwm.SetDuty16(pdmPin, PDM_DUTY16);
+  fxPwm.SetPdm(pdmPin, TRUE);
+#endif
+  pwm.EnableAll();
+#ifndef fxPwmSim_STATIC
+  pdmStats.start = fxPwmSim.cycles;
+#endif
+
+#ifndef fxPwmSim_STATIC
+  //O ciclo de trabalho da meia ponte muda durante a simulação.
+  for(t=0;t<NUM_BRIDGE_DUTIES;t++){
+    bridge.SetDuty16(0, bridgeDuties[t]);
+    fxPwmSim.Run((UINT64)F_CPU*SIM_SECONDS/NUM_BRIDGE_DUTIES);
+  }
+#else
+  fxPwmSim.Run((UINT64)F_CPU*SIM_SECONDS);
+#endif
+
+  printf("pin  freq_set  freq_meas  duty_set  duty_meas\n");
+  for(t=0;t<NUM_PINS;t++){
+    PinStats *s = &stats[t];
+    double freq = 0.0, duty = 0.0;
+    if(s->rises>1){
+      UINT64 span = s->lastRise - s->firstRise;
+      freq = (double)F_CPU*(double)(s->rises-1)/(double)span;
+      duty = (double)s->highCycles/(double)span;
+    }
+    printf("%3u  %8.2f  %9.2f  %8.3f  %9.3f\n", pins[t], frequencies[t], freq, duties[t], duty);
+  }
+
+#ifndef fxPwmSim_STATIC
+  //Tempo morto em ciclos do timer.
+  UINT32 cpuPerClk = (UINT32)((UINT64)fxPwm.GetNsPerTimerClock()*F_CPU/1000000000);
+  printf("\nbridge %u/%u  rises %u/%u  dead_set %u clk  dead_min %.2f clk  overlaps %u\n",
+    bridgePins[0], bridgePins[1], bridgeStats.rises[0], bridgeStats.rises[1], BRIDGE_DEAD_CLK,
+    (bridgeStats.minDead==(UINT64)-1)?(0.0):((double)bridgeStats.minDead/cpuPerClk), bridgeStats.overlaps);
+
+  if(pdmStats.level!=0){
+    pdmStats.highCycles += fxPwmSim.cycles - pdmStats.lastRise;
+  }
+  printf("pdm %u  step %lu us  pulses %u  duty_set %.4f  duty_meas %.4f\n", pdmPin, (unsigned long)fxPwm.GetPdmPeriod(), pdmStats.rises,
+    (double)PDM_DUTY16/fxPwm_DUTY16_MAX, (double)pdmStats.highCycles/(double)(fxPwmSim.cycles - pdmStats.start));
+
+  //Custo das interrupções da simulação principal, antes das medições de um pino só.
+  UINT32 isrCount = fxPwmSim.isrCount;
+  UINT64 isrCycles = fxPwmSim.isrCycles;
+  UINT64 isrHostNs = fxPwmSim.isrHostNs;
+  UINT64 cycles = fxPwmSim.cycles;
+#ifdef fxPwm_STATS
+  fxPwm_Stats st;
+  fxPwm.GetStats(&st);
+#endif
+
+  //Depois das medições, para não mudar a carga da interrupção.
+  fxPwmSim.hwTimer[hwPin] = HW_TIMER;
+  fxPwm.RegisterPort(hwPin);
+  fxPwm.SetDuty16(hwPin, HW_DUTY16);
+  fxPwm.SetPeriod(hwPin, HW_PERIOD_US);
+  fxPwm.EnablePin(hwPin);
+  printf("hw %u  timer %u  period %u us  hardware %u  analog %d", hwPin, HW_TIMER, HW_PERIOD_US,
+    fxPwm.IsHardware(hwPin), fxPwmSim.hwDuty[hwPin]);
+  fxPwm.SetPeriod(hwPin, HW_SOFT_PERIOD_US);
+  printf("  ->  period %u us  hardware %u  analog %d\n", HW_SOFT_PERIOD_US, fxPwm.IsHardware(hwPin), fxPwmSim.hwDuty[hwPin]);
+
+  //Um lote em dois quadros, e um quadro com o CRC errado, que deve ser descartado.
+  fxPwm_Loopback link;
+  fxPwm_Encoder encoder(link);
+  fxPwm_Parser parser;
+  encoder.Period(hwPin, STREAM_PERIOD_US);
+  encoder.Duty(hwPin, STREAM_DUTY16);
+  encoder.Commit();
+  UINT8 bytes = (UINT8)link.available();
+  UINT8 bad[] = {fxPwm_STREAM_SYNC, fxPwm_STREAM_COMMIT | (fxPwm_STREAM_DUTY<<4) | 1, hwPin, 0xFF, 0xFF, 0x00};
+  link.write(bad, sizeof(bad));
+  parser.Poll(link);
+  fxPwm_Port *streamPort = fxPwm.GetPort(hwPin);
+  printf("stream %u  bytes %u  frames %u  errors %u  period %u us  duty16 0x%04X\n", hwPin, bytes, parser.GetFrames(),
+    parser.GetErrors(), (unsigned)streamPort->GetPeriod(), streamPort->GetRawDuty16());
+
+  //Rampa do ciclo de trabalho, avançada pelo Tick() a cada período. No fim, o tempo ALTO é o do alvo.
+  fxPwm_Trajectory trajectory;
+  ProbePin(trajectoryPin);
+  fxPwm.RegisterPort(trajectoryPin);
+  fxPwm.SetPeriod(trajectoryPin, TRAJECTORY_PERIOD_US);
+  fxPwm.SetDuty16(trajectoryPin, TRAJECTORY_START16);
+  fxPwm.SetTrajectory(trajectoryPin, &trajectory);
+  trajectory.Ramp(TRAJECTORY_END16, TRAJECTORY_PERIODS);
+  fxPwm.EnablePin(trajectoryPin);
+  for(t=0;t<2*TRAJECTORY_PERIODS && trajectory.IsDone()==FALSE;t++){
+    fxPwmSim.Run((UINT64)F_CPU*TRAJECTORY_PERIOD_US/1000000);
+  }
+  fxPwmSim.Run((UINT64)F_CPU*TRAJECTORY_PERIOD_US/1000000*3);
+  printf("trajectory %u  ramp 0x%04X->0x%04X  done %u  high_set %.1f us  high_meas %.1f us\n", trajectoryPin,
+    TRAJECTORY_START16, TRAJECTORY_END16, trajectory.IsDone(),
+    (double)TRAJECTORY_END16*TRAJECTORY_PERIOD_US/fxPwm_DUTY16_MAX, (double)probe.high/CPU_PER_US);
+  fxPwm.DisablePin(trajectoryPin);
+
+  //Varredura do período, avançada pelo Tick() a cada período. No fim, o período e o tempo ALTO são os do final.
+  fxPwm_Glide glide;
+  ProbePin(glidePin);
+  fxPwm.RegisterPort(glidePin);
+  fxPwm.SetPeriod(glidePin, GLIDE_START_US);
+  fxPwm.SetDuty16(glidePin, GLIDE_DUTY16);
+  fxPwm.SetGlide(glidePin, &glide);
+  glide.Exponential(GLIDE_START_US, GLIDE_END_US, GLIDE_DURATION_US, FALSE);
+  fxPwm.EnablePin(glidePin);
+  for(t=0;t<2*GLIDE_DURATION_US/1000 && glide.IsDone()==FALSE;t++){
+    fxPwmSim.Run((UINT64)F_CPU/1000);
+  }
+  //Médias de 20 períodos, para tirar o jitter das outras portas.
+  fxPwmSim.Run((UINT64)F_CPU*GLIDE_END_US/1000000);
+  ProbeMark();
+  fxPwmSim.Run((UINT64)F_CPU*GLIDE_END_US/1000000*20);
+  printf("glide %u  period %u->%u us  done %u  period_meas %.1f us  high_set %.1f us  high_meas %.1f us\n", glidePin,
+    GLIDE_START_US, GLIDE_END_US, glide.IsDone(), ProbePeriodUs(),
+    (double)GLIDE_DUTY16*GLIDE_END_US/fxPwm_DUTY16_MAX, ProbeHighUs());
+  fxPwm.DisablePin(glidePin);
+
+  //Comando com hora marcada: a primeira subida sai no instante do comando, e o período é o do comando.
+  fxPwm_Queue queue;
+  ProbePin(queuePin);
+  fxPwm.RegisterPort(queuePin);
+  fxPwm.SetQueue(&queue);
+  queue.Sync();
+  UINT64 queueStart = fxPwmSim.cycles;
+  queue.Wait(QUEUE_WAIT_US);
+  queue.Push(queuePin, QUEUE_PERIOD_US, QUEUE_DUTY16, TRUE);
+  fxPwmSim.Run((UINT64)F_CPU*(QUEUE_WAIT_US + 2*QUEUE_PERIOD_US)/1000000);
+  ProbeMark();
+  fxPwmSim.Run((UINT64)F_CPU*QUEUE_PERIOD_US/1000000*20);
+  //O Sync() marca o cursor fxPwm_MinTimerDelta depois de agora.
+  printf("queue %u  run %u  first_set %u us  first_meas %.2f us  period_set %u us  period_meas %.1f us\n", queuePin,
+    queue.IsEmpty(), QUEUE_WAIT_US + fxPwm_MinTimerDelta,
+    (probe.rises==0)?(0.0):((double)(probe.firstRise - queueStart)/CPU_PER_US), QUEUE_PERIOD_US, ProbePeriodUs());
+  fxPwm.DisablePin(queuePin);
+  fxPwm.SetQueue(NULL);
+#else
+  UINT32 isrCount = fxPwmSim.isrCount;
+  UINT64 isrCycles = fxPwmSim.isrCycles;
+  UINT64 isrHostNs = fxPwmSim.isrHostNs;
+  UINT64 cycles = fxPwmSim.cycles;
+#endif
+
+  printf("\nisr_count      %u\n", isrCount);
+  printf("isr_cpu_load   %.2f %%\n", 100.0*(double)isrCycles/(double)cycles);
+  printf("isr_host_ns    %.1f per call\n", (isrCount==0)?(0.0):((double)isrHostNs/isrCount));
+
+#if defined(fxPwm_STATS) && !defined(fxPwmSim_STATIC)
+  //Estatísticas medidas pela própria biblioteca, em ciclos do timer.
+  printf("\nstats_isr      %u\n", st.isrCount);
+  printf("stats_edges    %u\n", st.edgeCount);
+  printf("max_duration   %u clk\n", st.maxDuration);
+  printf("max_lateness   %u clk\n", st.maxLateness);
+  printf("deadline_hits  %u\n", st.deadlineHits);
+  printf("delta_clamps   %u\n", st.deltaClamps);
+  printf("lateness_clk   edges\n");
+  for(t=0;t<fxPwm_StatsBins;t++){
+    if(t+1<fxPwm_StatsBins){
+      printf("%5u..%-6u  %u\n", fxPwm_T1::GetStatsBinStart(t), fxPwm_T1::GetStatsBinStart(t+1)-1, st.lateness[t]);
+    }else{
+      printf("%5u..       %u\n", fxPwm_T1::GetStatsBinStart(t), st.lateness[t]);
+    }
+  }
+#endif
+
+  return 0;
+}
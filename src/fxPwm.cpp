@@ -11,22 +11,30 @@
  *  17-07-2018: primeira documentação
  *  21-07-2018: modificações maiores na estrutura da biblioteca. Melhoria de desempenho.
  *  25-07-2018: substituição de malloc() por new[] e de free() por delete[]. Destrutor.
+ *  17-10-2026: acesso ao hardware pela camada de abstração (fxPwm_Hal.h), permitindo simulação no host.
+ *  17-10-2026: bordas no mesmo registrador PORTx escritas de uma vez por passada.
+ *  17-10-2026: funções inteiras de período e ciclo de trabalho. FLOAT opcional (fxPwm_NO_FLOAT).
+ *  17-10-2026: interrupção desviada para o fxPwmStatic que tomar o TIMER1.
+ *  17-10-2026: comparações de tempo pela diferença com sinal: o clockCount de 32 bits pode dar a volta.
+ *  17-10-2026: estatísticas do Tick() (fxPwm_STATS).
+ *  17-10-2026: escalonamento de fase das portas que começam a modular (SetStagger).
+ *  17-10-2026: grupos de pinos travados (fxPwm_LockGroup) executados pelo Tick() como uma porta só.
+ *  17-10-2026: modo de densidade de pulsos (PDM): todas as portas PDM decidem o nível no mesmo passo do Tick().
+ *  17-10-2026: registradores do timer pela tabela de timers (fxPwm_HAL_Timer), com uma interrupção por timer.
+ *  17-10-2026: portas repartidas entre motores em timers diferentes (AddShard). Escritas em PORTx atômicas.
+ *  17-10-2026: portas passadas para o PWM por hardware do pino quando o período bate (HwAccepts).
+ *  17-10-2026: trajetórias do ciclo de trabalho avançadas pelo ProcessEdge() no início do período.
+ *  17-10-2026: fila de comandos com hora marcada executada pelo Tick() (TickQueue).
+ *  17-10-2026: modo fatiado (fxPwm_SliceBudget): orçamento verificado a cada porta, passada retomada na próxima chamada.
+ *  17-10-2026: portas do RegisterPort(pin) tiradas do pool estático (fxPwm_T1::pool), e devolvidas a ele.
+ *  17-10-2026: tabelas alocadas fora da seção sem interrupções, ou dadas por um fxPwm_Storage (Attach()).
+ *  17-10-2026: no modo fatiado, o passo do PDM e os comandos da fila também respeitam o orçamento.
  */
 
 #include <fxPwmTypes.h>
 #include <fxPwm.h>
 #include <fxPwm_Port.h>
-#include <avr/interrupt.h>
-#include "arduino.h"
-
-
-#ifndef fxPwm_SaveSREG
-#define fxPwm_SaveSREG() BYTE sreg_saved = SREG
-#endif
-
-#ifndef fxPwm_RestoreSREG
-#define fxPwm_RestoreSREG() SREG = sreg_saved
-#endif
+#include <fxPwm_Hal.h>
 
 #define fxPwm_CLEAR_BITS(value,mask)    (value&(~mask)) 
 #define fxPwm_SET_BITS(value,mask)      (value|mask)
@@ -41,21 +49,149 @@ UINT16  fxPwm_T1::minTimerDelta     = 0;
 UINT16  fxPwm_T1::maxTimerDuration  = 0;
 UINT16  fxPwm_T1::maxTimerPeriod    = 0;
 UINT8   fxPwm_T1::prescaler         = 0;
+void (* volatile fxPwm_T1::timerOwner)(void) = NULL;
+fxPwm_T1 * volatile fxPwm_T1::engines[fxPwm_TIMERS] = {NULL, NULL, NULL, NULL};
+#if fxPwm_PortPoolSize>0
+//Depois do fxPwm: as portas do pool são destruídas antes dele.
+fxPwm_Port fxPwm_T1::pool[fxPwm_PortPoolSize];
+#endif
+
+//Registradores de cada timer, na ordem de fxPwm_TIMER1, fxPwm_TIMER3, fxPwm_TIMER4 e fxPwm_TIMER5.
+static const fxPwm_HAL_Timer fxPwm_timers[fxPwm_TIMERS] = {
+  fxPwm_HAL_TIMER(1),
+#if defined(TCNT3) && !defined(fxPwm_NO_EXTRA_TIMERS)
+  fxPwm_HAL_TIMER(3),
+#else
+  fxPwm_HAL_NO_TIMER,
+#endif
+#if defined(TCNT4) && !defined(fxPwm_NO_EXTRA_TIMERS)
+  fxPwm_HAL_TIMER(4),
+#else
+  fxPwm_HAL_NO_TIMER,
+#endif
+#if defined(TCNT5) && !defined(fxPwm_NO_EXTRA_TIMERS)
+  fxPwm_HAL_TIMER(5),
+#else
+  fxPwm_HAL_NO_TIMER,
+#endif
+};
 
 //===============================================================
 //Métodos internos.
 //===============================================================
 
+//No modo fatiado as interrupções dos motores bloqueiam: a duração delas é limitada pelo orçamento.
+#ifdef fxPwm_SliceBudget
+#define fxPwm_ISR_FLAGS ISR_BLOCK
+#else
+#define fxPwm_ISR_FLAGS ISR_NOBLOCK
+#endif
+
 //Interrupt
-ISR(TIMER1_COMPB_vect , ISR_NOBLOCK){
-  fxPwm.Tick();
+ISR(TIMER1_COMPB_vect , fxPwm_ISR_FLAGS){
+  if(fxPwm_T1::timerOwner!=NULL){
+    //TIMER1 tomado por um fxPwmStatic.
+    fxPwm_T1::timerOwner();
+    return;
+  }
+  fxPwm_T1 *engine = fxPwm_T1::engines[fxPwm_TIMER1];
+  if(engine!=NULL){
+    engine->Tick();
+  }
+}
+
+//Interrupções dos outros timers, cada uma com seu motor.
+//Como a do TIMER1, não bloqueiam (fora do modo fatiado): a interrupção de um timer pode entrar no meio da de outro.
+#if defined(TCNT3) && !defined(fxPwm_NO_EXTRA_TIMERS)
+ISR(TIMER3_COMPB_vect , fxPwm_ISR_FLAGS){
+  fxPwm_T1 *engine = fxPwm_T1::engines[fxPwm_TIMER3];
+  if(engine!=NULL){
+    engine->Tick();
+  }
+}
+#endif
+
+#if defined(TCNT4) && !defined(fxPwm_NO_EXTRA_TIMERS)
+ISR(TIMER4_COMPB_vect , fxPwm_ISR_FLAGS){
+  fxPwm_T1 *engine = fxPwm_T1::engines[fxPwm_TIMER4];
+  if(engine!=NULL){
+    engine->Tick();
+  }
+}
+#endif
+
+#if defined(TCNT5) && !defined(fxPwm_NO_EXTRA_TIMERS)
+ISR(TIMER5_COMPB_vect , fxPwm_ISR_FLAGS){
+  fxPwm_T1 *engine = fxPwm_T1::engines[fxPwm_TIMER5];
+  if(engine!=NULL){
+    engine->Tick();
+  }
 }
+#endif
 
 //Limpa todos itens e pré-calcula alguns valores específicos.
 void fxPwm_T1::Cleanup(){
   this->maxPorts = 0;
+  this->ownTables = FALSE;
   this->ports = NULL;
-  this->allocatedPins = NULL;
+  this->numPorts = 0;
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  this->heap = NULL;
+  this->heapSize = 0;
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->frames[0] = NULL;
+  this->frames[1] = NULL;
+  this->frameLength[0] = 0;
+  this->frameLength[1] = 0;
+  this->frameFront = 0;
+  this->frameIndex = 0;
+  this->frameCompare = 0;
+  this->frameWait = 0;
+  this->frameActive = FALSE;
+  this->frameSwap = FALSE;
+  this->frameDirty = FALSE;
+#endif
+
+  //Sem lote aberto.
+  this->batchDepth = 0;
+  //Sem escalonamento de fase.
+  this->stagger = FALSE;
+  //Sem fila de comandos.
+  this->queue = NULL;
+#if defined(fxPwm_SliceBudget) && fxPwm_Scheduler!=fxPwm_SCHEDULER_HEAP
+  //Sem passada cortada.
+  this->sliceIndex = NULL;
+#endif
+#ifdef fxPwm_SliceBudget
+  //Sem passo do PDM cortado.
+  this->pdmSlice = NULL;
+#endif
+
+#ifdef fxPwm_STATS
+  this->ResetStats();
+#endif
+
+  //Tabela de pinos vazia.
+  UINT16 p;
+  for(p=0;p<fxPwm_PinTableSize;p++){
+    this->pinTable[p] = 0xFF;
+  }
+
+  //Grupos de registradores.
+  UINT8 t;
+  this->numGroups = 0;
+  for(t=0;t<fxPwm_MaxPortGroups;t++){
+    this->groups[t].port = NULL;
+    this->groups[t].setMask = 0x00;
+    this->groups[t].clearMask = 0x00;
+  }
+
+  //Sem motores acrescentados.
+  this->numShards = 0;
+  for(t=0;t<fxPwm_MaxShards;t++){
+    this->shards[t] = NULL;
+  }
 
   this->lastClock = 0;
   this->clockCount = 0;
@@ -104,12 +240,26 @@ void fxPwm_T1::Cleanup(){
   temp = (TIME_CLOCK)((UINT64)fxPwm_MaxTimerDuration*1000)/nsPerTimerClock;
   maxTimerDuration = (UINT16)((temp>fxPwm_MaxTimerClkSum)?(fxPwm_MaxTimerClkSum):(temp));
 
+#ifdef fxPwm_SliceBudget
+  //No modo fatiado o deadline é o orçamento da fatia, se for menor.
+  temp = (TIME_CLOCK)((UINT64)fxPwm_SliceBudget*1000)/nsPerTimerClock;
+  maxTimerDuration = (temp<maxTimerDuration)?((UINT16)temp):(maxTimerDuration);
+#endif
+
   temp = (TIME_CLOCK)((UINT64)fxPwm_MaxTimerPeriod*1000)/nsPerTimerClock;
   maxTimerPeriod = (UINT16)((temp>fxPwm_MaxTimerClkSum)?(fxPwm_MaxTimerClkSum):(temp));
 
   temp = (TIME_CLOCK)((UINT64)fxPwm_MinTimerDelta*1000)/nsPerTimerClock;
   minTimerDelta = (UINT16)((temp>fxPwm_MaxTimerClkSum)?(fxPwm_MaxTimerClkSum):(temp));
 
+  //Sem portas PDM.
+  this->pdmPorts = NULL;
+  this->pdmNext = 0;
+#ifdef fxPwm_SliceBudget
+  this->pdmSlice = NULL;
+#endif
+  this->SetPdmPeriod(fxPwm_PdmPeriod);
+
   return;
 }
 
@@ -120,41 +270,44 @@ void fxPwm_T1::ConfigureTimer(){
 
   //Escrever todos registros.
 
-  //TCCR1A:
+  //TCCRxA:
   //Não mexer com OC1A e OC1B:  0b0000xxxx
   //Modo normal:                0bxxxxxx00
-  TCCR1A = fxPwm_CLEAR_BITS(TCCR1A, 0b11110011);
+  *this->hw->tccra = fxPwm_CLEAR_BITS(*this->hw->tccra, 0b11110011);
 
-  //TCCR1B:
+  //TCCRxB:
   //Sem cancelamento de ruído:  0b0xxxxxxx
   //Sem detecção de borda:      0bx0xxxxxx
   //Modo normal:                0bxxx00xxx
   //Clock desligado:            0bxxxxx000
-  TCCR1B = fxPwm_CLEAR_BITS(TCCR1B, 0b11011111);
+  *this->hw->tccrb = fxPwm_CLEAR_BITS(*this->hw->tccrb, 0b11011111);
 
-  //TCCR1C:
-  TCCR1B = fxPwm_CLEAR_BITS(TCCR1B, 0b11000000);
+  //TCCRxC:
+  *this->hw->tccrb = fxPwm_CLEAR_BITS(*this->hw->tccrb, 0b11000000);
 
-  //TCNT1: contagem atual
-  TCNT1 = 1;
+  //TCNTx: contagem atual
+  *this->hw->tcnt = 1;
 
-  //ICR1: não usado.
-  ICR1 = 0;
+  //ICRx: não usado.
+  *this->hw->icr = 0;
 
-  //OCR1A: comparado constantemente com TCNT1 para disparar interrupção. Não usado.
-  OCR1A = 0;
+  //OCRxA: comparado constantemente com TCNTx para disparar interrupção. Não usado.
+  *this->hw->ocra = 0;
 
-  //OCR1B: o mesmo que OCR1A, mas usado.
-  OCR1B = 0;
+  //OCRxB: o mesmo que OCRxA, mas usado.
+  *this->hw->ocrb = 0;
 
-  //TIMSK1: 
-  //Habilitar OCIEB:  0bxxxxx1xx (interrupção quando OCR1B=TCNT1)
+  //TIMSKx: 
+  //Habilitar OCIEB:  0bxxxxx1xx (interrupção quando OCRxB=TCNTx)
   //Limpar ICIE, OCIEA E TOIE: 0bxx0xxx00
-  TIMSK1 = fxPwm_CLEAR_BITS(TIMSK1, 0b00100011);
-  TIMSK1 = fxPwm_SET_BITS(TIMSK1, 0b00000100);
+  *this->hw->timsk = fxPwm_CLEAR_BITS(*this->hw->timsk, 0b00100011);
+  *this->hw->timsk = fxPwm_SET_BITS(*this->hw->timsk, 0b00000100);
+
+  //TIFRx: flags de interrupção. Limpar todas: 0bxx0xx000
+  *this->hw->tifr = fxPwm_CLEAR_BITS(*this->hw->timsk, 0b00100111);
 
-  //TIFR1: flags de interrupção. Limpar todas: 0bxx0xx000
-  TIFR1 = fxPwm_CLEAR_BITS(TIMSK1, 0b00100111);
+  //A interrupção do timer passa a chamar este motor.
+  engines[this->timer] = this;
   
   //Timer configurado.
   fxPwm_RestoreSREG();
@@ -162,25 +315,25 @@ void fxPwm_T1::ConfigureTimer(){
   return;
 }
 
-//Inicia o temporizador escrevendo os bits do pré-escalar no TCCR1B.
+//Inicia o temporizador escrevendo os bits do pré-escalar no TCCRxB.
 void fxPwm_T1::StartTimer(){
   fxPwm_SaveSREG();cli();
   
-  //Escrever em TCCR1B os bits do pré-escalar calculado.
-  TCCR1B = fxPwm_CLEAR_BITS(TCCR1B, 0b00000111);
-  TCCR1B = fxPwm_SET_BITS(TCCR1B, fxPwm_CLEAR_BITS(prescaler, 0b11111000));
+  //Escrever em TCCRxB os bits do pré-escalar calculado.
+  *this->hw->tccrb = fxPwm_CLEAR_BITS(*this->hw->tccrb, 0b00000111);
+  *this->hw->tccrb = fxPwm_SET_BITS(*this->hw->tccrb, fxPwm_CLEAR_BITS(prescaler, 0b11111000));
 
   fxPwm_RestoreSREG();
 
   return;
 }
 
-//Para o temporizador limpando os bits do pré-escalar no TCCR1B.
+//Para o temporizador limpando os bits do pré-escalar no TCCRxB.
 void fxPwm_T1::StopTimer(){
   fxPwm_SaveSREG();cli();
   
-  //Escrever em TCCR1B bits 0 no pré-escalar.
-  TCCR1B = fxPwm_CLEAR_BITS(TCCR1B, 0b00000111);
+  //Escrever em TCCRxB bits 0 no pré-escalar.
+  *this->hw->tccrb = fxPwm_CLEAR_BITS(*this->hw->tccrb, 0b00000111);
 
   fxPwm_RestoreSREG();
 
@@ -192,15 +345,15 @@ void fxPwm_T1::StopTimer(){
 //Se clockCount vier primeiro, clockCount é agendado.
 void fxPwm_T1::SetNextFireMin(TIME_CLOCK clockCount){
   fxPwm_SaveSREG();cli();
-  if(clockCount<=this->clockCount){
+  if(fxPwm_TIME_REACHED(this->clockCount, clockCount)){
     //Muito em cima da hora.
-    OCR1B = TCNT1 + 1;
+    *this->hw->ocrb = *this->hw->tcnt + 1;
   }else{
     //Calcular diferença atual e a próxima e decidir pela menor.
-    TIME_CLOCK currentDif = (OCR1B==TCNT1)?(65536):((TIME_CLOCK)(OCR1B - TCNT1));
+    TIME_CLOCK currentDif = (*this->hw->ocrb==*this->hw->tcnt)?(65536):((TIME_CLOCK)(UINT16)(*this->hw->ocrb - *this->hw->tcnt));
     TIME_CLOCK newDif = clockCount - this->clockCount;
     if(newDif<currentDif){
-      OCR1B = TCNT1 + (UINT16)((newDif==0)?(1):(newDif));
+      *this->hw->ocrb = *this->hw->tcnt + (UINT16)((newDif==0)?(1):(newDif));
     }
   }
   fxPwm_RestoreSREG();
@@ -208,8 +361,154 @@ void fxPwm_T1::SetNextFireMin(TIME_CLOCK clockCount){
   return;
 }
 
-//Limpar na instância.
+//Reposiciona uma porta cujo próximo evento mudou, sem reprogramar o OCRxB.
+//No agendador por heap, a porta é reposicionada no heap.
+//Retorna FALSE se o OCRxB pertence à tabela do agendador FRAME.
+BOOL fxPwm_T1::Requeue(fxPwm_Port *port){
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_SCAN
+  //No SCAN a porta é achada na próxima passada, nada a fazer.
+  (void)port;
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //A tabela precisa ser recompilada (em UpdateFrame()).
+  this->frameDirty = TRUE;
+  if(port->enabled==FALSE){
+    //Porta desabilitada sai da tabela em execução imediatamente.
+    if(port->lockGroup!=NULL){
+      UINT8 t;
+      for(t=0;t<port->lockGroup->numPins;t++){
+        this->FrameForget(port->lockGroup->pins[t].port, port->lockGroup->pins[t].mask);
+      }
+    }else{
+      this->FrameForget(port->port, port->mask);
+    }
+  }
+  if(this->frameActive!=FALSE){
+    //O OCRxB pertence à tabela.
+    return FALSE;
+  }
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  if(port->heapIndex!=0xFF){
+    //A chave pode ter subido ou descido; apenas um dos dois vai mover a porta.
+    this->HeapSiftUp(port->heapIndex);
+    this->HeapSiftDown(port->heapIndex);
+  }
+#endif
+
+  return TRUE;
+}
+
+//Reagenda uma porta cujo próximo evento mudou.
+void fxPwm_T1::Reschedule(fxPwm_Port *port){
+  if(this->Requeue(port)!=FALSE && port->scheduled!=FALSE){
+    this->SetNextFireMin(port->next);
+  }
+
+  return;
+}
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+
+//Indica se o próximo evento de a vem antes do de b.
+//Portas sem evento agendado ficam depois de todas as outras.
+inline BOOL fxPwm_T1::EventBefore(fxPwm_Port *a, fxPwm_Port *b){
+  if(a->scheduled==FALSE){
+    return FALSE;
+  }
+  return (b->scheduled==FALSE || fxPwm_TIME_BEFORE(a->next, b->next))?(TRUE):(FALSE);
+}
+
+//Sobe uma porta enquanto seu próximo evento for anterior ao do pai.
+void fxPwm_T1::HeapSiftUp(UINT8 index){
+  fxPwm_Port *port = this->heap[index];
+  while(index>0){
+    UINT8 parent = (index-1)>>1;
+    if(this->EventBefore(port, this->heap[parent])==FALSE){
+      break;
+    }
+    fxPwm_HAL_Cycles(10);
+    this->heap[index] = this->heap[parent];
+    this->heap[index]->heapIndex = index;
+    index = parent;
+  }
+  this->heap[index] = port;
+  port->heapIndex = index;
+
+  return;
+}
+
+//Desce uma porta enquanto algum filho tiver próximo evento anterior ao dela.
+void fxPwm_T1::HeapSiftDown(UINT8 index){
+  fxPwm_Port *port = this->heap[index];
+  UINT16 child;
+  while((child = ((UINT16)index<<1)+1)<this->heapSize){
+    //Escolher o filho com evento mais próximo.
+    if(child+1<this->heapSize && this->EventBefore(this->heap[child+1], this->heap[child])!=FALSE){
+      child++;
+    }
+    if(this->EventBefore(this->heap[child], port)==FALSE){
+      break;
+    }
+    fxPwm_HAL_Cycles(14);
+    this->heap[index] = this->heap[child];
+    this->heap[index]->heapIndex = index;
+    index = (UINT8)child;
+  }
+  this->heap[index] = port;
+  port->heapIndex = index;
+
+  return;
+}
+
+//Insere uma porta no fim do heap e sobe até sua posição.
+void fxPwm_T1::HeapInsert(fxPwm_Port *port){
+  if(this->heapSize>=this->maxPorts || port->heapIndex!=0xFF){
+    return;
+  }
+  this->heap[this->heapSize] = port;
+  port->heapIndex = this->heapSize;
+  this->heapSize++;
+  this->HeapSiftUp(port->heapIndex);
+
+  return;
+}
+
+//Retira uma porta do heap, colocando o último elemento em seu lugar.
+void fxPwm_T1::HeapRemove(fxPwm_Port *port){
+  UINT8 index = port->heapIndex;
+  if(index==0xFF || index>=this->heapSize){
+    return;
+  }
+  port->heapIndex = 0xFF;
+  this->heapSize--;
+  if(index<this->heapSize){
+    fxPwm_Port *moved = this->heap[this->heapSize];
+    this->heap[index] = moved;
+    moved->heapIndex = index;
+    this->HeapSiftUp(index);
+    this->HeapSiftDown(moved->heapIndex);
+  }
+  this->heap[this->heapSize] = NULL;
+
+  return;
+}
+
+#endif
+
+//Limpar na instância. Motor no TIMER1.
 fxPwm_T1::fxPwm_T1(){
+  this->timer = fxPwm_TIMER1;
+  this->hw = &fxPwm_timers[fxPwm_TIMER1];
+  this->Cleanup();
+
+  return;
+}
+
+//Motor em outro timer. Sem registradores se o timer não existir.
+fxPwm_T1::fxPwm_T1(UINT8 timer){
+  this->timer = (timer<fxPwm_TIMERS)?(timer):(fxPwm_TIMER1);
+  this->hw = (timer<fxPwm_TIMERS && fxPwm_timers[timer].tcnt!=NULL)?(&fxPwm_timers[timer]):(NULL);
   this->Cleanup();
 
   return;
@@ -223,343 +522,1715 @@ fxPwm_T1::~fxPwm_T1(){
 }
 
 BOOL fxPwm_T1::IsAllocated(){
-  return (this->maxPorts>0 && this->ports!=NULL && this->allocatedPins)?(TRUE):(FALSE);
+  return (this->maxPorts>0 && this->ports!=NULL)?(TRUE):(FALSE);
+}
+
+//Converte microssegundos em ciclos do timer, somando meio ciclo para arredondar.
+UINT32 fxPwm_T1::MicrosToClk(TIME_US micros){
+  return (UINT32)(((UINT64)micros*1000 + nsPerTimerClock/2)/(UINT64)nsPerTimerClock);
+}
+
+//Converte ciclos do timer em microssegundos, somando meio microssegundo para arredondar.
+TIME_US fxPwm_T1::ClkToMicros(TIME_CLOCK clk){
+  return (TIME_US)(((UINT64)clk*(UINT64)nsPerTimerClock + 500)/(UINT64)1000);
+}
+
+//Compara o período pedido com o período fixo do PWM por hardware do pino, em ciclos do timer.
+BOOL fxPwm_T1::HwAccepts(fxPwm_Port *port, UINT32 periodClk, UINT16 duty16){
+#ifndef fxPwm_HW_PWM
+  (void)port;
+  (void)periodClk;
+  (void)duty16;
+  return FALSE;
+#else
+  if(periodClk==0 || port->index==0xFF || port->pdm!=FALSE || port->lockGroup!=NULL || port->trajectory!=NULL || port->glide!=NULL || port->engine->queue!=NULL || port->pinNumber==0xFF){
+    return FALSE;
+  }
+  UINT8 timer = fxPwm_HAL_HwPwmTimer(port->pinNumber);
+  //TIMER3, 4 e 5 ficam com o motor que os usar (fxPwm_TIMER3 = 1, e assim por diante).
+  if(timer==0xFF || (timer>=3 && engines[timer-2]!=NULL)){
+    return FALSE;
+  }
+  //O ciclo de trabalho não pode perder resolução sem aviso ao ir para os 8 bits do hardware.
+  UINT16 hwDuty16 = fxPwm_HW_DUTY16(fxPwm_HW_DUTY8(duty16));
+  if(((hwDuty16>duty16)?(hwDuty16 - duty16):(duty16 - hwDuty16))>fxPwm_HwDutyTolerance){
+    return FALSE;
+  }
+  UINT32 hwClk = (UINT32)(((UINT64)fxPwm_HAL_HwPwmCycles(timer)*1000000000/F_CPU + nsPerTimerClock/2)/nsPerTimerClock);
+  UINT32 error = (periodClk>hwClk)?(periodClk - hwClk):(hwClk - periodClk);
+  return (error<=hwClk && error*1000<=hwClk*fxPwm_HwTolerance)?(TRUE):(FALSE);
+#endif
 }
 
 //===============================================================
 //Um método muito importante.
 //===============================================================
 
-//Realiza o processamento da modulação PWM.
-//Essa função precisa executar tão rápida quanto possível.
-void fxPwm_T1::Tick(){
-  //Adquirir rapidamente condições inicais.
-  UINT16 lastTCNT1 = TCNT1;
-  this->clockCount += (TIME_CLOCK)(lastTCNT1 - lastClock);
-  this->lastClock = lastTCNT1;
+//Retorna o grupo de um registrador. Se ainda não existir, cria um.
+//Retorna 0xFF se não houver registrador ou se não houver mais grupos livres.
+UINT8 fxPwm_T1::GroupPort(volatile BYTE *port){
+  if(port==NULL){
+    return 0xFF;
+  }
 
-  //Deadline de execução dessa função. Para evitar que se perca eternamente aqui.
-  TIME_CLOCK deadline = this->clockCount + maxTimerDuration;
-  //Próximo evento previsto.
-  TIME_CLOCK next;
+  UINT8 t;
+  for(t=0;t<this->numGroups;t++){
+    if(this->groups[t].port==port){
+      return t;
+    }
+  }
 
-  //Alguns ponteiros.
-  fxPwm_Port* currentPort;
-  fxPwm_Port** portIndex;
-  
-  do{
-    //Adquirir novos valores de tempo.
-    lastTCNT1 = TCNT1;
-    this->clockCount += (TIME_CLOCK)(lastTCNT1 - lastClock);
-    this->lastClock = lastTCNT1;
-    next=this->clockCount+maxTimerPeriod;
-    //Restaura ponteiro para início da lista de portas.
-    portIndex = ports;
+  if(this->numGroups>=fxPwm_MaxPortGroups){
+    //Sem espaço. A porta vai ser escrita diretamente.
+    return 0xFF;
+  }
 
-    //Percorre a lista de portas e processa eventos agendados em cada uma.
-    //Para quando encontrar um elemento NULL na lista.
-    while((currentPort = *portIndex++)!=NULL){
-      if(currentPort->enabled==FALSE){
-        //Pula elemento se não estiver habilitado.
-        continue;
+  this->groups[t].port = port;
+  this->groups[t].setMask = 0x00;
+  this->groups[t].clearMask = 0x00;
+  this->numGroups++;
+
+  return t;
+}
+
+//Acumula bits a setar e a limpar no grupo de um registrador.
+//A última mudança de um bit na passada é a que vale.
+inline void fxPwm_T1::QueueBits(volatile BYTE *port, UINT8 *group, BYTE setMask, BYTE clearMask){
+  UINT8 index = *group;
+  if(index==0xFF){
+    if(this->numGroups<fxPwm_MaxPortGroups){
+      //Ainda não tinha registrador quando foi registrada.
+      index = *group = this->GroupPort(port);
+    }
+  }else if(index>=this->numGroups || this->groups[index].port!=port){
+    //O registrador mudou desde o registro.
+    index = *group = this->GroupPort(port);
+  }
+
+  if(index==0xFF){
+    //Sem grupo. Escrever agora mesmo.
+    fxPwm_HAL_WriteBits(port, setMask, clearMask);
+    return;
+  }
+
+  fxPwm_PortGroup *portGroup = &this->groups[index];
+  portGroup->setMask = (portGroup->setMask & ~clearMask) | setMask;
+  portGroup->clearMask = (portGroup->clearMask & ~setMask) | clearMask;
+
+  return;
+}
+
+//Acumula o novo nível de uma porta no grupo do seu registrador.
+inline void fxPwm_T1::QueueLevel(fxPwm_Port *port, BYTE level){
+  if(level){
+    this->QueueBits(port->port, &port->group, port->mask, 0x00);
+  }else{
+    this->QueueBits(port->port, &port->group, 0x00, port->mask);
+  }
+
+  return;
+}
+
+//Escreve os bits acumulados numa única leitura-modificação-escrita por registrador.
+//Pinos do mesmo registrador que vencem juntos mudam no mesmo instante.
+inline void fxPwm_T1::FlushGroups(){
+  fxPwm_PortGroup *group = this->groups;
+  fxPwm_PortGroup *end = this->groups + this->numGroups;
+  for(;group<end;group++){
+    if((group->setMask | group->clearMask)==0x00){
+      continue;
+    }
+    fxPwm_HAL_Cycles(10);
+    fxPwm_HAL_WriteBits(group->port, group->setMask, group->clearMask);
+    group->setMask = 0x00;
+    group->clearMask = 0x00;
+  }
+
+  return;
+}
+
+//Avança a trajetória um passo, em ponto fixo 16.16, e divide o período atual com o valor novo.
+//Valores que não mudam também são aplicados: assim o período pedido depois vale com o ciclo de trabalho da trajetória.
+inline void fxPwm_T1::StepTrajectory(fxPwm_Port *port){
+  fxPwm_Trajectory *trajectory = port->trajectory;
+  UINT32 value = trajectory->value;
+
+  switch(trajectory->mode){
+    case fxPwm_TRAJECTORY_RAMP:
+      fxPwm_HAL_Cycles(16);
+      if(trajectory->remaining>0){
+        trajectory->remaining--;
+        //O último passo cai exatamente no alvo.
+        value = (trajectory->remaining==0)?(trajectory->target):(value + (UINT32)trajectory->step);
       }
-      //Verifica se está na hora do próximo evento.
-      if(this->clockCount>=currentPort->next){
-        //Verifica se está em nível ALTO (para trocar para BAIXO), e se o período BAIXO é >0.
-        if(currentPort->outHint && currentPort->lowPeriod>0){
-          //Está em nível ALTO. Trocar para nível BAIXO.
-          *currentPort->port &= ~currentPort->mask;
-          //Calcular próxima chamada.
-          currentPort->next+=currentPort->lowPeriod;
-          currentPort->outHint = 0x00;
-        }else if(currentPort->highPeriod>0){
-          //Está em nível BAIXO. Trocar para ALTO, se o período ALTO é >0.
-          *currentPort->port |= currentPort->mask;
-          currentPort->next+=currentPort->highPeriod;
-          currentPort->outHint = 0xFF;
-        }
-        //A motivação dessa estrutura é permitir ciclos de trabalhos 0% verdadeiro e 100% verdadeiro.
+      break;
+    case fxPwm_TRAJECTORY_APPROACH:{
+      fxPwm_HAL_Cycles(24);
+      //Anda 1/2^shift da distância. Quando o passo zera, falta menos de um passo: vai direto ao alvo.
+      UINT32 delta;
+      if(value<trajectory->target){
+        delta = (trajectory->target - value)>>trajectory->shift;
+        value = (delta==0)?(trajectory->target):(value + delta);
+      }else if(value>trajectory->target){
+        delta = (value - trajectory->target)>>trajectory->shift;
+        value = (delta==0)?(trajectory->target):(value - delta);
       }
-      //Obtém próximo evento.
-      next = (currentPort->next<next)?(currentPort->next):(next);
+      break;
+    }
+    case fxPwm_TRAJECTORY_TABLE:{
+      fxPwm_HAL_Cycles(48);
+      //Índice nos bits mais altos da fase, e interpolação linear pelos 16 bits seguintes.
+      UINT8 bits = trajectory->tableBits;
+      UINT16 index = (UINT16)(trajectory->phase>>(32 - bits));
+      UINT16 fraction = (UINT16)(trajectory->phase>>(16 - bits));
+      INT32 a = fxPwm_HAL_ReadTable16(trajectory->table + index);
+      INT32 b = fxPwm_HAL_ReadTable16(trajectory->table + ((index + 1) & ((1UL<<bits) - 1)));
+      value = (UINT32)(a + (((b - a)*(INT32)(fraction>>1))>>15))<<16;
+      trajectory->phase += trajectory->increment;
+      break;
     }
+    default:
+      break;
+  }
+  trajectory->value = value;
 
-    //Sai do laço em duas condições:
-    //Se a fenda até o próximo evento por grande o suficiente OU
-    //Se der o deadline.
-  }while(clockCount>next-minTimerGap && clockCount<deadline);
+  fxPwm_HAL_Cycles(32);
+  UINT32 period = port->highPeriod + port->lowPeriod;
+  UINT16 duty16 = (UINT16)(value>>16);
+  port->highPeriod = fxPwm_DUTY_CLK(period, duty16);
+  port->lowPeriod = period - port->highPeriod;
 
-  //Agendar próxima chamada.
+  return;
+}
 
-  //Calcular tempo pela última vez.
-  lastTCNT1 = TCNT1;
-  this->clockCount += (TIME_CLOCK)(lastTCNT1 - lastClock);
-  this->lastClock = lastTCNT1;
+//Divide o período atual da varredura com o ciclo de trabalho, e calcula o próximo período em ponto fixo 24.8.
+//Ao passar do período final, a varredura para nele, ou recomeça do inicial (chirp).
+inline void fxPwm_T1::StepGlide(fxPwm_Port *port){
+  fxPwm_Glide *glide = port->glide;
+  if(glide->mode==fxPwm_GLIDE_NONE){
+    return;
+  }
+  UINT32 current = glide->period;
+
+  if(glide->done==FALSE){
+    //Com os períodos limitados a fxPwm_GLIDE_MAX_CLK, as somas cabem em 31 bits com sinal.
+    INT32 next;
+    if(glide->mode==fxPwm_GLIDE_LINEAR){
+      fxPwm_HAL_Cycles(16);
+      next = (INT32)current + glide->step;
+    }else{
+      //Multiplicação 32x32 com resultado de 64 bits.
+      fxPwm_HAL_Cycles(120);
+      next = (INT32)current + (INT32)(((INT64)current*glide->rate)>>31);
+    }
+    if((glide->end>glide->start)?(next>=(INT32)glide->end):(next<=(INT32)glide->end)){
+      //Passou do período final.
+      if(glide->repeat!=FALSE){
+        next = (INT32)glide->start;
+      }else{
+        next = (INT32)glide->end;
+        glide->done = TRUE;
+      }
+    }
+    glide->period = (UINT32)next;
+  }
 
-  //Garantir que a próxima chamada ocorra não antes que minTimerDelta do tempo atual.
-  //Se isso não for feito, coisas estranhas acontecem... (estouro de pilha?)
-  if(next<this->clockCount+minTimerDelta){
-    OCR1B = lastTCNT1 + minTimerDelta;
+  fxPwm_HAL_Cycles(32);
+  UINT32 period = current>>8;
+  port->highPeriod = fxPwm_DUTY_CLK(period, glide->duty16);
+  port->lowPeriod = period - port->highPeriod;
+
+  return;
+}
+
+//Troca o nível de uma porta cujo evento venceu e calcula seu próximo evento.
+//A escrita no registrador fica acumulada no grupo até o FlushGroups().
+//A motivação dessa estrutura é permitir ciclos de trabalhos 0% verdadeiro e 100% verdadeiro.
+inline void fxPwm_T1::ProcessEdge(fxPwm_Port *port){
+  fxPwm_HAL_Cycles(24);
+  if(port->lockGroup!=NULL){
+    //Porta de um grupo travado.
+    this->ProcessLockEdge(port);
+    return;
+  }
+  //Verifica se está em nível ALTO (para trocar para BAIXO), e se o período BAIXO é >0.
+  if(port->outHint && port->lowPeriod>0){
+    //Está em nível ALTO. Trocar para nível BAIXO.
+    this->QueueLevel(port, LOW);
+    //Calcular próxima chamada.
+    port->next+=port->lowPeriod;
+    port->outHint = 0x00;
+    return;
+  }
+
+  //Início de um período. Se houver períodos novos completos, aplicá-los agora,
+  //para que nenhum pulso seja cortado no meio.
+  //Dentro de um lote, nada é aplicado: o EndUpdate() aplica tudo de uma vez.
+  UINT8 seq = port->shadowSeq;
+  if(seq!=port->latchedSeq && (seq&1)==0 && this->batchDepth==0){
+    fxPwm_HAL_Cycles(12);
+    port->highPeriod = port->shadowHigh;
+    port->lowPeriod = port->shadowLow;
+    port->latchedSeq = seq;
+  }
+  if(port->glide!=NULL){
+    //O período vem da varredura.
+    this->StepGlide(port);
+  }
+  if(port->trajectory!=NULL){
+    //O ciclo de trabalho do período vem da trajetória, já com o período novo.
+    this->StepTrajectory(port);
+  }
+
+  if(port->highPeriod>0){
+    //Trocar para ALTO, se o período ALTO é >0.
+    this->QueueLevel(port, HIGH);
+    port->next+=port->highPeriod;
+    port->outHint = 0xFF;
   }else{
-    OCR1B = lastTCNT1 + (next - this->clockCount);
+    //Ciclo de 0%: o nível fica BAIXO (pode ter vindo de 100%), mas o evento precisa andar, senão vence para sempre.
+    this->QueueLevel(port, LOW);
+    port->outHint = 0x00;
+    port->next+=port->lowPeriod;
   }
 
   return;
 }
 
-//===============================================================
-//Métodos de inicialização e liberação.
-//===============================================================
+//Executa todas as escritas do instante atual na tabela de um grupo travado.
+//Se a tabela acabou, começa o próximo período, trocando de tabela se houver uma nova.
+//O espaço até a próxima escrita nunca é encurtado: se esta saiu atrasada, a próxima sai atrasada
+//do mesmo tanto, dentro do período. Assim o tempo morto entre saídas complementares sempre é respeitado.
+inline void fxPwm_T1::ProcessLockEdge(fxPwm_Port *port){
+  fxPwm_LockGroup *lock = port->lockGroup;
+  fxPwm_LockEdge *edges = lock->edges[lock->front];
+  UINT8 length = lock->length[lock->front];
+  UINT8 index = lock->edgeIndex;
+  UINT32 offset = edges[index].offset;
+  TIME_CLOCK scheduled = lock->origin + offset;
 
-//Inicializa usando a definição de fxPwm_MaxPorts.
-void fxPwm_T1::Initialize(){
-  this->Initialize(fxPwm_MaxPorts);
+  do{
+    fxPwm_HAL_Cycles(8);
+    this->QueueBits(edges[index].port, &edges[index].group, edges[index].setMask, edges[index].clearMask);
+    index++;
+  }while(index<length && edges[index].offset==offset);
+
+  if(index>=length){
+    //Fim do período.
+    lock->origin += lock->period[lock->front];
+    index = 0;
+    //Uma tabela nova vazia (período 0) é aplicada por quem a compilou, não aqui.
+    if(lock->swap!=FALSE && this->batchDepth==0 && lock->length[lock->front^1]>0){
+      lock->front ^= 1;
+      lock->swap = FALSE;
+      edges = lock->edges[lock->front];
+    }
+  }
+  lock->edgeIndex = index;
+
+  TIME_CLOCK due = lock->origin + edges[index].offset;
+  TIME_CLOCK spaced = this->clockCount + (due - scheduled);
+  port->next = (fxPwm_TIME_BEFORE(due, spaced))?(spaced):(due);
 
   return;
 }
 
-//Inicializa a classe definindo um número máximo de portas alocáveis.
-void fxPwm_T1::Initialize(UINT8 maxPorts){
-  fxPwm_SaveSREG();cli();
+#ifdef fxPwm_SliceBudget
+//Compara o tempo gasto desde o início da chamada do Tick() com o orçamento da fatia.
+inline BOOL fxPwm_T1::SliceSpent(){
+  return ((UINT16)(*this->hw->tcnt - this->sliceStart)>=maxTimerDuration)?(TRUE):(FALSE);
+}
+#endif
 
-  //Verificar se existe algo de antes.
-  //Se tiver, limpar.
-  if(this->IsAllocated()!=FALSE){
-    this->Free();
-  }else{
-    //Realizar limpeza preventiva de qualquer jeito.
-    Cleanup();
+//Passo do PDM: acumulador de primeira ordem (sigma-delta) em cada porta PDM habilitada.
+//A saída fica ALTA nos passos em que o acumulador passa de fxPwm_DUTY16_MAX, o que dá a média
+//duty16/fxPwm_DUTY16_MAX com o erro sempre menor que um passo. Só as portas que mudam de nível são escritas.
+inline BOOL fxPwm_T1::TickPdm(){
+  fxPwm_Port *port = this->pdmPorts;
+  UINT32 sum;
+
+#ifdef fxPwm_SliceBudget
+  if(this->pdmSlice!=NULL){
+    //Continuar o passo cortado pela fatia anterior, já contado na estatística.
+    port = this->pdmSlice;
+    this->pdmSlice = NULL;
+  }
+#ifdef fxPwm_STATS
+  else{
+    this->StatsEdge((UINT32)(this->clockCount - this->pdmNext));
+  }
+#endif
+  fxPwm_Port *first = port;
+#elif defined(fxPwm_STATS)
+  this->StatsEdge((UINT32)(this->clockCount - this->pdmNext));
+#endif
+  for(;port!=NULL;port=port->pdmNextPort){
+    fxPwm_HAL_Cycles(16);
+#ifdef fxPwm_SliceBudget
+    //Fim da fatia: o passo continua desta porta na próxima chamada, e o pdmNext fica vencido até lá.
+    if(port!=first && this->SliceSpent()!=FALSE){
+      this->pdmSlice = port;
+      return TRUE;
+    }
+#endif
+    if(port->enabled==FALSE || port->port==NULL){
+      continue;
+    }
+    sum = (UINT32)port->pdmAccumulator + port->pdmDuty;
+    if(sum>=fxPwm_DUTY16_MAX){
+      port->pdmAccumulator = (UINT16)(sum - fxPwm_DUTY16_MAX);
+      if(port->outHint==0x00){
+        this->QueueLevel(port, HIGH);
+        port->outHint = 0xFF;
+      }
+    }else{
+      port->pdmAccumulator = (UINT16)sum;
+      if(port->outHint!=0x00){
+        this->QueueLevel(port, LOW);
+        port->outHint = 0x00;
+      }
+    }
+  }
+
+  //Passo fixo. Se o Tick() atrasou mais que um passo, recomeçar a contagem a partir de agora.
+  this->pdmNext += this->pdmPeriod;
+  if(fxPwm_TIME_REACHED(this->clockCount, this->pdmNext)){
+    this->pdmNext = this->clockCount + this->pdmPeriod;
+  }
+
+  return FALSE;
+}
+
+//Executa os comandos da fila cuja hora chegou, na ordem em que foram colocados.
+//Só o head é escrito aqui: o programa continua colocando comandos no tail enquanto isso.
+inline BOOL fxPwm_T1::TickQueue(){
+  fxPwm_Queue *queue = this->queue;
+  UINT8 head = queue->head;
+
+  fxPwm_HAL_Cycles(8);
+  while(head!=queue->tail && fxPwm_TIME_REACHED(this->clockCount, queue->commands[head].at)){
+#ifdef fxPwm_STATS
+    this->StatsEdge((UINT32)(this->clockCount - queue->commands[head].at));
+#endif
+    this->RunCommand(&queue->commands[head]);
+    head = fxPwm_Queue::Next(head);
+    queue->head = head;
+#ifdef fxPwm_SliceBudget
+    //Fim da fatia: os comandos restantes ficam no head para a próxima chamada.
+    fxPwm_HAL_Cycles(4);
+    if(this->SliceSpent()!=FALSE && head!=queue->tail && fxPwm_TIME_REACHED(this->clockCount, queue->commands[head].at)){
+      return TRUE;
+    }
+#endif
+  }
+
+  return FALSE;
+}
+
+//Como o EndUpdate() faz com uma porta do lote, mas no instante do comando.
+//A escrita no registrador fica acumulada no grupo até o FlushGroups(), e a primeira borda do período
+//novo é atendida na mesma passada.
+inline void fxPwm_T1::RunCommand(fxPwm_Command *command){
+  fxPwm_Port *port = command->port;
+  if(port==NULL){
+    //Porta removida antes da hora.
+    return;
+  }
+
+  fxPwm_HAL_Cycles(48);
+  if(command->enable==FALSE){
+    this->QueueLevel(port, LOW);
+    port->outHint = 0x00;
+    port->enabled = FALSE;
+    port->next = fxPwm_NO_NEXT_EVENT;
+    port->scheduled = FALSE;
+    this->Requeue(port);
+    return;
+  }
+
+  UINT32 periodClk = command->periodClk;
+  UINT16 duty16 = command->duty16;
+  port->periodClk = periodClk;
+  port->duty16 = duty16;
+  port->highPeriod = fxPwm_DUTY_CLK(periodClk, duty16);
+  port->lowPeriod = periodClk - port->highPeriod;
+  port->shadowHigh = port->highPeriod;
+  port->shadowLow = port->lowPeriod;
+  port->latchedSeq = port->shadowSeq;
+  if(port->glide!=NULL){
+    port->glide->duty16 = duty16;
+  }
+  if(port->enabled==FALSE){
+    //Modo de saída, em nível BAIXO até a primeira borda.
+    *port->ddr |= port->mask;
+    this->QueueLevel(port, LOW);
+    port->outHint = 0x00;
+    port->enabled = TRUE;
+  }
+
+  if(port->pdm!=FALSE){
+    //Porta PDM: só o ciclo de trabalho, a partir do próximo passo.
+    port->pdmDuty = duty16;
+    return;
+  }
+  if(periodClk==0){
+    //Sem período: nível fixo de acordo com o duty.
+    port->next = fxPwm_NO_NEXT_EVENT;
+    port->scheduled = FALSE;
+    port->outHint = (duty16>fxPwm_DUTY16_MAX/2)?(0xFF):(0x00);
+    this->QueueLevel(port, port->outHint);
+  }else{
+    //Começo de período no instante do comando, ou agora se ele atrasou mais de um período.
+    port->next = (fxPwm_TIME_DIFF(this->clockCount, command->at)<(TIME_CLOCK_DIFF)periodClk)?(command->at):(this->clockCount);
+    port->scheduled = TRUE;
+    port->outHint = 0x00;
+  }
+  this->Requeue(port);
+
+  return;
+}
+
+#ifdef fxPwm_STATS
+//Conta uma borda atendida no histograma de atraso.
+//A faixa é a quantidade de bits significativos do atraso, limitada à última.
+void fxPwm_T1::StatsEdge(UINT32 lateness){
+  fxPwm_HAL_Cycles(20);
+  UINT8 bin = 0;
+  UINT32 value = lateness;
+  while(value!=0 && bin<fxPwm_StatsBins-1){
+    value >>= 1;
+    bin++;
+  }
+  this->stats.lateness[bin]++;
+  this->stats.edgeCount++;
+  if(lateness>this->stats.maxLateness){
+    this->stats.maxLateness = lateness;
+  }
+
+  return;
+}
+
+//Conta a duração de uma chamada do Tick().
+void fxPwm_T1::StatsDuration(UINT16 start){
+  UINT16 duration = (UINT16)(*this->hw->tcnt - start);
+  if(duration>this->stats.maxDuration){
+    this->stats.maxDuration = duration;
+  }
+
+  return;
+}
+#endif
+
+//Realiza o processamento da modulação PWM.
+//Essa função precisa executar tão rápida quanto possível.
+void fxPwm_T1::Tick(){
+#ifdef fxPwm_STATS
+  UINT16 statsStart = *this->hw->tcnt;
+  this->stats.isrCount++;
+#endif
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  if(this->frameActive!=FALSE || this->frameSwap!=FALSE){
+    //Tabela compilada em uso.
+    this->TickFrame();
+#ifdef fxPwm_STATS
+    this->StatsDuration(statsStart);
+#endif
+    return;
+  }
+#endif
+
+  //Adquirir rapidamente condições inicais.
+  UINT16 lastTCNT1 = *this->hw->tcnt;
+  this->clockCount += (TIME_CLOCK)(UINT16)(lastTCNT1 - lastClock);
+  this->lastClock = lastTCNT1;
+
+  //Deadline de execução dessa função. Para evitar que se perca eternamente aqui.
+  TIME_CLOCK deadline = this->clockCount + maxTimerDuration;
+  //Próximo evento previsto.
+  TIME_CLOCK next;
+
+  //Alguns ponteiros.
+  fxPwm_Port* currentPort;
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_HEAP
+  fxPwm_Port** portIndex;
+#else
+  //Bordas que ainda podem ser atendidas na passada.
+  UINT8 edgeBudget;
+#endif
+#ifdef fxPwm_SliceBudget
+  //Início da fatia, e se ela acabou no meio de uma passada.
+  this->sliceStart = lastTCNT1;
+  BOOL sliceCut = FALSE;
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_HEAP
+  BOOL sliceResumed;
+  fxPwm_Port **sliceFirst;
+#endif
+#endif
+  
+  do{
+    //Adquirir novos valores de tempo.
+    lastTCNT1 = *this->hw->tcnt;
+    this->clockCount += (TIME_CLOCK)(UINT16)(lastTCNT1 - lastClock);
+    this->lastClock = lastTCNT1;
+    next=this->clockCount+maxTimerPeriod;
+
+    //Passo das portas PDM. As escritas saem no FlushGroups() junto com as bordas da passada.
+    if(this->pdmPorts!=NULL){
+      if(fxPwm_TIME_REACHED(this->clockCount, this->pdmNext)){
+#ifdef fxPwm_SliceBudget
+        sliceCut = this->TickPdm();
+#else
+        this->TickPdm();
+#endif
+      }
+      if(fxPwm_TIME_BEFORE(this->pdmNext, next)){
+        next = this->pdmNext;
+      }
+    }
+#ifdef fxPwm_SliceBudget
+    if(sliceCut!=FALSE){
+      //Fatia gasta no passo do PDM: a fila e as portas esperam a próxima chamada.
+      this->FlushGroups();
+      next = this->clockCount;
+      break;
+    }
+#endif
+
+    //Comandos da fila, antes das bordas: uma porta que recomeça agora já é atendida nesta passada.
+    if(this->queue!=NULL){
+#ifdef fxPwm_SliceBudget
+      sliceCut = this->TickQueue();
+#else
+      this->TickQueue();
+#endif
+      if(this->queue->head!=this->queue->tail && fxPwm_TIME_BEFORE(this->queue->commands[this->queue->head].at, next)){
+        next = this->queue->commands[this->queue->head].at;
+      }
+    }
+#ifdef fxPwm_SliceBudget
+    if(sliceCut!=FALSE){
+      //Fatia gasta nos comandos da fila: as portas esperam a próxima chamada.
+      this->FlushGroups();
+      next = this->clockCount;
+      break;
+    }
+#endif
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+    //Somente as portas vencidas são tocadas. Elas estão sempre no topo do heap.
+    //No máximo heapSize bordas por passada, como no SCAN: sob sobrecarga as portas atrasadas
+    //continuam vencidas, e sem esse limite o deadline nunca seria verificado.
+    edgeBudget = this->heapSize;
+    while(edgeBudget>0 && (currentPort = this->heap[0])->scheduled!=FALSE && fxPwm_TIME_REACHED(this->clockCount, currentPort->next)){
+#ifdef fxPwm_STATS
+      this->StatsEdge((UINT32)(this->clockCount - currentPort->next));
+#endif
+      this->ProcessEdge(currentPort);
+      this->HeapSiftDown(0);
+      edgeBudget--;
+#ifdef fxPwm_SliceBudget
+      //Fim da fatia: as portas vencidas continuam no topo para a próxima chamada.
+      fxPwm_HAL_Cycles(4);
+      if(this->SliceSpent()!=FALSE){
+        sliceCut = TRUE;
+        break;
+      }
+#endif
+    }
+    this->FlushGroups();
+
+    //O próximo evento é o do topo.
+    if(this->heapSize>0 && this->heap[0]->scheduled!=FALSE && fxPwm_TIME_BEFORE(this->heap[0]->next, next)){
+      next = this->heap[0]->next;
+    }
+#else
+    //Restaura ponteiro para início da lista de portas.
+    portIndex = ports;
+#ifdef fxPwm_SliceBudget
+    //Ou continua a passada cortada pela fatia anterior.
+    sliceResumed = (this->sliceIndex!=NULL)?(TRUE):(FALSE);
+    if(sliceResumed!=FALSE){
+      portIndex = this->sliceIndex;
+      this->sliceIndex = NULL;
+    }
+    sliceFirst = portIndex;
+#endif
+
+    //Percorre a lista de portas e processa eventos agendados em cada uma.
+    //Para quando encontrar um elemento NULL na lista.
+    while((currentPort = *portIndex++)!=NULL){
+      fxPwm_HAL_Cycles(12);
+#ifdef fxPwm_SliceBudget
+      //Fim da fatia, verificado também nas portas sem evento: a próxima chamada continua desta porta.
+      fxPwm_HAL_Cycles(4);
+      if(portIndex-1!=sliceFirst && this->SliceSpent()!=FALSE){
+        this->sliceIndex = portIndex-1;
+        sliceCut = TRUE;
+        break;
+      }
+#endif
+      if(currentPort->scheduled==FALSE){
+        //Pula elemento se não estiver habilitado ou não tiver evento.
+        continue;
+      }
+      //Verifica se está na hora do próximo evento.
+      if(fxPwm_TIME_REACHED(this->clockCount, currentPort->next)){
+#ifdef fxPwm_STATS
+        this->StatsEdge((UINT32)(this->clockCount - currentPort->next));
+#endif
+        this->ProcessEdge(currentPort);
+      }
+      //Obtém próximo evento.
+      next = (fxPwm_TIME_BEFORE(currentPort->next, next))?(currentPort->next):(next);
+    }
+    this->FlushGroups();
+#ifdef fxPwm_SliceBudget
+    if(sliceCut!=FALSE || sliceResumed!=FALSE){
+      //Passada incompleta: next não viu todas as portas. Chamar de novo logo, ou fazer uma passada inteira.
+      next = this->clockCount;
+    }
+#endif
+#endif
+
+#ifdef fxPwm_SliceBudget
+    if(sliceCut!=FALSE){
+      break;
+    }
+#endif
+
+    //Sai do laço em duas condições:
+    //Se a fenda até o próximo evento por grande o suficiente OU
+    //Se der o deadline.
+  }while(fxPwm_TIME_DIFF(this->clockCount, next-minTimerGap)>0 && fxPwm_TIME_BEFORE(this->clockCount, deadline));
+
+#ifdef fxPwm_STATS
+  if(fxPwm_TIME_BEFORE(this->clockCount, deadline)==FALSE){
+    //Saiu pelo deadline, com bordas ainda dentro da fenda.
+    this->stats.deadlineHits++;
+  }
+#ifdef fxPwm_SliceBudget
+  else if(sliceCut!=FALSE){
+    //Fatia cortada no meio da passada.
+    this->stats.deadlineHits++;
+  }
+#endif
+#endif
+
+  //Agendar próxima chamada.
+
+  //Calcular tempo pela última vez.
+  lastTCNT1 = *this->hw->tcnt;
+  this->clockCount += (TIME_CLOCK)(UINT16)(lastTCNT1 - lastClock);
+  this->lastClock = lastTCNT1;
+
+  //Garantir que a próxima chamada ocorra não antes que minTimerDelta do tempo atual.
+  //Se isso não for feito, coisas estranhas acontecem... (estouro de pilha?)
+  if(fxPwm_TIME_BEFORE(next, this->clockCount+minTimerDelta)){
+    *this->hw->ocrb = lastTCNT1 + minTimerDelta;
+#ifdef fxPwm_STATS
+    this->stats.deltaClamps++;
+#endif
+  }else{
+    *this->hw->ocrb = lastTCNT1 + (next - this->clockCount);
+  }
+
+#ifdef fxPwm_STATS
+  this->StatsDuration(statsStart);
+#endif
+
+  return;
+}
+
+//===============================================================
+//Métodos de inicialização e liberação.
+//===============================================================
+
+#ifndef fxPwm_NO_HEAP
+//Inicializa usando a definição de fxPwm_MaxPorts.
+void fxPwm_T1::Initialize(){
+  this->Initialize(fxPwm_MaxPorts);
+
+  return;
+}
+
+//Inicializa a classe definindo um número máximo de portas alocáveis.
+void fxPwm_T1::Initialize(UINT8 maxPorts){
+  //Timer inexistente neste microcontrolador.
+  if(this->hw==NULL){
+    return;
+  }
+
+  //Alocar antes de desabilitar as interrupções: o new pode demorar.
+  //O new do Arduino retorna NULL quando falha, como se std::nothrow estivesse habilitado.
+  fxPwm_Port **ports = new fxPwm_Port*[maxPorts+1];
+  fxPwm_Port **heap = NULL;
+  fxPwm_FrameEntry *frame0 = NULL;
+  fxPwm_FrameEntry *frame1 = NULL;
+  BOOL failed = (ports==NULL)?(TRUE):(FALSE);
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  //Heap do agendador.
+  heap = new fxPwm_Port*[maxPorts];
+  failed = (heap==NULL)?(TRUE):(failed);
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Tabelas de bordas.
+  frame0 = new fxPwm_FrameEntry[fxPwm_FrameMaxEntries];
+  frame1 = new fxPwm_FrameEntry[fxPwm_FrameMaxEntries];
+  failed = (frame0==NULL || frame1==NULL)?(TRUE):(failed);
+#endif
+  if(failed!=FALSE){
+    //Falhou.
+    delete[] ports;
+    delete[] heap;
+    delete[] frame0;
+    delete[] frame1;
+    return;
+  }
+
+  this->Attach(maxPorts, ports, heap, frame0, frame1, TRUE);
+
+  return;
+}
+#endif
+
+void fxPwm_T1::Attach(UINT8 maxPorts, fxPwm_Port **ports, fxPwm_Port **heap, fxPwm_FrameEntry *frame0, fxPwm_FrameEntry *frame1, BOOL own){
+  //Timer inexistente neste microcontrolador.
+  if(this->hw==NULL){
+    return;
+  }
+
+  fxPwm_SaveSREG();cli();
+
+  //Verificar se existe algo de antes.
+  //Se tiver, limpar.
+  if(this->IsAllocated()!=FALSE){
+    this->Free();
+  }else{
+    //Realizar limpeza preventiva de qualquer jeito.
+    Cleanup();
+  }
+
+  this->ports = ports;
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  this->heap = heap;
+#else
+  (void)heap;
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->frames[0] = frame0;
+  this->frames[1] = frame1;
+#else
+  (void)frame0;
+  (void)frame1;
+#endif
+  this->ownTables = own;
+
+  //Salvar máximo de portas.
+  this->maxPorts = maxPorts;
+
+  //Passar limpando tudo.
+  UINT8 t;
+  for(t=0;t<this->maxPorts+1;t++){
+    this->ports[t] = NULL;
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+    if(t<this->maxPorts){
+      this->heap[t] = NULL;
+    }
+#endif
+  }
+
+  //Configurar o timer.
+  this->ConfigureTimer();
+
+  //Restaurar SREG e terminar.
+  fxPwm_RestoreSREG();
+  
+  return;
+}
+
+//Libera todos recursos.
+void fxPwm_T1::Free(){
+  if(this->IsAllocated()==FALSE){
+    //Não há portas alocadas. Apenas fazer uma limpeza.
+    Cleanup();
+    return;
+  }
+
+  fxPwm_SaveSREG();cli();
+
+  //Liberar todas portas, a partir da última, para que nada seja movido.
+  while(this->numPorts>0){
+    this->RemovePort(this->ports[this->numPorts-1]);
+  }
+
+  //Liberar memórias, se forem do Initialize(maxPorts). As de um fxPwm_Storage ficam com o programa.
+#ifndef fxPwm_NO_HEAP
+  if(this->ownTables!=FALSE){
+    delete[] ports;
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+    delete[] heap;
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+    delete[] frames[0];
+    delete[] frames[1];
+#endif
+  }
+#endif
+
+  //A fila fica sem motor.
+  if(this->queue!=NULL){
+    this->queue->engine = NULL;
+  }
+
+  //A interrupção do timer deixa de chamar este motor.
+  if(engines[this->timer]==this){
+    engines[this->timer] = NULL;
+  }
+
+  //Limpeza.
+  Cleanup();
+
+  fxPwm_RestoreSREG();
+  return;
+}
+
+//Inicia o timer e recalcula a fase de todos osciladores. Também inicia os motores acrescentados.
+void fxPwm_T1::Start(){
+  //Verifica realidade.
+  if(this->IsAllocated()==FALSE){
+    return;
+  }
+  
+  fxPwm_SaveSREG();cli();
+  
+  this->StartTimer();
+  
+  UINT8 t;
+  for(t=0;t<this->numPorts;t++){
+    ports[t]->ResetPhase();
+  }
+  if(this->pdmPorts!=NULL){
+    this->pdmNext = this->clockCount + this->pdmPeriod;
+    this->SetNextFireMin(this->pdmNext);
+  }
+
+  fxPwm_RestoreSREG();
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->UpdateFrame();
+#endif
+
+  for(t=0;t<this->numShards;t++){
+    this->shards[t]->Start();
+  }
+
+  return;
+}
+
+//Para o timer, e os dos motores acrescentados.
+void fxPwm_T1::Stop(){
+  this->StopTimer();
+
+  UINT8 t;
+  for(t=0;t<this->numShards;t++){
+    this->shards[t]->Stop();
+  }
+}
+
+//===============================================================
+//Funções de atualização em lote.
+//===============================================================
+
+//Começa (ou aninha) um lote de mudanças, também nos motores acrescentados.
+void fxPwm_T1::BeginUpdate(){
+  if(this->batchDepth<0xFF){
+    this->batchDepth++;
+  }
+
+  UINT8 t;
+  for(t=0;t<this->numShards;t++){
+    this->shards[t]->BeginUpdate();
+  }
+
+  return;
+}
+
+//Aplica todas as mudanças guardadas desde o BeginUpdate() mais externo.
+//As portas mudadas que estão modulando recomeçam o período no mesmo instante,
+//e por isso são tratadas na mesma passada do Tick(), com escritas juntadas por registrador.
+void fxPwm_T1::EndUpdate(){
+  if(this->batchDepth==0){
+    return;
+  }
+
+  //Cada motor acrescentado aplica as suas portas, no seu timer.
+  UINT8 shard;
+  for(shard=0;shard<this->numShards;shard++){
+    this->shards[shard]->EndUpdate();
+  }
+  if(this->batchDepth>1){
+    //Ainda dentro de um lote mais externo.
+    this->batchDepth--;
+    return;
+  }
+  if(this->IsAllocated()==FALSE){
+    this->batchDepth = 0;
+    return;
+  }
+
+  fxPwm_Port **portIndex;
+  fxPwm_Port *port;
+  BOOL reprogram = FALSE;
+
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_FRAME
+  //Fases das portas que vão começar, escolhidas antes de desabilitar interrupções.
+  //Cada porta considera as que já estão modulando e as anteriores do lote.
+  TIME_CLOCK ref = 0;
+  if(this->stagger!=FALSE){
+    {
+      fxPwm_SaveSREG();cli();
+      ref = this->clockCount;
+      fxPwm_RestoreSREG();
+    }
+    for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+      if(port->staged!=FALSE && port->enabled!=FALSE && port->pdm==FALSE && port->port!=NULL && port->ddr!=NULL && port->periodClk!=0){
+        port->phase = this->StaggerPhase(port, ref);
+      }
+    }
+  }
+#endif
+
+  fxPwm_SaveSREG();cli();
+  this->batchDepth = 0;
+
+  //O instante do lote fica um pouco no futuro, para dar tempo da interrupção começar
+  //e para que o primeiro período de cada porta não saia encurtado.
+  UINT16 lastTCNT1 = *this->hw->tcnt;
+  this->clockCount += (TIME_CLOCK)(UINT16)(lastTCNT1 - this->lastClock);
+  this->lastClock = lastTCNT1;
+  TIME_CLOCK now = this->clockCount + minTimerDelta;
+
+  for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+    if(port->staged==FALSE){
+      continue;
+    }
+    port->staged = FALSE;
+
+    if(port->pdm!=FALSE){
+      //Porta PDM: só o ciclo de trabalho, a partir do próximo passo.
+      port->pdmDuty = port->duty16;
+      continue;
+    }
+
+    if(port->lockGroup!=NULL){
+      //Grupo travado: recomeça o período agora, já com a última tabela.
+      if(port->enabled!=FALSE && port->lockGroup->Restart(now)!=FALSE){
+        reprogram = TRUE;
+      }
+      if(this->Requeue(port)==FALSE){
+        reprogram = FALSE;
+      }
+      continue;
+    }
+
+    //Valores novos entram direto, sem esperar o fim do período.
+    port->highPeriod = port->shadowHigh;
+    port->lowPeriod = port->shadowLow;
+    port->latchedSeq = port->shadowSeq;
+
+    if(port->enabled==FALSE || port->port==NULL || port->ddr==NULL){
+      port->next = fxPwm_NO_NEXT_EVENT;
+      port->scheduled = FALSE;
+    }else if(port->periodClk==0){
+      //Sem período: nível fixo de acordo com o duty.
+      port->next = fxPwm_NO_NEXT_EVENT;
+      port->scheduled = FALSE;
+      if(port->duty16>fxPwm_DUTY16_MAX/2){
+        *port->port |= port->mask;
+      }else{
+        *port->port &= ~port->mask;
+      }
+    }else{
+      //Começo de período agora, para todas as portas do lote.
+      port->next = now;
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_FRAME
+      if(this->stagger!=FALSE){
+        //Ou na fase escolhida. Até lá a saída fica em nível BAIXO.
+        port->next = StaggerNext(ref, port->phase, port->periodClk, now);
+        *port->port &= ~port->mask;
+      }
+#endif
+      port->scheduled = TRUE;
+      port->outHint = 0x00;
+      reprogram = TRUE;
+    }
+    if(this->Requeue(port)==FALSE){
+      reprogram = FALSE;
+    }
+  }
+
+  //Uma única reprogramação do timer para o lote inteiro.
+  //Com escalonamento, a primeira porta pode começar depois de now: a interrupção a mais só reagenda.
+  if(reprogram!=FALSE){
+    this->SetNextFireMin(now);
+  }
+  fxPwm_RestoreSREG();
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->UpdateFrame();
+#endif
+
+  return;
+}
+
+//===============================================================
+//Funções de escalonamento de fase.
+//===============================================================
+
+//Liga ou desliga o escalonamento. Só vale para as portas que começarem depois.
+void fxPwm_T1::SetStagger(BOOL stagger){
+  this->stagger = (stagger!=FALSE)?(TRUE):(FALSE);
+
+  return;
+}
+
+BOOL fxPwm_T1::GetStagger(){
+  return this->stagger;
+}
+
+//Insere um ponto na lista ordenada, se couber.
+static UINT8 fxPwm_StaggerInsert(UINT32 *points, UINT8 count, UINT32 point){
+  if(count>=fxPwm_StaggerMaxPoints){
+    return count;
+  }
+  UINT8 t = count;
+  while(t>0 && points[t-1]>point){
+    points[t] = points[t-1];
+    t--;
+  }
+  points[t] = point;
+
+  return count+1;
+}
+
+//Marca os eventos (subida e descida) de outra porta, de período other, subida em rise (contada de ref)
+//e período ALTO high, como pontos no período period. Só portas com período igual ou harmônico contam.
+static UINT8 fxPwm_StaggerAdd(UINT32 *points, UINT8 count, UINT32 period, UINT32 other, UINT32 rise, UINT32 high){
+  UINT32 t;
+  if(other>=period){
+    if(other!=period && other%period!=0){
+      return count;
+    }
+    //Com o mesmo período (caso mais comum), sem divisões.
+    rise = (other==period && rise<period)?(rise):(rise%period);
+    count = fxPwm_StaggerInsert(points, count, rise);
+    if(high>0 && high<other){
+      t = rise + high;
+      count = fxPwm_StaggerInsert(points, count, (other==period && t<2*period)?((t>=period)?(t - period):(t)):(t%period));
+    }
+    return count;
+  }
+  if(period%other!=0){
+    return count;
+  }
+  //Período da outra porta é submúltiplo: ela tem eventos várias vezes em period.
+  for(rise%=other;rise<period;rise+=other){
+    count = fxPwm_StaggerInsert(points, count, rise);
+    if(high>0 && high<other && rise+high<period){
+      count = fxPwm_StaggerInsert(points, count, rise + high);
+    }
+  }
+  if(high>0 && high<other && rise - other + high>=period){
+    //Descida da última subida que passa do fim do período.
+    count = fxPwm_StaggerInsert(points, count, rise - other + high - period);
+  }
+
+  return count;
+}
+
+//Conta os pontos próximos de x (a menos de space, sem coincidir) e os que coincidem com x.
+static UINT8 fxPwm_StaggerNear(const UINT32 *points, UINT8 count, UINT32 period, UINT32 x, UINT32 space, UINT8 *equal){
+  UINT8 t;
+  UINT8 near = 0;
+  UINT32 d;
+  for(t=0;t<count;t++){
+    d = (points[t]>x)?(points[t] - x):(x - points[t]);
+    d = (d>period/2)?(period - d):(d);
+    if(d==0){
+      (*equal)++;
+    }else if(d<space){
+      near++;
+    }
+  }
+
+  return near;
+}
+
+//Escolhe a fase de começo de uma porta, de 0 até periodClk-1 ciclos depois de ref.
+//Considera as portas modulando fora do lote e, no lote, as que ficam antes na lista (já com fase).
+//Sem outras portas com período igual ou harmônico, a fase é 0: a porta começa logo.
+//Eventos a menos de duas fendas (minTimerGap) um do outro deixam o Tick() esperando entre eles,
+//enquanto eventos no mesmo instante saem na mesma passada. Por isso a fase escolhida é, nessa ordem:
+//a que deixa menos eventos próximos da subida e da descida da porta, e a que coincide com menos eventos.
+//As candidatas são o meio do maior vão e as fases que fazem a subida ou a descida coincidir com um evento.
+UINT32 fxPwm_T1::StaggerPhase(fxPwm_Port *port, TIME_CLOCK ref){
+  UINT32 points[fxPwm_StaggerMaxPoints];
+  UINT8 count = 0;
+  UINT32 period = port->periodClk;
+  UINT32 high = port->shadowHigh;
+  fxPwm_Port **portIndex;
+  fxPwm_Port *other;
+
+  for(portIndex=this->ports;(other=*portIndex)!=NULL;portIndex++){
+    if(other==port || other->enabled==FALSE || other->pdm!=FALSE || other->periodClk==0){
+      continue;
+    }
+
+    if(other->staged!=FALSE){
+      //No lote: só as anteriores, que já têm fase.
+      if(other->index<port->index && other->port!=NULL && other->ddr!=NULL){
+        count = fxPwm_StaggerAdd(points, count, period, other->periodClk, other->phase, other->shadowHigh);
+      }
+      continue;
+    }
+
+    //Modulando: próxima subida, lida de uma vez com interrupções desabilitadas.
+    TIME_CLOCK rise;
+    UINT32 otherPeriod, otherHigh;
+    {
+      fxPwm_SaveSREG();cli();
+      if(other->scheduled==FALSE){
+        fxPwm_RestoreSREG();
+        continue;
+      }
+      rise = other->next + ((other->outHint!=0x00 && other->lowPeriod>0)?(other->lowPeriod):(0));
+      otherHigh = other->highPeriod;
+      otherPeriod = other->highPeriod + other->lowPeriod;
+      fxPwm_RestoreSREG();
+    }
+    if(otherPeriod==0){
+      continue;
+    }
+    //Subida atrasada (antes de ref) conta um período depois.
+    while(fxPwm_TIME_BEFORE(rise, ref)){
+      rise += otherPeriod;
+    }
+    count = fxPwm_StaggerAdd(points, count, period, otherPeriod, (UINT32)(rise - ref), otherHigh);
+  }
+
+  if(count==0){
+    return 0;
+  }
+
+  //Primeira candidata: meio do maior vão entre pontos consecutivos, contando a volta do último ao primeiro.
+  UINT8 t;
+  UINT32 gapStart = points[count-1];
+  UINT32 gap = points[0] + period - points[count-1];
+  for(t=1;t<count;t++){
+    if(points[t] - points[t-1] > gap){
+      gap = points[t] - points[t-1];
+      gapStart = points[t-1];
+    }
+  }
+  UINT32 candidate = gapStart + gap/2;
+  candidate = (candidate>=period)?(candidate - period):(candidate);
+
+  BOOL hasFall = (high>0 && high<period)?(TRUE):(FALSE);
+  UINT32 space = 2*(UINT32)minTimerGap;
+  UINT32 best = candidate;
+  UINT8 bestNear = 0xFF;
+  UINT8 bestEqual = 0xFF;
+  UINT8 near, equal;
+  UINT8 c;
+
+  //Candidatas: o meio do vão, depois cada ponto como subida e cada ponto como descida.
+  for(c=0;c<=2*count;c++){
+    if(c>0){
+      if(c<=count){
+        candidate = points[c-1];
+      }else if(hasFall!=FALSE){
+        candidate = points[c-1-count];
+        candidate = (candidate>=high)?(candidate - high):(candidate + period - high);
+      }else{
+        break;
+      }
+    }
+
+    equal = 0;
+    near = fxPwm_StaggerNear(points, count, period, candidate, space, &equal);
+    if(hasFall!=FALSE){
+      near += fxPwm_StaggerNear(points, count, period, (candidate + high>=period)?(candidate + high - period):(candidate + high), space, &equal);
+    }
+    if(near<bestNear || (near==bestNear && equal<bestEqual)){
+      bestNear = near;
+      bestEqual = equal;
+      best = candidate;
+    }
+  }
+
+  return best;
+}
+
+//Primeiro instante a partir de now em que a fase phase (contada de ref) se repete.
+TIME_CLOCK fxPwm_T1::StaggerNext(TIME_CLOCK ref, UINT32 phase, UINT32 period, TIME_CLOCK now){
+  TIME_CLOCK next = ref + phase;
+  if(fxPwm_TIME_BEFORE(next, now)){
+    UINT32 late = (UINT32)(now - next);
+    next += ((late + period - 1)/period)*period;
+  }
+
+  return next;
+}
+
+//===============================================================
+//Funções de manipulação de portas e pinos.
+//===============================================================
+
+//Coloca o pino de uma porta registrada na tabela de pinos.
+//Deve ser chamado com interrupções desabilitadas.
+void fxPwm_T1::MapPin(fxPwm_Port *port){
+  if(port->pinNumber<fxPwm_PinTableSize){
+    this->pinTable[port->pinNumber] = port->index;
+  }
+
+  return;
+}
+
+//Tira um pino da tabela de pinos, se ele pertencer à porta.
+//Deve ser chamado com interrupções desabilitadas.
+void fxPwm_T1::UnmapPin(UINT8 pin, fxPwm_Port *port){
+  if(pin<fxPwm_PinTableSize && this->pinTable[pin]==port->index){
+    this->pinTable[pin] = 0xFF;
+  }
+
+  return;
+}
+
+//Registra uma porta, colocando seu ponteiro no fim de uma lista estática.
+//A porta guarda a própria posição na lista, e o pino vai para a tabela de pinos.
+//Com motores acrescentados, a porta vai para o que tiver menos portas.
+fxPwm_Port *fxPwm_T1::RegisterPort(fxPwm_Port *port){
+  //Verifica realidade.
+  if(this->IsAllocated()==FALSE || port==NULL || port->index!=0xFF){
+    return NULL;
+  }
+
+  fxPwm_T1 *engine = this->PickShard();
+  if(engine!=this){
+    //O pino não pode estar registrado em nenhum motor.
+    if(port->pinNumber!=0xFF && this->GetPort(port->pinNumber)!=NULL){
+      return NULL;
+    }
+    return engine->RegisterPort(port);
+  }
+
+  //Verificar se o pino cabe na tabela e se já está registrado. Recusar se estiver.
+  if(port->pinNumber!=0xFF && (port->pinNumber>=fxPwm_PinTableSize || this->GetPort(port->pinNumber)!=NULL)){
+    return NULL;
+  }
+
+  //Verificar se chegou ao fim da lista. Se tiver chegado, recusar adição.
+  if(this->numPorts>=this->maxPorts){
+    return NULL;
+  }
+
+  fxPwm_SaveSREG();cli();
+  port->index = this->numPorts;
+  port->engine = this;
+  this->ports[this->numPorts] = port;
+  this->numPorts++;
+  this->MapPin(port);
+  port->group = this->GroupPort(port->port);
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  this->HeapInsert(port);
+#endif
+  if(port->pdm!=FALSE){
+    this->PdmLink(port);
+  }
+  fxPwm_RestoreSREG();
+
+  //Período atribuído antes do registro: pode ir para o PWM por hardware.
+  if(HwAccepts(port, port->periodClk, port->duty16)!=FALSE){
+    port->SetPeriodClkAndDuty16(port->periodClk, port->duty16);
+  }
+
+  return port;
+}
+
+
+//Registra uma porta a partir de um número de pino.
+//Para isso, ela aloca um objeto fxPwm_Port.
+fxPwm_Port *fxPwm_T1::RegisterPort(UINT8 pin){
+  //Verifica realidade.
+  if(this->IsAllocated()==FALSE || pin>=fxPwm_PinTableSize){
+    return NULL;
+  }
+  
+  //Recusar se a porta já foi registrada, se as listas estiverem cheias ou se o pino for inválido.
+  fxPwm_T1 *engine = this->PickShard();
+  if(this->GetPort(pin)!=NULL || engine->numPorts>=engine->maxPorts || digitalPinToPort(pin)==NOT_A_PIN){
+    return NULL;
+  }
+
+  //Procurar uma porta livre no pool.
+  fxPwm_Port *newPort = NULL;
+#if fxPwm_PortPoolSize>0
+  UINT8 t;
+  for(t=0;t<fxPwm_PortPoolSize;t++){
+    if(pool[t].internal==fxPwm_PORT_USER && pool[t].index==0xFF){
+      newPort = &pool[t];
+      newPort->internal = fxPwm_PORT_POOL;
+      break;
+    }
+  }
+#endif
+
+#ifdef fxPwm_NO_HEAP
+  if(newPort==NULL){
+    //Pool cheio, e sem heap.
+    return NULL;
+  }
+#else
+  if(newPort==NULL){
+    //Pool cheio: tentar alocar memória para a porta.
+    newPort = new fxPwm_Port;
+    if(newPort==NULL){
+      //Falha ao alocar.
+      return NULL;
+    }
+    //Marcar como alocada internamente, para ser desalocada na remoção.
+    newPort->internal = fxPwm_PORT_HEAP;
+  }
+#endif
+
+  //Atribuir pino.
+  newPort->SetPinNumber(pin);
+
+  //Registrar porta. Se não der, devolvê-la.
+  if(this->RegisterPort(newPort)==NULL){
+    if(newPort->internal==fxPwm_PORT_POOL){
+      newPort->Release();
+    }
+#ifndef fxPwm_NO_HEAP
+    else{
+      delete newPort;
+    }
+#endif
+    return NULL;
   }
 
-  //Tentar alocar lista de portas.
-  ports = new fxPwm_Port*[maxPorts+1];
-  //Verificar se funcionou, como se std::nothrow estive habilitado.
-  if(ports==NULL){
-    //Falhou.
-    fxPwm_RestoreSREG();
+  return newPort;
+}
+
+//Dado o ponteiro para uma porta, tenta removê-la.
+//A posição da porta na lista está nela mesma. A última porta da lista é movida para essa posição,
+//e o último elemento recebe NULL. Assim as interrupções ficam desabilitadas por um tempo curto e fixo.
+//Se o ponteiro representar um item alocado internamente, este é desalocado.
+void fxPwm_T1::RemovePort(fxPwm_Port *port){
+  if(port!=NULL && port->index!=0xFF && port->engine!=this){
+    //Registrada em outro motor (AddShard).
+    port->engine->RemovePort(port);
     return;
   }
 
-  //Tentar alocar lista de pinos.
-  allocatedPins = new UINT8[maxPorts];
-  if(allocatedPins==NULL){
-    delete[] ports;
-    fxPwm_RestoreSREG();
+  //Verificação de realidade.
+  if(this->IsAllocated()==FALSE || port==NULL || port->index>=this->numPorts || this->ports[port->index]!=port){
     return;
   }
 
-  //Salvar máximo de portas.
-  this->maxPorts = maxPorts;
+  if(port->hw!=FALSE){
+    //Fora do motor, o timer do pino para: a porta fica desabilitada.
+    port->HwRelease();
+  }
 
-  //Passar limpando tudo.
-  UINT8 t;
-  for(t=0;t<this->maxPorts+1;t++){
-    ports[t] = NULL;
-    if(t<this->maxPorts){
-      //Evitar que o último elemento seja limpo.
-      allocatedPins[t] = 0xFF;
+  fxPwm_SaveSREG();cli();
+
+  //Tirar o pino da tabela.
+  this->UnmapPin(port->pinNumber, port);
+
+  //Mover a última porta para o lugar da removida.
+  UINT8 t = port->index;
+  fxPwm_Port *last = this->ports[this->numPorts-1];
+  this->numPorts--;
+  this->ports[t] = last;
+  this->ports[this->numPorts] = NULL;
+  if(last!=port){
+    last->index = t;
+    this->MapPin(last);
+  }
+  port->index = 0xFF;
+  port->engine = &fxPwm;
+#if defined(fxPwm_SliceBudget) && fxPwm_Scheduler!=fxPwm_SCHEDULER_HEAP
+  //A lista mudou: a passada cortada recomeça do início.
+  this->sliceIndex = NULL;
+#endif
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  //Retirar do agendador.
+  this->HeapRemove(port);
+#endif
+  //Retirar do passo do PDM.
+  this->PdmUnlink(port);
+  //Os comandos pendentes da porta não são mais executados.
+  if(this->queue!=NULL){
+    for(t=this->queue->head;t!=this->queue->tail;t=fxPwm_Queue::Next(t)){
+      if(this->queue->commands[t].port==port){
+        this->queue->commands[t].port = NULL;
+      }
     }
   }
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //A tabela não pode mais escrever nessa porta.
+  this->frameDirty = TRUE;
+#endif
+  
+  fxPwm_RestoreSREG();
 
-  //Configurar o timer.
-  this->ConfigureTimer();
+  //Porta alocada internamente: devolver ao pool ou desalocar, já fora da lista.
+  if(port->internal==fxPwm_PORT_POOL){
+    port->Release();
+  }
+#ifndef fxPwm_NO_HEAP
+  else if(port->internal==fxPwm_PORT_HEAP){
+    delete port;
+  }
+#endif
 
-  //Restaurar SREG e terminar.
-  fxPwm_RestoreSREG();
-  
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->UpdateFrame();
+#endif
   return;
 }
 
-//Libera todos recursos.
-void fxPwm_T1::Free(){
-  if(this->IsAllocated()==FALSE){
-    //Não há portas alocadas. Apenas fazer uma limpeza.
-    Cleanup();
-    return;
-  }
+//Remove a porta a partir de um número de pino.
+void fxPwm_T1::RemovePort(UINT8 pin){
+  this->RemovePort(this->GetPort(pin));
+ 
+  return;
+}
 
-  fxPwm_SaveSREG();cli();
 
-  //Liberar todas portas.
-  UINT8 t;
-  for(t=0;t<this->maxPorts==0;t++){
-    this->RemovePort(this->ports[0]);
+//Registra um grupo travado pela sua porta sem pino.
+fxPwm_LockGroup *fxPwm_T1::RegisterGroup(fxPwm_LockGroup *group){
+  if(group==NULL || this->RegisterPort(&group->carrier)==NULL){
+    return NULL;
   }
 
-  //Liberar memórias.
-  delete[] ports;
-  delete[] allocatedPins;
+  return group;
+}
 
-  //Limpeza.
-  Cleanup();
+//Desabilita o grupo e tira sua porta da lista.
+void fxPwm_T1::RemoveGroup(fxPwm_LockGroup *group){
+  if(group==NULL || group->carrier.index==0xFF){
+    return;
+  }
+  group->Disable();
+  this->RemovePort(&group->carrier);
 
-  fxPwm_RestoreSREG();
   return;
 }
 
-//Inicia o TIMER1 e recalcula a fase de todos osciladores.
-void fxPwm_T1::Start(){
-  //Verifica realidade.
-  if(this->IsAllocated()==FALSE){
-    return;
+//===============================================================
+//Funções de repartição entre timers.
+//===============================================================
+
+//Acrescenta um motor em outro timer para receber parte das portas.
+//Ele não pode ter motores acrescentados: a repartição tem um nível só.
+BOOL fxPwm_T1::AddShard(fxPwm_T1 *engine){
+  if(engine==NULL || engine==this || engine->timer==this->timer || engine->numShards>0 || this->numShards>=fxPwm_MaxShards){
+    return FALSE;
   }
-  
-  fxPwm_SaveSREG();cli();
-  
-  this->StartTimer();
-  
+
   UINT8 t;
-  for(t=0;t<this->maxPorts;t++){
-    ports[t]->ResetPhase();
+  for(t=0;t<this->numShards;t++){
+    if(this->shards[t]==engine || this->shards[t]->timer==engine->timer){
+      return FALSE;
+    }
   }
 
-  fxPwm_RestoreSREG();
+  this->shards[this->numShards] = engine;
+  this->numShards++;
 
-  return;
+  return TRUE;
 }
 
-//Para o TIMER1.
-void fxPwm_T1::Stop(){
-  this->StopTimer();
+//Retorna a quantidade de motores acrescentados.
+UINT8 fxPwm_T1::GetNumShards(){
+  return this->numShards;
 }
 
-//===============================================================
-//Funções de manipulação de portas e pinos.
-//===============================================================
-
-//Registra uma porta, colocando seu ponteiro no fim de uma lista estática.
-void fxPwm_T1::RegisterPort(fxPwm_Port *port){
-  //Verifica realidade.
-  if(this->IsAllocated()==FALSE || port==NULL){
-    return;
+//Retorna um motor acrescentado, ou NULL se não existir.
+fxPwm_T1 *fxPwm_T1::GetShard(UINT8 index){
+  if(index>=this->numShards){
+    return NULL;
   }
 
-  UINT8 t;
+  return this->shards[index];
+}
 
-  //Verificar se o pino já está registrado. Recusar se estiver.
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]->pinNumber == port->pinNumber){
-      //Não aceitar alocar duas portas com mesmo valor de pino.
-      return;
+//Escolhe o motor com menos portas entre este e os acrescentados que estejam alocados e com espaço.
+//Em empate fica o primeiro, de modo que sem motores acrescentados tudo continua neste.
+fxPwm_T1 *fxPwm_T1::PickShard(){
+  fxPwm_T1 *best = this;
+  fxPwm_T1 *engine;
+  UINT8 t;
+  for(t=0;t<this->numShards;t++){
+    engine = this->shards[t];
+    if(engine->IsAllocated()==FALSE || engine->numPorts>=engine->maxPorts){
+      continue;
     }
-    if(this->ports[t]==NULL){
-      //Acabou a lista.
-      break;
+    if(best->numPorts>=best->maxPorts || engine->numPorts<best->numPorts){
+      best = engine;
     }
   }
 
-  //Verificar se chegou ao fim da lista. Se tiver chegado, recusar adição.
-  if(t!=this->maxPorts){
-    fxPwm_SaveSREG();cli();
-    this->ports[t] = port;
-    //Não precisa registrar o pino em allocatedPins, já que não há garantia que esse ponteiro foi alocado internamente.
-    fxPwm_RestoreSREG();
-  }
-
-  return;
+  return best;
 }
 
+//===============================================================
+//Funções do modo PDM.
+//===============================================================
 
-//Registra uma porta a partir de um número de pino.
-//Para isso, ela aloca um objeto fxPwm_Port.
-void fxPwm_T1::RegisterPort(UINT8 pin){
-  //Verifica realidade.
-  if(this->IsAllocated()==FALSE || pin==0xFF){
+//Acrescenta uma porta registrada à lista do PDM.
+//Se for a primeira, o passo começa a contar agora.
+void fxPwm_T1::PdmLink(fxPwm_Port *port){
+  if(port->index==0xFF){
+    //Não registrada: entra na lista no RegisterPort().
     return;
   }
-  
-  //Buscar se porta já foi registrada e recusar se tiver sido.
-  UINT8 t;
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]==NULL){
-      break;
-    }
-    if(this->ports[t]->pinNumber==pin){
-      //Já foi registado.
+  if(this->pdmPorts==NULL){
+    this->pdmNext = this->clockCount + this->pdmPeriod;
+    port->pdmNextPort = NULL;
+    this->pdmPorts = port;
+    this->SetNextFireMin(this->pdmNext);
+    return;
+  }
+  port->pdmNextPort = this->pdmPorts;
+  this->pdmPorts = port;
+
+  return;
+}
+
+//Tira uma porta da lista do PDM, se estiver nela.
+void fxPwm_T1::PdmUnlink(fxPwm_Port *port){
+  fxPwm_Port **link;
+  for(link=&this->pdmPorts;*link!=NULL;link=&(*link)->pdmNextPort){
+    if(*link==port){
+#ifdef fxPwm_SliceBudget
+      //O passo cortado continua da porta seguinte.
+      if(this->pdmSlice==port){
+        this->pdmSlice = port->pdmNextPort;
+        if(this->pdmSlice==NULL){
+          //Era a última porta do passo: ele terminou.
+          this->pdmNext += this->pdmPeriod;
+        }
+      }
+#endif
+      *link = port->pdmNextPort;
+      port->pdmNextPort = NULL;
       return;
     }
   }
 
-  //Verificar se porta é válida.
-  if(t==this->maxPorts || digitalPinToPort(pin)==NOT_A_PIN){
-    return;
-  }
+  return;
+}
 
-  //Tentar alocar memória para a porta.
-  fxPwm_Port *newPort = new fxPwm_Port;
-  if(newPort==NULL){
-    //Falha ao alocar.
-    return;
+//Atribui uma trajetória ao ciclo de trabalho de um dos pinos.
+void fxPwm_T1::SetTrajectory(UINT8 pin, fxPwm_Trajectory *trajectory){
+  fxPwm_Port *port = this->GetPort(pin);
+
+  if(port!=NULL){
+    port->SetTrajectory(trajectory);
   }
 
-  //Realizar limpeza da memória da porta e atribuir pino.
-  newPort->SetPinNumber(pin);
+  return;
+}
 
-  //Registrar porta.
-  this->RegisterPort(newPort);
+//Atribui uma varredura ao período de um dos pinos.
+void fxPwm_T1::SetGlide(UINT8 pin, fxPwm_Glide *glide){
+  fxPwm_Port *port = this->GetPort(pin);
 
-  //Colocar número do pino na lista de alocados internamente.
-  for(t=0;t<this->maxPorts;t++){
-    if(this->allocatedPins[t]==0xFF){
-      this->allocatedPins[t] = pin;
-      break;
-    }
+  if(port!=NULL){
+    port->SetGlide(glide);
   }
 
   return;
 }
 
-//Dado o ponteiro para uma porta, tenta removê-la.
-//A remoção e feita procurando o ponteiro na lista de portas.
-//Se encontrar, desloca todos elementos da frente para trás, e coloca NULL no último.
-//Se o ponteiro representar um item alocado internamente, este é desalocado.
-void fxPwm_T1::RemovePort(fxPwm_Port *port){
-  //Verificação de realidade.
-  if(this->IsAllocated()==FALSE || port==NULL){
+//Atribui a fila de comandos. As portas são reavaliadas: com fila, as do PWM por hardware voltam para o Tick();
+//sem, as que batem com o timer do pino podem ir para ele.
+void fxPwm_T1::SetQueue(fxPwm_Queue *queue){
+  if(queue==this->queue){
     return;
   }
+  if(queue!=NULL && queue->engine!=NULL){
+    //Sai do motor anterior.
+    queue->engine->SetQueue(NULL);
+  }
 
   fxPwm_SaveSREG();cli();
+  if(this->queue!=NULL){
+    this->queue->engine = NULL;
+  }
+  if(queue!=NULL){
+    queue->head = queue->tail;
+    queue->engine = this;
+  }
+  this->queue = queue;
+  fxPwm_RestoreSREG();
 
-  //Percorrer lista estática.
-  UINT8 t,u, portN;
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]==NULL){
-      //Chegou no último. Terminar.
-      break;
-    }
-    if(this->ports[t]==port){
-      //Encontrou item certo. Deslocar todos depois dele para trás.
-      for(u=t;u<this->maxPorts-1;u++){
-        this->ports[u] = this->ports[u+1];
-      }
-      //Colocar NULL no último e sair.
-      this->ports[this->maxPorts-1] = NULL;
-      break;
+  if(queue!=NULL){
+    queue->Sync();
+  }
+  UINT8 t;
+  for(t=0;t<this->numPorts;t++){
+    fxPwm_Port *port = this->ports[t];
+    if(port->hw!=FALSE || HwAccepts(port, port->periodClk, port->duty16)!=FALSE){
+      port->SetPeriodClkAndDuty16(port->periodClk, port->duty16);
     }
   }
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Os comandos são do Tick(), fora da tabela de bordas.
+  this->frameDirty = TRUE;
+  this->UpdateFrame();
+#endif
 
-  //Pesquisar se o número do pino está na lista de itens alocados internamente.
-  for(t=0;t<this->maxPorts;t++){
-    if(this->allocatedPins[t]==port->pinNumber){
-      //Porta foi alocada internamente. Desalocar e marcar.
-      delete port;
-      this->allocatedPins[t] = 0xFF;
-      break;
-    }
+  return;
+}
+
+fxPwm_Queue *fxPwm_T1::GetQueue(){
+  return this->queue;
+}
+
+//Liga ou desliga o modo PDM de um dos pinos.
+void fxPwm_T1::SetPdm(UINT8 pin, BOOL pdm){
+  fxPwm_Port *port = this->GetPort(pin);
+
+  if(port!=NULL){
+    port->SetPdm(pdm);
   }
-  
-  fxPwm_RestoreSREG();
+
   return;
 }
 
-//Remove a porta a partir de um número de pino.
-void fxPwm_T1::RemovePort(UINT8 pin){
-  this->RemovePort(this->GetPort(pin));
- 
+//Atribui o passo do PDM, limitado para que o Tick() possa sair entre dois passos.
+void fxPwm_T1::SetPdmPeriod(TIME_US period){
+  UINT32 clk = MicrosToClk(period);
+  UINT32 low = (UINT32)minTimerGap + minTimerDelta + 1;
+  clk = (clk<low)?(low):((clk>fxPwm_MaxTimerClkSum)?(fxPwm_MaxTimerClkSum):(clk));
+
+  fxPwm_SaveSREG();cli();
+  this->pdmPeriod = (UINT16)clk;
+  fxPwm_RestoreSREG();
+
   return;
 }
 
+//Retorna o passo do PDM, em microssegundos.
+TIME_US fxPwm_T1::GetPdmPeriod(){
+  return ClkToMicros(this->pdmPeriod);
+}
 
 //Atribui período a um dos pinos.
 void fxPwm_T1::SetPeriod(UINT8 pin, TIME_US period){
@@ -572,6 +2243,40 @@ void fxPwm_T1::SetPeriod(UINT8 pin, TIME_US period){
   return;
 }
 
+//Atribui período, em ciclos do timer, a um dos pinos.
+void fxPwm_T1::SetPeriodClk(UINT8 pin, UINT32 periodClk){
+  fxPwm_Port *port = this->GetPort(pin);
+
+  if(port!=NULL){
+    port->SetPeriodClk(periodClk);
+  }
+  
+  return;
+}
+
+//Atribui ciclo de trabalho de 16 bits a um dos pinos.
+void fxPwm_T1::SetDuty16(UINT8 pin, UINT16 duty16){
+  fxPwm_Port *port = this->GetPort(pin);
+
+  if(port!=NULL){
+    port->SetDuty16(duty16);
+  }
+
+  return;
+}
+
+//Atribui o mapeamento inteiro na porta.
+void fxPwm_T1::SetMap16(UINT8 pin, UINT16 dutyValue1, UINT16 mappedValue1, UINT16 dutyValue2, UINT16 mappedValue2){
+  fxPwm_Port *port = this->GetPort(pin);
+
+  if(port!=NULL){
+    port->SetMap16(dutyValue1, mappedValue1, dutyValue2, mappedValue2);
+  }
+
+  return;
+}
+
+#ifndef fxPwm_NO_FLOAT
 //Atribui frequência a um dos pinos.
 void fxPwm_T1::SetFrequency(UINT8 pin, FLOAT frequency){
   fxPwm_Port *port = this->GetPort(pin);
@@ -604,6 +2309,7 @@ void fxPwm_T1::SetMap(UINT8 pin, FLOAT dutyValue1, FLOAT mappedValue1, FLOAT dut
 
   return;
 }
+#endif
 
 //Habilita modulação em um pino.
 void fxPwm_T1::EnablePin(UINT8 pin){
@@ -627,21 +2333,33 @@ void fxPwm_T1::DisablePin(UINT8 pin){
   return;
 }
 
-//Habilita todos os pinos alocados.
+//Habilita todos os pinos alocados, também nos motores acrescentados.
+//Num lote só, para que comecem juntos e o agendador seja reprogramado uma vez.
 void fxPwm_T1::EnableAll(){
   UINT8 t;
-  for(t=0;t<this->GetNumRegisteredPorts();t++){
-    this->EnablePin(this->ports[t]->pinNumber);
+  this->BeginUpdate();
+  for(t=0;t<this->numPorts;t++){
+    this->ports[t]->Enable();
   }
+  for(t=0;t<this->numShards;t++){
+    this->shards[t]->EnableAll();
+  }
+  this->EndUpdate();
 
   return;
 }
 
+//Desabilita todos os pinos alocados, também nos motores acrescentados.
 void fxPwm_T1::DisableAll(){
   UINT8 t;
-  for(t=0;t<this->GetNumRegisteredPorts();t++){
-    this->DisablePin(this->ports[t]->pinNumber);
+  this->BeginUpdate();
+  for(t=0;t<this->numPorts;t++){
+    this->ports[t]->Disable();
+  }
+  for(t=0;t<this->numShards;t++){
+    this->shards[t]->DisableAll();
   }
+  this->EndUpdate();
 
   return;
 }
@@ -651,20 +2369,22 @@ void fxPwm_T1::DisableAll(){
 //Métodos de aquisição de informação.
 //===============================================================
 
-//Pesquisa pela porta com certo número de pino e retorna o ponteiro.
+//Retorna o ponteiro da porta com certo número de pino, pela tabela de pinos deste motor
+//e depois pelas dos motores acrescentados.
 //USE COM CUIDADO!!!
 fxPwm_Port *fxPwm_T1::GetPort(UINT8 pin){
-  if(this->ports==NULL || this->maxPorts==0 || pin==0xFF){
+  if(this->ports==NULL || pin>=fxPwm_PinTableSize){
     return NULL;
   }
+  if(this->pinTable[pin]!=0xFF){
+    return this->ports[this->pinTable[pin]];
+  }
 
   UINT8 t;
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]==NULL){
-      break;
-    }
-    if(this->ports[t]->pinNumber == pin){
-      return this->ports[t];
+  fxPwm_Port *port;
+  for(t=0;t<this->numShards;t++){
+    if((port = this->shards[t]->GetPort(pin))!=NULL){
+      return port;
     }
   }
 
@@ -676,20 +2396,9 @@ UINT8 fxPwm_T1::GetMaxPorts(){
   return this->maxPorts;
 }
 
-//Conta a quantidade de portas registradas.
+//Retorna a quantidade de portas registradas.
 UINT8 fxPwm_T1::GetNumRegisteredPorts(){
-  if(this->IsAllocated()==FALSE || this->maxPorts==0xFF){
-    return 0;
-  }
-
-  UINT8 t;
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]==NULL){
-      return t;
-    }
-  }
-
-  return t;
+  return this->numPorts;
 }
 
 //Retorna um ponteiro para uma porta registrada a partir de um índice, ou NULL se não existir.
@@ -711,21 +2420,11 @@ UINT8 fxPwm_T1::GetRegisteredPortPinNumber(UINT8 index){
 
 //Retorna o índice de um pino, ou 0xFF se não existir.
 UINT8 fxPwm_T1::GetIndex(UINT8 pin){
-  if(this->IsAllocated() || pin == 0xFF){
+  if(this->IsAllocated()==FALSE || pin>=fxPwm_PinTableSize){
     return 0xFF;
   }
 
-  UINT8 t;
-  for(t=0;t<this->maxPorts;t++){
-    if(this->ports[t]==NULL){
-      break;
-    }
-    if(this->ports[t]->pinNumber == pin){
-      return t;
-    }
-  }
-
-  return 0xFF;
+  return this->pinTable[pin];
 }
 
 TIME_US fxPwm_T1::GetPeriod(UINT8 pin){
@@ -736,6 +2435,31 @@ TIME_US fxPwm_T1::GetPeriod(UINT8 pin){
   return 0;
 }
 
+UINT32 fxPwm_T1::GetPeriodClk(UINT8 pin){
+  fxPwm_Port *port = GetPort(pin);
+  if(port!=NULL){
+    return port->GetPeriodClk();
+  }
+  return 0;
+}
+
+UINT16 fxPwm_T1::GetRawDuty16(UINT8 pin){
+  fxPwm_Port *port = GetPort(pin);
+  if(port!=NULL){
+    return port->GetRawDuty16();
+  }
+  return 0;
+}
+
+BOOL fxPwm_T1::IsHardware(UINT8 pin){
+  fxPwm_Port *port = GetPort(pin);
+  if(port!=NULL){
+    return port->IsHardware();
+  }
+  return FALSE;
+}
+
+#ifndef fxPwm_NO_FLOAT
 FLOAT fxPwm_T1::GetFrequency(UINT8 pin){
   fxPwm_Port *port = GetPort(pin);
   if(port!=NULL){
@@ -751,18 +2475,70 @@ FLOAT fxPwm_T1::GetDuty(UINT8 pin){
   }
   return 0.0;
 }
+#endif
+
+UINT32 fxPwm_T1::GetNsPerTimerClock(){
+  return nsPerTimerClock;
+}
 
 TIME_US fxPwm_T1::GetNextEvent(UINT8 pin){
   fxPwm_Port *port = GetPort(pin);
   if(port!=NULL){
-    return (TIME_US)(((UINT64)port->next*(UINT64)nsPerTimerClock)/(UINT64)1000);
+    return ClkToMicros(port->next);
   }
   return 0;
 }
 
   
 TIME_US fxPwm_T1::Micros(){
-  return (TIME_US)(((UINT64)this->clockCount*(UINT64)nsPerTimerClock)/(UINT64)1000);
+  return ClkToMicros(this->clockCount);
+}
+
+#ifdef fxPwm_STATS
+//===============================================================
+//Métodos de estatística.
+//===============================================================
+
+//Copia as estatísticas com interrupções desabilitadas, para que todos os campos sejam do mesmo instante.
+void fxPwm_T1::GetStats(fxPwm_Stats *stats){
+  if(stats==NULL){
+    return;
+  }
+  fxPwm_SaveSREG();cli();
+  *stats = this->stats;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//Zera as estatísticas.
+void fxPwm_T1::ResetStats(){
+  UINT8 t;
+  fxPwm_SaveSREG();cli();
+  this->stats.isrCount = 0;
+  this->stats.edgeCount = 0;
+  for(t=0;t<fxPwm_StatsBins;t++){
+    this->stats.lateness[t] = 0;
+  }
+  this->stats.maxLateness = 0;
+  this->stats.maxDuration = 0;
+  this->stats.deadlineHits = 0;
+  this->stats.deltaClamps = 0;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//Faixa 0: atraso 0. Faixa k: a partir de 2^(k-1) ciclos.
+UINT32 fxPwm_T1::GetStatsBinStart(UINT8 bin){
+  if(bin==0){
+    return 0;
+  }
+  if(bin>=fxPwm_StatsBins){
+    bin = fxPwm_StatsBins-1;
+  }
+  return ((UINT32)1)<<(bin-1);
 }
+#endif
+
 
-
@@ -11,10 +11,33 @@
  *  17-07-2018: primeira documentação
  *  21-07-2018: modificações maiores na estrutura da biblioteca. Melhoria de desempenho.
  *  25-07-2018: destrutor
+ *  17-10-2026: agendamento por heap mínimo (fxPwm_Scheduler).
+ *  17-10-2026: agendamento por tabela de bordas pré-compilada.
+ *  17-10-2026: escritas no mesmo registrador PORTx juntadas em uma só.
+ *  17-10-2026: funções inteiras de período e ciclo de trabalho (SetPeriodClk, SetDuty16, SetMap16).
+ *  17-10-2026: atualização em lote (BeginUpdate, EndUpdate).
+ *  17-10-2026: tabela de pinos (GetPort em tempo constante), RegisterPort retorna a porta, remoção sem deslocar a lista.
+ *  17-10-2026: TIMER1 pode ser tomado por um motor fxPwmStatic (timerOwner).
+ *  17-10-2026: tempos comparados pela diferença com sinal (fxPwm_TIME_BEFORE), sem problema com a volta do clockCount.
+ *  17-10-2026: estatísticas opcionais do Tick() (fxPwm_STATS): atraso das bordas, duração, deadline e minTimerDelta.
+ *  17-10-2026: escalonamento de fase opcional (SetStagger): portas com períodos iguais ou harmônicos começam defasadas.
+ *  17-10-2026: grupos de pinos travados no mesmo período (RegisterGroup), com saídas complementares e tempo morto.
+ *  17-10-2026: modo de densidade de pulsos (PDM) por porta, com todas as portas PDM atualizadas no mesmo passo.
+ *  17-10-2026: TIMER1 pode ser tomado pelo modulador BCM (fxPwmBcm).
+ *  17-10-2026: motor em qualquer timer de 16 bits (TIMER1, 3, 4, 5), e portas repartidas entre motores (AddShard).
+ *  17-10-2026: portas em pinos com PWM por hardware passam para o timer do pino quando o período bate (HwAccepts).
+ *  17-10-2026: PWM por hardware só com fxPwm_HW_PWM, e só com ciclo de trabalho que cabe em 8 bits (fxPwm_HwDutyTolerance).
+ *  17-10-2026: trajetórias do ciclo de trabalho (fxPwm_Trajectory) avançadas no início de cada período.
+ *  17-10-2026: varreduras do período (fxPwm_Glide) avançadas no início de cada período, para sirenes e glissandos.
+ *  17-10-2026: fila de comandos com hora marcada (fxPwm_Queue), executada pelo Tick() (SetQueue).
+ *  17-10-2026: modo fatiado opcional (fxPwm_SliceBudget): Tick() com orçamento rígido, retomado de onde parou.
+ *  17-10-2026: RegisterPort(pin) pode tirar as portas de um pool estático opcional (fxPwm_PortPoolSize), sem new.
+ *  17-10-2026: tabelas do motor em memória estática (fxPwm_Storage, Initialize(storage)). Sem heap (fxPwm_NO_HEAP).
  *  -----------------------------------------------------------
  *  Problemas conhecidos:
  *  22-07-2018: o uso da comunicação Serial pode quebrar a biblioteca.
  *	  Chamar fxPwm.Start() antes e depois de fazer comunicação serial costuma resolver.
+ *	  Com fxPwm_SliceBudget, a interrupção tem duração limitada e não se empilha com a da Serial.
  */
 
 #ifndef fxPwm_H
@@ -22,6 +45,10 @@
 
 #include <fxPwmTypes.h>
 #include <fxPwm_Port.h>
+#include <fxPwm_LockGroup.h>
+#include <fxPwm_Trajectory.h>
+#include <fxPwm_Glide.h>
+#include <fxPwm_Queue.h>
 
 // ========================================================
 // Vários parâmetros configuráveis.
@@ -58,6 +85,15 @@
 #define fxPwm_MaxTimerDuration 1000
 #endif
 
+//Modo fatiado: orçamento rígido de cada chamada do callback, em microssegundos.
+//Quando definido, o callback verifica o orçamento a cada porta, passo de porta PDM e comando da fila
+//(e não a cada passada), e ao estourá-lo guarda a posição, sai, e continua dali na próxima chamada,
+//fxPwm_MinTimerDelta depois. As interrupções dos motores passam a bloquear (sem ISR_NOBLOCK): não entram
+//no meio de outras nem se empilham, e as outras (a recepção da Serial, por exemplo) esperam no máximo
+//o orçamento e mais uma porta, um passo PDM ou um comando.
+//Para a Serial a 115200 baud (um byte a cada 87 us) sem perder bytes, 40 us é um bom valor.
+//#define fxPwm_SliceBudget 40
+
 //Máximo atraso entre uma chamada do timer e outra.
 //Valores menores reduzem a latência ao habilitar ou desabilitar portas, com penalidade de desempenho.
 #ifndef fxPwm_MaxTimerPeriod
@@ -70,6 +106,181 @@
 #define fxPwm_MaxTimerClkSum 60000
 #endif
 
+//Algoritmos de agendamento disponíveis para o Tick().
+//SCAN: percorre todas as portas a cada passada. Custo proporcional ao número de portas.
+//HEAP: mantém as portas num heap mínimo ordenado pelo próximo evento. Cada passada só toca
+//as portas vencidas, e o próximo evento é lido no topo do heap.
+//FRAME: compila todas as portas habilitadas numa tabela de bordas pré-calculada, que cobre
+//o hiperperíodo (MMC dos períodos). O Tick() apenas avança um índice nessa tabela.
+//Se a tabela não couber em fxPwm_FrameMaxEntries, volta a funcionar como SCAN.
+#define fxPwm_SCHEDULER_SCAN 0
+#define fxPwm_SCHEDULER_HEAP 1
+#define fxPwm_SCHEDULER_FRAME 2
+
+//Algoritmo de agendamento usado.
+//O heap compensa com muitas portas (8 ou mais) ou frequências bem diferentes entre si.
+#ifndef fxPwm_Scheduler
+#define fxPwm_Scheduler fxPwm_SCHEDULER_SCAN
+#endif
+
+//Máximo de entradas da tabela de bordas do agendador FRAME.
+//A tabela é alocada duas vezes (uma em uso e outra sendo compilada), com 6 bytes por entrada.
+#ifndef fxPwm_FrameMaxEntries
+#define fxPwm_FrameMaxEntries 32
+#endif
+
+//Máximo de registradores PORTx distintos cujas escritas são juntadas pelo Tick().
+//Portas em registradores além desse limite são escritas uma a uma.
+#ifndef fxPwm_MaxPortGroups
+#define fxPwm_MaxPortGroups 12
+#endif
+
+//Tamanho da tabela que leva do número do pino à porta registrada, usada para achar a porta em tempo constante.
+//Pinos a partir desse valor não podem ser registrados. Ocupa um byte por pino.
+#ifndef fxPwm_PinTableSize
+#ifdef NUM_DIGITAL_PINS
+#define fxPwm_PinTableSize NUM_DIGITAL_PINS
+#else
+#define fxPwm_PinTableSize 70
+#endif
+#endif
+
+//Portas do pool estático usado pelo RegisterPort(pin), dividido entre os motores. Com o pool cheio,
+//a porta é alocada com new, como antes. Cada porta do pool é um fxPwm_Port inteiro (cerca de 63 bytes
+//no AVR), reservado mesmo sem uso: 8 portas são uns 500 bytes de RAM. Por padrão 0, sempre alocar.
+#ifndef fxPwm_PortPoolSize
+#define fxPwm_PortPoolSize 0
+#endif
+
+//Sem alocação dinâmica: a biblioteca nunca chama new. Initialize() e Initialize(maxPorts) deixam de existir,
+//e não compilam: o motor só funciona com as tabelas de um fxPwm_Storage (Initialize(storage)). RegisterPort(pin) só usa
+//o pool (fxPwm_PortPoolSize), e retorna NULL quando ele acaba.
+//#define fxPwm_NO_HEAP
+
+//Estatísticas do Tick(): histograma do atraso das bordas, contagem de interrupções, pior duração,
+//e quantas vezes o deadline (fxPwm_MaxTimerDuration) e o atraso mínimo (fxPwm_MinTimerDelta) atuaram.
+//Custa alguns ciclos por borda e por interrupção. Lidas por GetStats().
+//#define fxPwm_STATS
+
+//Faixas do histograma de atraso das bordas. A faixa 0 conta bordas sem atraso, e a faixa k
+//conta atrasos de 2^(k-1) até 2^k-1 ciclos do timer. A última faixa junta todos atrasos maiores.
+#ifndef fxPwm_StatsBins
+#define fxPwm_StatsBins 12
+#endif
+
+//Máximo de eventos (subidas e descidas) de outras portas considerados ao escolher a fase de uma porta (SetStagger).
+//Ocupa 4 bytes por ponto na pilha, só durante Enable() e EndUpdate().
+#ifndef fxPwm_StaggerMaxPoints
+#define fxPwm_StaggerMaxPoints 32
+#endif
+
+//Passo do modo PDM (SetPdm), em microssegundos: a cada passo, todas as portas PDM decidem seu nível.
+//Valores menores aumentam a frequência dos pulsos, com penalidade de desempenho.
+//Limitado a mais que fxPwm_MinTimerGap + fxPwm_MinTimerDelta, senão o Tick() nunca sairia entre os passos.
+#ifndef fxPwm_PdmPeriod
+#define fxPwm_PdmPeriod 200
+#endif
+
+//Timers de 16 bits que podem rodar um motor (fxPwm_T1(UINT8 timer)).
+//TIMER3, TIMER4 e TIMER5 só existem nas placas Mega (ATmega1280/2560) e parecidas.
+#define fxPwm_TIMER1 0
+#define fxPwm_TIMER3 1
+#define fxPwm_TIMER4 2
+#define fxPwm_TIMER5 3
+#define fxPwm_TIMERS 4
+
+//Sem as interrupções de TIMER3, TIMER4 e TIMER5, para não disputar com outras bibliotecas que as usam.
+//Os motores nesses timers deixam de funcionar.
+//#define fxPwm_NO_EXTRA_TIMERS
+
+//Máximo de motores em outros timers entre os quais um motor reparte suas portas (AddShard).
+#ifndef fxPwm_MaxShards
+#define fxPwm_MaxShards 3
+#endif
+
+//Passa portas para o PWM por hardware dos pinos (analogWrite()) quando o timer do pino consegue gerá-las.
+//Desligado por padrão: mexe nos timers do núcleo do Arduino usados por outras bibliotecas (por exemplo o TIMER2 do tone()).
+//#define fxPwm_HW_PWM
+
+//Diferença aceita entre o período pedido e o do PWM por hardware, em milésimos do período do hardware.
+//O hardware tem período fixo (fxPwm_HAL_HwPwmCycles) e ciclo de trabalho de 8 bits.
+#ifndef fxPwm_HwTolerance
+#define fxPwm_HwTolerance 10
+#endif
+
+//Diferença aceita entre o ciclo de trabalho pedido (16 bits) e o de 8 bits do hardware, em unidades de 16 bits.
+//Com 0, só ciclos de trabalho exatos em 8 bits (fxPwm_HW_DUTY16) vão para o hardware. Com 128, qualquer um.
+#ifndef fxPwm_HwDutyTolerance
+#define fxPwm_HwDutyTolerance 0
+#endif
+
+//Converte um ciclo de trabalho de 16 bits para o valor do analogWrite(), com arredondamento.
+#define fxPwm_HW_DUTY8(duty16) ((UINT8)(((UINT32)(duty16)*255 + fxPwm_DUTY16_MAX/2)/fxPwm_DUTY16_MAX))
+//Ciclo de trabalho de 16 bits exato para um valor do analogWrite(), de 0 até 255.
+#define fxPwm_HW_DUTY16(duty8) ((UINT16)((UINT16)(duty8)*257))
+
+// ========================================================
+// Tipos auxiliares.
+// ========================================================
+
+//Entrada da tabela de bordas do agendador FRAME.
+//Ao ser executada, escreve no registrador da porta e espera delta ciclos até a próxima.
+struct fxPwm_FrameEntry{
+  //Ciclos do timer até a próxima entrada.
+  UINT16 delta;
+  //Registrador da porta, ou NULL para uma entrada que só espera.
+  volatile BYTE *port;
+  //Bits a setar e a limpar no registrador.
+  BYTE setMask;
+  BYTE clearMask;
+};
+
+//Grupo de portas que compartilham o mesmo registrador PORTx.
+//Durante uma passada do Tick() as bordas acumulam bits aqui, e o registrador é escrito uma vez só no fim.
+struct fxPwm_PortGroup{
+  //Registrador compartilhado.
+  volatile BYTE *port;
+  //Bits a setar e a limpar na próxima escrita.
+  BYTE setMask;
+  BYTE clearMask;
+};
+
+//Tabelas de um motor com até maxPorts portas, de 1 até 254, para o Initialize(storage).
+//Numa variável global ou static, a memória do motor fica toda conhecida na compilação, sem heap.
+template<UINT8 maxPorts> struct fxPwm_Storage{
+  static_assert(maxPorts>=1 && maxPorts<0xFF, "fxPwm_Storage: de 1 a 254 portas");
+  //Lista de portas, com a marcação do fim.
+  fxPwm_Port *ports[maxPorts+1];
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  //Heap do agendador.
+  fxPwm_Port *heap[maxPorts];
+#endif
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Tabelas de bordas.
+  fxPwm_FrameEntry frames[2][fxPwm_FrameMaxEntries];
+#endif
+};
+
+#ifdef fxPwm_STATS
+//Cópia das estatísticas do Tick(), retornada por GetStats(). Tempos em ciclos do timer.
+struct fxPwm_Stats{
+  //Quantidade de chamadas do Tick() (entradas na interrupção).
+  UINT32 isrCount;
+  //Quantidade de bordas atendidas.
+  UINT32 edgeCount;
+  //Bordas por faixa de atraso (clockCount - next no atendimento). Veja fxPwm_StatsBins.
+  UINT32 lateness[fxPwm_StatsBins];
+  //Maior atraso de uma borda.
+  UINT32 maxLateness;
+  //Maior duração de uma chamada do Tick(), da primeira à última leitura do TCNT1.
+  UINT16 maxDuration;
+  //Chamadas que saíram por causa do deadline (fxPwm_MaxTimerDuration), com bordas ainda próximas.
+  UINT32 deadlineHits;
+  //Chamadas em que a próxima foi adiada para respeitar fxPwm_MinTimerDelta.
+  UINT32 deltaClamps;
+};
+#endif
+
 // ========================================================
 // Classe principal.
 // ========================================================
@@ -78,19 +289,34 @@ class fxPwm_T1{
 private:
   //Máximo de portas alocáveis.
   UINT8 maxPorts;
+  //Indica que as tabelas foram alocadas pelo Initialize(maxPorts), e devem ser liberadas pelo Free().
+  //FALSE com as tabelas de um fxPwm_Storage.
+  BOOL ownTables;
   //Ponteiro para vetor contendo ponteiro para os objetos que representam as portas.
   //Ele tem um elemento a mais que maxPorts para que este último sirva de marcação do fim da lista estática.
+  //A posição de cada porta fica guardada nela (fxPwm_Port::index).
   fxPwm_Port **ports;
-  //Ponteiro para lista de pinos alocados internamente. 0xFF = elemento vazio.
-  UINT8 *allocatedPins;
+  //Quantidade de portas registradas.
+  UINT8 numPorts;
+  //Posição em ports da porta registrada em cada pino, ou 0xFF se não houver.
+  UINT8 pinTable[fxPwm_PinTableSize];
+
+  //Coloca e tira o pino de uma porta registrada da tabela de pinos.
+  void MapPin(fxPwm_Port *port);
+  void UnmapPin(UINT8 pin, fxPwm_Port *port);
 
-  //Último valor registrado de TCNT1.
+  //Timer do motor (fxPwm_TIMER1 etc.) e seus registradores, ou NULL se ele não existir.
+  UINT8 timer;
+  const fxPwm_HAL_Timer *hw;
+
+  //Último valor registrado de TCNTx.
   volatile UINT16 lastClock;
 
-  //Contagem dos ciclos de clock do TIMER1.
+  //Contagem dos ciclos de clock do timer.
   volatile TIME_CLOCK clockCount;
   
   //Quantidade de nanossegundos por ciclo de clock do timer.
+  //Igual para todos os motores: os timers de 16 bits têm os mesmos pré-escalares.
   static UINT32 nsPerTimerClock;
 
   //Variáveis contendo dados importantes de temporização.
@@ -99,32 +325,213 @@ private:
   static UINT16 maxTimerDuration;
   static UINT16 maxTimerPeriod;
 
-  //Bits do pré-escalar do TIMER1.
+  //Bits do pré-escalar do timer.
   static UINT8 prescaler;
 
+  //Converte microssegundos em ciclos do timer, e vice-versa, com arredondamento.
+  static UINT32 MicrosToClk(TIME_US micros);
+  static TIME_US ClkToMicros(TIME_CLOCK clk);
+
+  //Indica se o timer do pino de uma porta registrada pode gerar o período e o ciclo de trabalho pedidos sozinho,
+  //no lugar do Tick(): fxPwm_HW_PWM definido, o pino tem PWM por hardware, o timer não é de um motor, o período
+  //bate com o do hardware (fxPwm_HwTolerance) e o ciclo de trabalho cabe em 8 bits (fxPwm_HwDutyTolerance).
+  //Portas PDM e de grupos travados ficam sempre no Tick().
+  static BOOL HwAccepts(fxPwm_Port *port, UINT32 periodClk, UINT16 duty16);
+
   //Limpa tudo e calcula dados de temporização.
   void Cleanup();
 
-  //Configura o TIMER1.
+  //Configura o timer e passa a atender sua interrupção.
   void ConfigureTimer();
 
-  //Começa a contagem do TIMER1.
+  //Começa a contagem do timer.
   void StartTimer();
 
-  //Para (na verdade pausa) a contagem do TIMER1.
+  //Para (na verdade pausa) a contagem do timer.
   void StopTimer();
 
+  //Motores em outros timers que recebem parte das portas (AddShard).
+  fxPwm_T1 *shards[fxPwm_MaxShards];
+  //Quantidade de motores em shards.
+  UINT8 numShards;
+  //Retorna o motor com menos portas registradas, entre este e seus shards alocados que ainda têm espaço.
+  //Se todos estiverem cheios, retorna este.
+  fxPwm_T1 *PickShard();
+
   //Seta o próximo evento que acontece, mas apenas se clockCount for anterior ao mais próximo agendado.
-  void SetNextFireMin(UINT32 clockCount);
+  void SetNextFireMin(TIME_CLOCK clockCount);
+
+  //Reagenda uma porta depois que seu próximo evento (fxPwm_Port::next) mudou.
+  //Deve ser chamado com interrupções desabilitadas.
+  void Reschedule(fxPwm_Port *port);
+  //Como Reschedule(), mas sem reprogramar o OCRxB. Retorna FALSE se o OCRxB não pode ser mexido.
+  BOOL Requeue(fxPwm_Port *port);
+
+  //Indica que as portas começam defasadas das outras com período igual ou harmônico (SetStagger).
+  BOOL stagger;
+  //Escolhe a fase, em ciclos do timer depois de ref, em que uma porta deve começar:
+  //a que deixa menos bordas de outras portas com período igual ou harmônico perto da subida e da descida.
+  UINT32 StaggerPhase(fxPwm_Port *port, TIME_CLOCK ref);
+  //Retorna o primeiro instante, a partir de now, com a fase phase (contada de ref) no período period.
+  static TIME_CLOCK StaggerNext(TIME_CLOCK ref, UINT32 phase, UINT32 period, TIME_CLOCK now);
+
+#if defined(fxPwm_SliceBudget) && fxPwm_Scheduler!=fxPwm_SCHEDULER_HEAP
+  //Próxima porta da passada cortada pelo fim da fatia anterior, ou NULL se a passada terminou.
+  fxPwm_Port **sliceIndex;
+#endif
+#ifdef fxPwm_SliceBudget
+  //Valor do timer no início da chamada atual do Tick().
+  UINT16 sliceStart;
+  //Retorna TRUE se a chamada atual do Tick() já gastou o orçamento da fatia.
+  inline BOOL SliceSpent();
+  //Próxima porta do passo do PDM cortado pelo fim da fatia anterior, ou NULL se o passo terminou.
+  fxPwm_Port *pdmSlice;
+#endif
+
+  //Profundidade de BeginUpdate() sem o EndUpdate() correspondente.
+  //Enquanto for maior que 0, as mudanças nas portas só são guardadas, e o Tick() não as aplica.
+  volatile UINT8 batchDepth;
+
+  //Grupos de portas por registrador PORTx.
+  fxPwm_PortGroup groups[fxPwm_MaxPortGroups];
+  //Quantidade de grupos em uso.
+  UINT8 numGroups;
+
+  //Retorna o grupo de um registrador, criando se preciso, ou 0xFF se não houver espaço.
+  UINT8 GroupPort(volatile BYTE *port);
+  //Acumula bits a setar e a limpar no grupo de um registrador (ou escreve direto se não tiver grupo).
+  //O índice do grupo fica guardado em *group, por quem chama.
+  inline void QueueBits(volatile BYTE *port, UINT8 *group, BYTE setMask, BYTE clearMask);
+  //Acumula a mudança de nível de uma porta no seu grupo (ou escreve direto se não tiver grupo).
+  inline void QueueLevel(fxPwm_Port *port, BYTE level);
+  //Escreve os bits acumulados em cada registrador, uma vez por registrador.
+  inline void FlushGroups();
+
+  //Troca o nível de uma porta cujo evento venceu, e calcula seu próximo evento.
+  inline void ProcessEdge(fxPwm_Port *port);
+
+  //Lista das portas em modo PDM, ligada por fxPwm_Port::pdmNextPort, ou NULL se não houver.
+  fxPwm_Port *pdmPorts;
+  //Próximo passo do PDM.
+  TIME_CLOCK pdmNext;
+  //Intervalo entre os passos do PDM, em ciclos do timer.
+  UINT16 pdmPeriod;
+  //Decide o nível de todas as portas PDM e agenda o próximo passo.
+  //Retorna TRUE se a fatia acabou antes do fim do passo (fxPwm_SliceBudget).
+  inline BOOL TickPdm();
+  //Coloca e tira uma porta registrada da lista do PDM. Devem ser chamados com interrupções desabilitadas.
+  void PdmLink(fxPwm_Port *port);
+  void PdmUnlink(fxPwm_Port *port);
+
+  //Executa as escritas vencidas da tabela de um grupo travado, e calcula seu próximo evento.
+  inline void ProcessLockEdge(fxPwm_Port *port);
+
+  //Avança a trajetória de uma porta um passo e recalcula os períodos ALTO e BAIXO com o valor novo.
+  //Chamado no início de cada período da porta.
+  inline void StepTrajectory(fxPwm_Port *port);
+  //Aplica o período atual da varredura de uma porta nos períodos ALTO e BAIXO, e avança a varredura um passo.
+  //Chamado no início de cada período da porta, antes da trajetória.
+  inline void StepGlide(fxPwm_Port *port);
+
+  //Fila de comandos com hora marcada executada por este motor, ou NULL.
+  fxPwm_Queue * volatile queue;
+  //Executa os comandos vencidos da fila.
+  //Retorna TRUE se a fatia acabou com comandos vencidos ainda na fila (fxPwm_SliceBudget).
+  inline BOOL TickQueue();
+  //Aplica um comando da fila: a porta recomeça o período no instante do comando.
+  inline void RunCommand(fxPwm_Command *command);
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+  //Heap mínimo com as portas registradas, ordenado por fxPwm_Port::next.
+  fxPwm_Port **heap;
+  //Quantidade de portas no heap.
+  UINT8 heapSize;
+
+  //Indica se o evento de a vem antes do de b. Portas sem evento agendado ficam no fim.
+  inline BOOL EventBefore(fxPwm_Port *a, fxPwm_Port *b);
+  //Sobe ou desce uma porta no heap até sua posição correta.
+  void HeapSiftUp(UINT8 index);
+  void HeapSiftDown(UINT8 index);
+  //Insere ou retira uma porta do heap.
+  void HeapInsert(fxPwm_Port *port);
+  void HeapRemove(fxPwm_Port *port);
+#endif
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Tabelas de bordas: uma em execução (frameFront) e outra para compilação.
+  fxPwm_FrameEntry *frames[2];
+  //Quantidade de entradas em cada tabela.
+  UINT8 frameLength[2];
+  //Índice da tabela em execução.
+  volatile UINT8 frameFront;
+  //Índice da próxima entrada a executar.
+  UINT8 frameIndex;
+  //Valor do OCRxB em que a entrada atual foi agendada.
+  UINT16 frameCompare;
+  //Espera, em ciclos do timer, que terminou em frameCompare.
+  UINT16 frameWait;
+  //Indica que a tabela está sendo executada (senão, funciona como SCAN).
+  volatile BOOL frameActive;
+  //Pede ao Tick() que troque para a outra tabela, ou volte ao SCAN se a compilação falhou.
+  volatile BOOL frameSwap;
+  //Indica que alguma porta mudou desde a última compilação.
+  volatile BOOL frameDirty;
+
+  //Indica se a porta participa da tabela.
+  inline BOOL FrameIncludes(fxPwm_Port *port);
+  //Retorna a última tabela do grupo travado de uma porta, se ele participar da tabela de bordas, ou NULL.
+  fxPwm_LockEdge *FrameLock(fxPwm_Port *port, UINT8 *length, UINT32 *period);
+  //Tira bits de um registrador da tabela em execução (porta ou pino de grupo desabilitado).
+  void FrameForget(volatile BYTE *port, BYTE mask);
+  //Compila as portas habilitadas numa tabela. Retorna FALSE se não couber.
+  BOOL CompileFrame(fxPwm_FrameEntry *frame, UINT8 *length);
+  //Executa as entradas vencidas da tabela.
+  void TickFrame();
+  //Recompila a tabela se alguma porta mudou, e pede a troca ao Tick().
+  void UpdateFrame();
+#endif
+
+#ifdef fxPwm_STATS
+  //Estatísticas sendo acumuladas pelo Tick().
+  fxPwm_Stats stats;
+  //Conta uma borda atendida com o atraso dado, em ciclos do timer.
+  void StatsEdge(UINT32 lateness);
+  //Conta a duração de uma chamada do Tick() iniciada em start (valor do TCNTx).
+  void StatsDuration(UINT16 start);
+#endif
 
   //Testa se tudo está alocado direito.
   BOOL IsAllocated();
+  //Passa a usar as tabelas dadas, já com a capacidade de portas, e configura o timer. Libera as anteriores.
+  //heap e frame0/frame1 só são usados pelos agendadores HEAP e FRAME. own: liberar as tabelas no Free().
+  void Attach(UINT8 maxPorts, fxPwm_Port **ports, fxPwm_Port **heap, fxPwm_FrameEntry *frame0, fxPwm_FrameEntry *frame1, BOOL own);
 public:
 
-  //Classe amiga, auxiliar.
+  //Classes amigas, auxiliares.
   friend class fxPwm_Port;
+  friend class fxPwm_LockGroup;
+  friend class fxPwm_Glide;
+  friend class fxPwm_Queue;
+  //Motores com pinos fixos usam a configuração do timer daqui.
+  template<UINT8... pins> friend class fxPwmStatic;
+  template<UINT8 bits, UINT8... pins> friend class fxPwmBcm;
+
+  //Rotina chamada pela interrupção no lugar do Tick(), quando um fxPwmStatic ou fxPwmBcm toma o TIMER1.
+  //NULL quando o TIMER1 é do fxPwm.
+  static void (* volatile timerOwner)(void);
+  //Motor que atende a interrupção de cada timer, ou NULL. Atribuído no Initialize().
+  static fxPwm_T1 * volatile engines[fxPwm_TIMERS];
+#if fxPwm_PortPoolSize>0
+  //Portas do RegisterPort(pin). Uma posição com internal==fxPwm_PORT_USER está livre.
+  static fxPwm_Port pool[fxPwm_PortPoolSize];
+#endif
   
+  //Motor no TIMER1.
   fxPwm_T1();
+  //Motor em outro timer de 16 bits (fxPwm_TIMER1, fxPwm_TIMER3, fxPwm_TIMER4 ou fxPwm_TIMER5).
+  //Se o timer não existir no microcontrolador, o Initialize() não faz nada.
+  //Só um motor por timer, e não use nele os timers do núcleo do Arduino (TIMER0) nem de outras bibliotecas.
+  fxPwm_T1(UINT8 timer);
   ~fxPwm_T1();
 
   //Resolve tudo que der nas saídas.
@@ -134,37 +541,112 @@ public:
   //Métodos de inicialização e liberação.
   //===============================================================
 
+#ifndef fxPwm_NO_HEAP
   //Inicializa a biblioteca com fxPwm_MaxPorts portas no máximo.
   void Initialize();
 
   //Inicializa a biblioteca com uma capacidade determinada de portas.
   void Initialize(UINT8 maxPorts);
+#endif
+
+  //Inicializa a biblioteca com as tabelas de storage, sem alocar nada: a capacidade é a do fxPwm_Storage.
+  //storage deve durar até o Free() (uma variável global ou static).
+  template<UINT8 maxPorts> void Initialize(fxPwm_Storage<maxPorts> &storage){
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_HEAP
+    this->Attach(maxPorts, storage.ports, storage.heap, NULL, NULL, FALSE);
+#elif fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+    this->Attach(maxPorts, storage.ports, NULL, storage.frames[0], storage.frames[1], FALSE);
+#else
+    this->Attach(maxPorts, storage.ports, NULL, NULL, NULL, FALSE);
+#endif
+  }
 
   //Libera recursos usados pela biblioteca.
   void Free();
   
-  //Inicia operação do modulador PWM.
+  //Inicia operação do modulador PWM, e dos motores em AddShard().
   void Start();
-  //Para operação do modulador PWM.
+  //Para operação do modulador PWM, e dos motores em AddShard().
   void Stop();
 
+  //===============================================================
+  //Métodos de repartição entre timers.
+  //===============================================================
+
+  //Acrescenta um motor em outro timer, já inicializado, para receber parte das portas.
+  //Cada porta nova (RegisterPort, RegisterGroup) vai para o motor com menos portas, e as interrupções
+  //dos timers se dividem entre elas. Os métodos por pino, EnableAll(), DisableAll(), BeginUpdate(),
+  //EndUpdate(), Start() e Stop() deste motor valem também para os acrescentados.
+  //Portas em timers diferentes não ficam em fase entre si.
+  //Retorna FALSE se não foi possível (lista cheia, motor no mesmo timer, ou motor já acrescentado).
+  BOOL AddShard(fxPwm_T1 *engine);
+  //Retorna a quantidade de motores acrescentados.
+  UINT8 GetNumShards();
+  //Retorna um motor acrescentado a partir de um índice, ou NULL se não existir.
+  fxPwm_T1 *GetShard(UINT8 index);
+
+  //===============================================================
+  //Métodos de atualização em lote.
+  //===============================================================
+
+  //Começa um lote. Até o EndUpdate(), mudanças de período, ciclo de trabalho e habilitação
+  //das portas são apenas guardadas, sem desabilitar interrupções e sem mexer no agendador.
+  //Pode ser aninhado.
+  void BeginUpdate();
+  //Termina um lote. Todas as portas mudadas recomeçam juntas, em fase, no mesmo instante do timer,
+  //com uma única reprogramação do agendador. Com SetStagger(TRUE), recomeçam defasadas.
+  void EndUpdate();
+
+  //===============================================================
+  //Métodos de escalonamento de fase.
+  //===============================================================
+
+  //Liga ou desliga o escalonamento de fase (desligado por padrão).
+  //Ligado, cada porta que começa a modular (Enable(), EndUpdate()) começa numa fase longe das bordas
+  //das portas com período igual ou harmônico, em vez de começar logo.
+  //As bordas se espalham pelo período, sem mudar frequência nem ciclo de trabalho.
+  //Sem efeito com fxPwm_SCHEDULER_FRAME, em que bordas simultâneas já custam uma entrada só.
+  void SetStagger(BOOL stagger);
+  //Indica se o escalonamento de fase está ligado.
+  BOOL GetStagger();
+
   //===============================================================
   //Métodos de manipulação de portas e pinos.
   //===============================================================
 
-  //Registra uma porta a partir do ponteiro.
-  void RegisterPort(fxPwm_Port *port);
-  //Remove uma porta registrada, a partir do ponteiro.
+  //Registra uma porta a partir do ponteiro, no motor com menos portas (veja AddShard).
+  //Retorna a própria porta, ou NULL se não foi possível (pino já registrado, fora da tabela de pinos, ou lista cheia).
+  fxPwm_Port *RegisterPort(fxPwm_Port *port);
+  //Remove uma porta registrada, a partir do ponteiro, em tempo constante, do motor em que estiver.
+  //A última porta da lista passa a ocupar o lugar da removida.
   //Se a porta tiver sido alocada internamente, ela também será desalocada.
   void RemovePort(fxPwm_Port *port);
 
   //Registra uma porta a partir de um número de pino do Arduino.
-  void RegisterPort(UINT8 pin);
+  //Retorna a porta, do pool estático (fxPwm_PortPoolSize) ou alocada, ou NULL se não foi possível.
+  //O ponteiro retornado serve de identificador: ele não muda até a porta ser removida,
+  //e os métodos de fxPwm_Port chamados por ele não precisam procurar o pino.
+  fxPwm_Port *RegisterPort(UINT8 pin);
   //Remove uma porta a partir de um número de pino do Arduino.
   void RemovePort(UINT8 pin);
 
+  //Registra um grupo de pinos travados (fxPwm_LockGroup). Ocupa uma posição da lista de portas.
+  //Retorna o próprio grupo, ou NULL se não foi possível.
+  fxPwm_LockGroup *RegisterGroup(fxPwm_LockGroup *group);
+  //Desabilita e remove um grupo registrado.
+  void RemoveGroup(fxPwm_LockGroup *group);
+
   //Atribui o período, em microssegundos, do ciclo PWM de um pino.
   void SetPeriod(UINT8 pin, TIME_US period);
+  //Atribui o período, em ciclos do timer, do ciclo PWM de um pino. Sem conversões.
+  void SetPeriodClk(UINT8 pin, UINT32 periodClk);
+  //Atribui o ciclo de trabalho, de 0 (0%) até fxPwm_DUTY16_MAX (100%), do ciclo PWM de um pino.
+  //Passa pelo mapeamento inteiro (SetMap16), se houver. Não usa FLOAT.
+  void SetDuty16(UINT8 pin, UINT16 duty16);
+  //Mapeia o ciclo de trabalho de 16 bits, para adequar os valores de entrada.
+  void SetMap16(UINT8 pin, UINT16 dutyValue1, UINT16 mappedValue1, UINT16 dutyValue2, UINT16 mappedValue2);
+
+#ifndef fxPwm_NO_FLOAT
   //Atribui a frequência, em hertz, do ciclo PWM de um pino.
   void SetFrequency(UINT8 pin, FLOAT frequency);
   //Atribui o ciclo de trabalho, de 0.0 (0%) até 1.0 (100%), do ciclo PWM de um pino.
@@ -172,6 +654,27 @@ public:
 
   //Mapeia o ciclo de trabalho, para adequar os valores de entrada.
   void SetMap(UINT8 pin,FLOAT dutyValue1, FLOAT mappedValue1, FLOAT dutyValue2, FLOAT mappedValue2);
+#endif
+
+  //Atribui uma trajetória ao ciclo de trabalho de um pino, ou a tira com NULL. Veja fxPwm_Port::SetTrajectory().
+  void SetTrajectory(UINT8 pin, fxPwm_Trajectory *trajectory);
+  //Atribui uma varredura ao período de um pino, ou a tira com NULL. Veja fxPwm_Port::SetGlide().
+  void SetGlide(UINT8 pin, fxPwm_Glide *glide);
+
+  //Atribui a fila de comandos com hora marcada que o Tick() executa (veja fxPwm_Queue), ou a tira com NULL.
+  //O cursor da fila começa em agora, e os comandos pendentes são descartados. Uma fila é de um motor só,
+  //com as portas dele: cada motor acrescentado (AddShard) pode ter a sua.
+  //Enquanto houver fila, nenhuma porta do motor fica no PWM por hardware, e o FRAME funciona como SCAN.
+  void SetQueue(fxPwm_Queue *queue);
+  //Retorna a fila de comandos do motor, ou NULL.
+  fxPwm_Queue *GetQueue();
+
+  //Liga ou desliga o modo de densidade de pulsos (PDM) de um pino. Veja fxPwm_Port::SetPdm().
+  void SetPdm(UINT8 pin, BOOL pdm);
+  //Atribui o passo do modo PDM, em microssegundos, para todas as portas PDM.
+  void SetPdmPeriod(TIME_US period);
+  //Retorna o passo do modo PDM, em microssegundos.
+  TIME_US GetPdmPeriod();
 
   //Ativa a saída de modulação em um pino. 
   void EnablePin(UINT8 pin);
@@ -189,8 +692,8 @@ public:
   //Métodos de aquisição de informação.
   //===============================================================
 
-  //Retorna o ponteiro para uma porta a partir de um número de pino.
-  //Ou retorna NULL se não existir.
+  //Retorna o ponteiro para uma porta a partir de um número de pino, em tempo constante.
+  //Procura também nos motores acrescentados (AddShard). Ou retorna NULL se não existir.
   //Esse objeto retornado permite manipulação direta de alguns parâmetros da porta.
   //USE COM CUIDADO!
   fxPwm_Port *GetPort(UINT8 pin);
@@ -198,10 +701,11 @@ public:
   //Retorna a quantidade máxima de portas alocáveis.
   UINT8 GetMaxPorts();
 
-  //Retorna a quantidade de portas registradas.
+  //Retorna a quantidade de portas registradas neste motor, sem as dos acrescentados.
   UINT8 GetNumRegisteredPorts();
 
   //Retorna um ponteiro para uma porta registrada a partir de um índice, ou NULL se não existir.
+  //A remoção de uma porta muda o índice da última.
   //USE COM CUIDADO!
   fxPwm_Port *GetRegisteredPort(UINT8 index);
 
@@ -214,22 +718,49 @@ public:
   //Retorna o período de oscilação de um pino, em microssegundos.
   TIME_US GetPeriod(UINT8 pin);
 
+  //Retorna o período de oscilação de um pino, em ciclos do timer.
+  UINT32 GetPeriodClk(UINT8 pin);
+
+  //Retorna o ciclo de trabalho de um pino, sem mapeamento, de 0 até fxPwm_DUTY16_MAX.
+  UINT16 GetRawDuty16(UINT8 pin);
+
+  //Indica se um pino está no PWM por hardware (veja fxPwm_Port::IsHardware()).
+  BOOL IsHardware(UINT8 pin);
+
+#ifndef fxPwm_NO_FLOAT
   //Retorna a frequência de oscilação de um pino, em hertz.
   FLOAT GetFrequency(UINT8 pin);
 
   //Retorna o ciclo de trabalho de um pino, com mapeamento.
   FLOAT GetDuty(UINT8 pin);
+#endif
+
+  //Retorna a duração de um ciclo do timer, em nanossegundos.
+  UINT32 GetNsPerTimerClock();
 
   //Retorna o próximo evento em um pino.
   //Cuidado, valor muito volátil!
   TIME_US GetNextEvent(UINT8 pin);
 
-  //Retora a contagem de tempo, em microssegundos, do TIMER1. A precisão pode variar.
+  //Retora a contagem de tempo, em microssegundos, do timer. A precisão pode variar.
   TIME_US Micros();
+
+#ifdef fxPwm_STATS
+  //===============================================================
+  //Métodos de estatística (fxPwm_STATS).
+  //===============================================================
+
+  //Copia as estatísticas acumuladas desde o último ResetStats(), todas do mesmo instante.
+  void GetStats(fxPwm_Stats *stats);
+  //Zera as estatísticas.
+  void ResetStats();
+  //Retorna o menor atraso, em ciclos do timer, contado na faixa bin do histograma.
+  static UINT32 GetStatsBinStart(UINT8 bin);
+#endif
 };
 
 extern fxPwm_T1 fxPwm;
 
 #endif
 
-
+
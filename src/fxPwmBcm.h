@@ -0,0 +1,417 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwmBcm.h
+ *  Modulador por código binário (BCM, ou bit-angle modulation)
+ *  para muitos canais com o mesmo quadro, como painéis de LED:
+ *  fxPwmBcm<8, 2, 3, 4, 5, 6, 7, 8, 9> leds;
+ *  Cada quadro tem um intervalo por bit do nível, com duração
+ *  proporcional ao peso do bit. Os níveis são pré-compilados em
+ *  planos de bits, um byte por registrador PORTx e por bit, e a
+ *  interrupção só escreve registradores inteiros, uma vez por
+ *  bit. O custo da interrupção não depende da quantidade de
+ *  canais, só da quantidade de registradores.
+ *  Usa o TIMER1 configurado pelo fxPwm, tomando sua interrupção.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwmBcm_H
+#define fxPwmBcm_H
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Hal.h>
+
+//Máximo de registradores PORTx diferentes num modulador BCM.
+//Cada registrador ocupa 2 bytes de RAM por bit de resolução (dois planos). Pinos além disso não são modulados.
+#ifndef fxPwm_BcmMaxPorts
+#define fxPwm_BcmMaxPorts 8
+#endif
+
+//Duração padrão do quadro BCM, em microssegundos (a frequência de repetição de cada canal).
+#ifndef fxPwm_BcmFramePeriod
+#define fxPwm_BcmFramePeriod 5000
+#endif
+
+//Modulador BCM com um conjunto fixo de pinos e bits de resolução.
+//Só um modulador pode ter o TIMER1: não use o fxPwm (Start) nem um fxPwmStatic junto com um fxPwmBcm.
+template<UINT8 bits, UINT8... pins>
+class fxPwmBcm{
+  static_assert(bits>=1 && bits<=16, "fxPwmBcm: de 1 a 16 bits");
+private:
+  //Quantidade de canais.
+  static const UINT8 numChannels = sizeof...(pins);
+  //Quantidade de registradores que cabem nos planos.
+  static const UINT8 maxRegs = (sizeof...(pins)<fxPwm_BcmMaxPorts)?(sizeof...(pins)):(fxPwm_BcmMaxPorts);
+  //Maior nível de um canal.
+  static const UINT16 maxLevel = (UINT16)((1UL<<bits) - 1);
+
+  //Pinos, na ordem dos canais.
+  static constexpr UINT8 pinList[sizeof...(pins)] = {pins...};
+
+  //Dados dos canais.
+  static UINT16 level[sizeof...(pins)];
+  static BOOL enabled[sizeof...(pins)];
+  //Registrador de cada canal (índice em regs), ou 0xFF se não coube, e máscara do pino.
+  static UINT8 channelReg[sizeof...(pins)];
+  static BYTE channelMask[sizeof...(pins)];
+
+  //Registradores usados, e os bits de cada um que pertencem ao modulador.
+  static volatile BYTE *regs[maxRegs];
+  static BYTE regMask[maxRegs];
+  static UINT8 numRegs;
+
+  //Planos de bits: valor dos bits do modulador em cada registrador, durante cada bit do nível.
+  //Um em execução (front) e outro para compilação, como as tabelas do agendador FRAME.
+  static BYTE planes[2][bits][maxRegs];
+  static volatile UINT8 front;
+  //Pede à interrupção que troque de plano no início do próximo quadro.
+  static volatile BOOL swap;
+
+  //Duração do bit menos significativo, em ciclos do timer. O bit b dura baseClk<<b.
+  static volatile UINT16 baseClk;
+  //Bit em execução e instante do fim dele (valor do TCNT1).
+  static UINT8 bitIndex;
+  static UINT16 bitCompare;
+
+  //Profundidade do lote aberto. Dentro de um lote os planos não são compilados.
+  static UINT8 batchDepth;
+
+  //Compila os níveis no plano de trás e pede a troca à interrupção.
+  static void Compile(){
+    //A partir daqui a interrupção não troca mais de plano, e front fica parado.
+    swap = FALSE;
+    UINT8 back = front^1;
+    UINT8 t, b;
+    for(b=0;b<bits;b++){
+      for(t=0;t<maxRegs;t++){
+        planes[back][b][t] = 0x00;
+      }
+    }
+    for(t=0;t<numChannels;t++){
+      if(enabled[t]==FALSE || channelReg[t]==0xFF){
+        continue;
+      }
+      UINT16 value = level[t];
+      for(b=0;b<bits && value!=0;b++,value>>=1){
+        if(value&1){
+          planes[back][b][channelReg[t]] |= channelMask[t];
+        }
+      }
+    }
+    swap = TRUE;
+
+    return;
+  }
+
+  //Compila, se não estiver dentro de um lote.
+  static void Update(){
+    if(batchDepth==0){
+      Compile();
+    }
+  }
+
+public:
+  //Retorna o índice do canal de um pino, ou 0xFF se o pino não for deste modulador.
+  static UINT8 GetIndex(UINT8 pin){
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      if(pinList[t]==pin){
+        return t;
+      }
+    }
+    return 0xFF;
+  }
+
+  //Escreve o plano de cada bit vencido e agenda o próximo. Chamado pela interrupção do TIMER1.
+  //O OCR1B é sempre somado da duração do bit, de modo que o quadro não acumula atraso.
+  //Bits mais curtos que minTimerDelta são esperados aqui mesmo, sem outra interrupção.
+  static void Tick(){
+    UINT8 passes = 0;
+    UINT8 r;
+    INT16 wait;
+
+    for(;;){
+      if(bitIndex==0 && swap!=FALSE){
+        //Início do quadro: trocar para os níveis novos.
+        front ^= 1;
+        swap = FALSE;
+      }
+      const BYTE *plane = planes[front][bitIndex];
+      for(r=0;r<numRegs;r++){
+        fxPwm_HAL_Cycles(10);
+        *regs[r] = (BYTE)((*regs[r] & ~regMask[r]) | plane[r]);
+      }
+      bitCompare += (UINT16)(baseClk<<bitIndex);
+      bitIndex = (bitIndex+1>=bits)?(0):(bitIndex+1);
+      passes++;
+
+      wait = (INT16)(UINT16)(bitCompare - TCNT1);
+      if(wait>=(INT16)fxPwm_T1::minTimerDelta){
+        OCR1B = bitCompare;
+        return;
+      }
+      if(passes>=bits){
+        //Um quadro inteiro atrasado nesta chamada: recomeçar a contagem a partir de agora.
+        bitCompare = TCNT1 + fxPwm_T1::minTimerDelta;
+        OCR1B = bitCompare;
+        return;
+      }
+      //Bit curto: esperar o fim dele aqui.
+      while((INT16)(UINT16)(TCNT1 - bitCompare)<0){
+        fxPwm_HAL_Cycles(4);
+      }
+    }
+  }
+
+  //===============================================================
+  //Métodos de inicialização e liberação.
+  //===============================================================
+
+  //Limpa os canais, acha os registradores, configura o TIMER1 e toma sua interrupção.
+  //Os pinos ficam em modo de saída, em nível BAIXO, com nível 0 e desabilitados.
+  void Initialize(){
+    fxPwm_SaveSREG();cli();
+    UINT8 t, r;
+    numRegs = 0;
+    for(t=0;t<numChannels;t++){
+      level[t] = 0;
+      enabled[t] = FALSE;
+      channelReg[t] = 0xFF;
+      channelMask[t] = 0x00;
+      UINT8 portN = digitalPinToPort(pinList[t]);
+      if(portN==NOT_A_PIN){
+        continue;
+      }
+      volatile BYTE *port = portOutputRegister(portN);
+      for(r=0;r<numRegs && regs[r]!=port;r++);
+      if(r==numRegs){
+        if(numRegs>=maxRegs){
+          //Sem espaço nos planos.
+          continue;
+        }
+        regs[r] = port;
+        regMask[r] = 0x00;
+        numRegs++;
+      }
+      channelReg[t] = r;
+      channelMask[t] = digitalPinToBitMask(pinList[t]);
+      regMask[r] |= channelMask[t];
+      *portModeRegister(portN) |= channelMask[t];
+      *port &= (BYTE)~channelMask[t];
+    }
+    front = 0;
+    swap = FALSE;
+    bitIndex = 0;
+    bitCompare = 0;
+    batchDepth = 0;
+    Compile();
+    fxPwm.ConfigureTimer();
+    fxPwm_T1::timerOwner = Tick;
+    fxPwm_RestoreSREG();
+    this->SetFramePeriod(fxPwm_BcmFramePeriod);
+
+    return;
+  }
+
+  //Devolve a interrupção do TIMER1 ao fxPwm, com o timer parado.
+  void Free(){
+    fxPwm_SaveSREG();cli();
+    fxPwm.StopTimer();
+    fxPwm_T1::timerOwner = NULL;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Inicia a contagem do TIMER1. O primeiro quadro começa logo.
+  void Start(){
+    fxPwm_SaveSREG();cli();
+    fxPwm.StartTimer();
+    bitIndex = 0;
+    bitCompare = TCNT1 + fxPwm_T1::minTimerDelta;
+    OCR1B = bitCompare;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Para a contagem do TIMER1. As saídas ficam como estiverem.
+  void Stop(){
+    fxPwm.StopTimer();
+  }
+
+  //===============================================================
+  //Métodos de manipulação dos canais.
+  //===============================================================
+
+  //Atribui a duração do quadro, em microssegundos. Vale para todos os canais.
+  //A duração do bit menos significativo fica entre 1 ciclo do timer e o que faz o bit mais
+  //significativo caber no TIMER1.
+  void SetFramePeriod(TIME_US period){
+    UINT32 base = fxPwm_T1::MicrosToClk(period)/maxLevel;
+    UINT32 high = (UINT32)fxPwm_MaxTimerClkSum>>(bits-1);
+    base = (base<1)?(1):((base>high)?(high):(base));
+    fxPwm_SaveSREG();cli();
+    baseClk = (UINT16)base;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Retorna a duração do quadro, em microssegundos.
+  TIME_US GetFramePeriod(){
+    return fxPwm_T1::ClkToMicros(this->GetFramePeriodClk());
+  }
+  //Retorna a duração do quadro, em ciclos do timer.
+  UINT32 GetFramePeriodClk(){
+    return (UINT32)baseClk*maxLevel;
+  }
+
+  //Atribui o nível de um pino, de 0 até (1<<bits)-1. Vale a partir do próximo quadro.
+  void SetLevel(UINT8 pin, UINT16 newLevel){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF){
+      return;
+    }
+    level[t] = (newLevel>maxLevel)?(maxLevel):(newLevel);
+    Update();
+
+    return;
+  }
+
+  //Atribui o ciclo de trabalho, de 0 (0%) até fxPwm_DUTY16_MAX (100%), arredondado para o nível mais próximo.
+  void SetDuty16(UINT8 pin, UINT16 duty16){
+    this->SetLevel(pin, (UINT16)(((UINT32)duty16*maxLevel + fxPwm_DUTY16_MAX/2)/fxPwm_DUTY16_MAX));
+  }
+
+#ifndef fxPwm_NO_FLOAT
+  //Atribui o ciclo de trabalho, de 0.0 (0%) até 1.0 (100%).
+  void SetDuty(UINT8 pin, FLOAT duty){
+    duty = (duty<0.0)?(0.0):((duty>1.0)?(1.0):(duty));
+    this->SetLevel(pin, (UINT16)(duty*(FLOAT)maxLevel + 0.5));
+  }
+#endif
+
+  //Ativa a saída de modulação em um pino, a partir do próximo quadro.
+  void EnablePin(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF || enabled[t]!=FALSE){
+      return;
+    }
+    enabled[t] = TRUE;
+    Update();
+
+    return;
+  }
+
+  //Desativa a saída de modulação em um pino. O pino fica em nível BAIXO a partir do próximo quadro.
+  void DisablePin(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF || enabled[t]==FALSE){
+      return;
+    }
+    enabled[t] = FALSE;
+    Update();
+
+    return;
+  }
+
+  //Ativa todos os pinos, no mesmo quadro.
+  void EnableAll(){
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      enabled[t] = TRUE;
+    }
+    Update();
+
+    return;
+  }
+
+  //Desativa todos os pinos, no mesmo quadro.
+  void DisableAll(){
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      enabled[t] = FALSE;
+    }
+    Update();
+
+    return;
+  }
+
+  //Começa (ou aninha) um lote de mudanças. Os planos só são compilados no EndUpdate() mais externo,
+  //uma vez para o lote inteiro, e os níveis novos entram todos no mesmo quadro.
+  void BeginUpdate(){
+    if(batchDepth<0xFF){
+      batchDepth++;
+    }
+
+    return;
+  }
+
+  //Fecha um lote de mudanças.
+  void EndUpdate(){
+    if(batchDepth==0){
+      return;
+    }
+    batchDepth--;
+    Update();
+
+    return;
+  }
+
+  //===============================================================
+  //Métodos de aquisição de informação.
+  //===============================================================
+
+  //Retorna a quantidade de pinos.
+  UINT8 GetNumRegisteredPorts(){
+    return numChannels;
+  }
+
+  //Retorna a quantidade de bits de resolução.
+  UINT8 GetBits(){
+    return bits;
+  }
+
+  //Retorna o nível de um pino.
+  UINT16 GetLevel(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    return (t==0xFF)?(0):(level[t]);
+  }
+
+  //Retorna o ciclo de trabalho de um pino, de 0 até fxPwm_DUTY16_MAX.
+  UINT16 GetRawDuty16(UINT8 pin){
+    return (UINT16)(((UINT32)this->GetLevel(pin)*fxPwm_DUTY16_MAX + maxLevel/2)/maxLevel);
+  }
+
+#ifndef fxPwm_NO_FLOAT
+  //Retorna o ciclo de trabalho de um pino, de 0.0 até 1.0.
+  FLOAT GetDuty(UINT8 pin){
+    return (FLOAT)this->GetLevel(pin)/(FLOAT)maxLevel;
+  }
+#endif
+};
+
+//Definições dos membros estáticos.
+template<UINT8 bits, UINT8... pins> constexpr UINT8 fxPwmBcm<bits, pins...>::pinList[sizeof...(pins)];
+template<UINT8 bits, UINT8... pins> UINT16 fxPwmBcm<bits, pins...>::level[sizeof...(pins)];
+template<UINT8 bits, UINT8... pins> BOOL fxPwmBcm<bits, pins...>::enabled[sizeof...(pins)];
+template<UINT8 bits, UINT8... pins> UINT8 fxPwmBcm<bits, pins...>::channelReg[sizeof...(pins)];
+template<UINT8 bits, UINT8... pins> BYTE fxPwmBcm<bits, pins...>::channelMask[sizeof...(pins)];
+template<UINT8 bits, UINT8... pins> volatile BYTE *fxPwmBcm<bits, pins...>::regs[fxPwmBcm<bits, pins...>::maxRegs];
+template<UINT8 bits, UINT8... pins> BYTE fxPwmBcm<bits, pins...>::regMask[fxPwmBcm<bits, pins...>::maxRegs];
+template<UINT8 bits, UINT8... pins> UINT8 fxPwmBcm<bits, pins...>::numRegs;
+template<UINT8 bits, UINT8... pins> BYTE fxPwmBcm<bits, pins...>::planes[2][bits][fxPwmBcm<bits, pins...>::maxRegs];
+template<UINT8 bits, UINT8... pins> volatile UINT8 fxPwmBcm<bits, pins...>::front;
+template<UINT8 bits, UINT8... pins> volatile BOOL fxPwmBcm<bits, pins...>::swap;
+template<UINT8 bits, UINT8... pins> volatile UINT16 fxPwmBcm<bits, pins...>::baseClk;
+template<UINT8 bits, UINT8... pins> UINT8 fxPwmBcm<bits, pins...>::bitIndex;
+template<UINT8 bits, UINT8... pins> UINT16 fxPwmBcm<bits, pins...>::bitCompare;
+template<UINT8 bits, UINT8... pins> UINT8 fxPwmBcm<bits, pins...>::batchDepth;
+
+#endif
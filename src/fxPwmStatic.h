@@ -0,0 +1,459 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwmStatic.h
+ *  Modulador PWM por software com os pinos fixados em tempo de
+ *  compilação: fxPwmStatic<2, 3, 4, 5> pwm;
+ *  Os registradores e máscaras de cada pino são constantes, os
+ *  dados de cada canal ficam em vetores estáticos (sem ponteiros
+ *  para portas), e o Tick() é desenrolado canal a canal, com
+ *  escritas diretas de um bit (sbi/cbi no AVR).
+ *  Usa o TIMER1 configurado pelo fxPwm, tomando sua interrupção.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: comparações de tempo pela diferença com sinal, como no fxPwm.
+ */
+
+#ifndef fxPwmStatic_H
+#define fxPwmStatic_H
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Hal.h>
+
+//Índice de canal como tipo, para desenrolar os laços em tempo de compilação.
+template<UINT8 index> struct fxPwm_StaticIndex{};
+
+//Modulador com um conjunto fixo de pinos.
+//Só um modulador pode ter o TIMER1: não use o fxPwm (Start) junto com um fxPwmStatic.
+template<UINT8... pins>
+class fxPwmStatic{
+private:
+  //Quantidade de canais.
+  static const UINT8 numChannels = sizeof...(pins);
+
+  //Pinos, na ordem dos canais.
+  static constexpr UINT8 pinList[sizeof...(pins)] = {pins...};
+
+  //Dados dos canais, um elemento por pino.
+  //Os mesmos campos de fxPwm_Port, inclusive os períodos pedidos (shadowHigh, shadowLow, shadowSeq).
+  static volatile BOOL enabled[sizeof...(pins)];
+  static volatile BYTE outHint[sizeof...(pins)];
+  static volatile TIME_CLOCK next[sizeof...(pins)];
+  static volatile BOOL scheduled[sizeof...(pins)];
+  static volatile TIME_CLOCK highPeriod[sizeof...(pins)];
+  static volatile TIME_CLOCK lowPeriod[sizeof...(pins)];
+  static volatile TIME_CLOCK shadowHigh[sizeof...(pins)];
+  static volatile TIME_CLOCK shadowLow[sizeof...(pins)];
+  static volatile UINT8 shadowSeq[sizeof...(pins)];
+  static UINT8 latchedSeq[sizeof...(pins)];
+  static UINT32 periodClk[sizeof...(pins)];
+  static UINT16 duty16[sizeof...(pins)];
+
+  //Último valor registrado de TCNT1.
+  static volatile UINT16 lastClock;
+  //Contagem dos ciclos de clock do TIMER1.
+  static volatile TIME_CLOCK clockCount;
+
+  //Atualiza clockCount a partir do TCNT1.
+  static inline UINT16 UpdateClock(){
+    UINT16 lastTCNT1 = TCNT1;
+    clockCount += (TIME_CLOCK)(UINT16)(lastTCNT1 - lastClock);
+    lastClock = lastTCNT1;
+    return lastTCNT1;
+  }
+
+  //Troca o nível de um canal cujo evento venceu e calcula seu próximo evento.
+  //Mesma lógica de fxPwm_T1::ProcessEdge(), com o registrador resolvido pelo compilador.
+  template<UINT8 I>
+  static inline void ProcessEdge(){
+    fxPwm_HAL_Cycles(14);
+    if(outHint[I] && lowPeriod[I]>0){
+      fxPwm_HAL_PinPort(pinList[I]) &= (BYTE)~fxPwm_HAL_PinMask(pinList[I]);
+      next[I] += lowPeriod[I];
+      outHint[I] = 0x00;
+      return;
+    }
+
+    //Início de um período: aplicar os períodos pedidos, se estiverem completos.
+    UINT8 seq = shadowSeq[I];
+    if(seq!=latchedSeq[I] && (seq&1)==0){
+      fxPwm_HAL_Cycles(10);
+      highPeriod[I] = shadowHigh[I];
+      lowPeriod[I] = shadowLow[I];
+      latchedSeq[I] = seq;
+    }
+
+    if(highPeriod[I]>0){
+      fxPwm_HAL_PinPort(pinList[I]) |= fxPwm_HAL_PinMask(pinList[I]);
+      next[I] += highPeriod[I];
+      outHint[I] = 0xFF;
+    }else{
+      //Ciclo de 0%.
+      fxPwm_HAL_PinPort(pinList[I]) &= (BYTE)~fxPwm_HAL_PinMask(pinList[I]);
+      next[I] += lowPeriod[I];
+      outHint[I] = 0x00;
+    }
+
+    return;
+  }
+
+  //Processa um canal, se estiver habilitado e vencido, e segue para o próximo.
+  template<UINT8 I>
+  static inline void TickChannel(TIME_CLOCK &nextEvent, fxPwm_StaticIndex<I>){
+    fxPwm_HAL_Cycles(6);
+    if(scheduled[I]!=FALSE){
+      if(fxPwm_TIME_REACHED(clockCount, next[I])){
+        ProcessEdge<I>();
+      }
+      nextEvent = (fxPwm_TIME_BEFORE(next[I], nextEvent))?(next[I]):(nextEvent);
+    }
+    TickChannel(nextEvent, fxPwm_StaticIndex<I+1>());
+  }
+  //Fim da lista de canais.
+  static inline void TickChannel(TIME_CLOCK &nextEvent, fxPwm_StaticIndex<sizeof...(pins)>){
+    (void)nextEvent;
+  }
+
+  //Seta o próximo evento, mas apenas se for anterior ao mais próximo agendado.
+  //Deve ser chamado com interrupções desabilitadas.
+  static void SetNextFireMin(TIME_CLOCK event){
+    if(fxPwm_TIME_REACHED(clockCount, event)){
+      OCR1B = TCNT1 + 1;
+      return;
+    }
+    TIME_CLOCK currentDif = (OCR1B==TCNT1)?(65536):((TIME_CLOCK)(UINT16)(OCR1B - TCNT1));
+    TIME_CLOCK newDif = event - clockCount;
+    if(newDif<currentDif){
+      OCR1B = TCNT1 + (UINT16)newDif;
+    }
+  }
+
+public:
+  //Retorna o índice do canal de um pino, ou 0xFF se o pino não for deste modulador.
+  static UINT8 GetIndex(UINT8 pin){
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      if(pinList[t]==pin){
+        return t;
+      }
+    }
+    return 0xFF;
+  }
+
+  //Resolve tudo que der nas saídas. Chamado pela interrupção do TIMER1.
+  static void Tick(){
+    UpdateClock();
+
+    //Deadline de execução dessa função. Para evitar que se perca eternamente aqui.
+    TIME_CLOCK deadline = clockCount + fxPwm_T1::maxTimerDuration;
+    //Próximo evento previsto.
+    TIME_CLOCK nextEvent;
+
+    do{
+      UpdateClock();
+      nextEvent = clockCount + fxPwm_T1::maxTimerPeriod;
+      TickChannel(nextEvent, fxPwm_StaticIndex<0>());
+    }while(fxPwm_TIME_DIFF(clockCount, nextEvent-fxPwm_T1::minTimerGap)>0 && fxPwm_TIME_BEFORE(clockCount, deadline));
+
+    //Agendar próxima chamada, não antes que minTimerDelta do tempo atual.
+    UINT16 lastTCNT1 = UpdateClock();
+    if(fxPwm_TIME_BEFORE(nextEvent, clockCount+fxPwm_T1::minTimerDelta)){
+      OCR1B = lastTCNT1 + fxPwm_T1::minTimerDelta;
+    }else{
+      OCR1B = lastTCNT1 + (UINT16)(nextEvent - clockCount);
+    }
+
+    return;
+  }
+
+  //===============================================================
+  //Métodos de inicialização e liberação.
+  //===============================================================
+
+  //Limpa os canais, configura o TIMER1 e toma sua interrupção.
+  //Os pinos ficam em modo de saída, em nível BAIXO.
+  void Initialize(){
+    fxPwm_SaveSREG();cli();
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      enabled[t] = FALSE;
+      outHint[t] = 0x00;
+      next[t] = fxPwm_NO_NEXT_EVENT;
+      scheduled[t] = FALSE;
+      highPeriod[t] = 0;
+      lowPeriod[t] = 0;
+      shadowHigh[t] = 0;
+      shadowLow[t] = 0;
+      shadowSeq[t] = 0;
+      latchedSeq[t] = 0;
+      periodClk[t] = 0;
+      duty16[t] = fxPwm_DUTY16_MAX/2 + 1;
+      *portModeRegister(digitalPinToPort(pinList[t])) |= digitalPinToBitMask(pinList[t]);
+      *portOutputRegister(digitalPinToPort(pinList[t])) &= (BYTE)~digitalPinToBitMask(pinList[t]);
+    }
+    lastClock = 0;
+    clockCount = 0;
+    fxPwm.ConfigureTimer();
+    fxPwm_T1::timerOwner = Tick;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Devolve a interrupção do TIMER1 ao fxPwm, com o timer parado.
+  void Free(){
+    fxPwm_SaveSREG();cli();
+    fxPwm.StopTimer();
+    fxPwm_T1::timerOwner = NULL;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Inicia a contagem do TIMER1 e agenda os canais habilitados.
+  void Start(){
+    fxPwm_SaveSREG();cli();
+    fxPwm.StartTimer();
+    UpdateClock();
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      if(enabled[t]!=FALSE && periodClk[t]!=0){
+        next[t] = clockCount;
+        scheduled[t] = TRUE;
+      }
+    }
+    OCR1B = TCNT1 + fxPwm_T1::minTimerDelta;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Para a contagem do TIMER1.
+  void Stop(){
+    fxPwm.StopTimer();
+  }
+
+  //===============================================================
+  //Métodos de manipulação dos canais.
+  //===============================================================
+
+  //Atribui período, em ciclos do timer, e ciclo de trabalho de 16 bits a um pino.
+  //Mesmo comportamento de fxPwm_Port::SetPeriodClkAndDuty16(): um canal modulando
+  //só troca de período no início do próximo, sem desabilitar interrupções.
+  void SetPeriodClkAndDuty16(UINT8 pin, UINT32 newPeriodClk, UINT16 newDuty16){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF){
+      return;
+    }
+    //Períodos longos demais quebrariam as comparações de tempo.
+    if((TIME_CLOCK)newPeriodClk>fxPwm_MAX_PERIOD_CLK){
+      newPeriodClk = (UINT32)fxPwm_MAX_PERIOD_CLK;
+    }
+
+    //periodClk*duty16/65536 em duas multiplicações de 32 bits, sem estourar.
+    UINT32 high = (newDuty16==fxPwm_DUTY16_MAX)?(newPeriodClk):
+      ((newPeriodClk>>16)*(UINT32)newDuty16 + (((newPeriodClk&0xFFFF)*(UINT32)newDuty16)>>16));
+    UINT32 low = newPeriodClk - high;
+
+    if(newPeriodClk!=0 && enabled[t]!=FALSE && periodClk[t]!=0){
+      //Modulando: entregar pelo contador de sequência.
+      periodClk[t] = newPeriodClk;
+      duty16[t] = newDuty16;
+      shadowSeq[t]++;
+      shadowHigh[t] = high;
+      shadowLow[t] = low;
+      shadowSeq[t]++;
+      return;
+    }
+
+    fxPwm_SaveSREG();cli();
+    periodClk[t] = newPeriodClk;
+    duty16[t] = newDuty16;
+    highPeriod[t] = high;
+    lowPeriod[t] = low;
+    shadowHigh[t] = high;
+    shadowLow[t] = low;
+    latchedSeq[t] = shadowSeq[t];
+    if(newPeriodClk==0){
+      //Sem período: nível fixo de acordo com o duty.
+      next[t] = fxPwm_NO_NEXT_EVENT;
+      scheduled[t] = FALSE;
+      if(enabled[t]!=FALSE){
+        if(newDuty16>fxPwm_DUTY16_MAX/2){
+          *portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+        }else{
+          *portOutputRegister(digitalPinToPort(pin)) &= (BYTE)~digitalPinToBitMask(pin);
+        }
+      }
+    }else if(enabled[t]!=FALSE){
+      UpdateClock();
+      next[t] = clockCount;
+      scheduled[t] = TRUE;
+      SetNextFireMin(next[t]);
+    }
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Atribui o período, em ciclos do timer.
+  void SetPeriodClk(UINT8 pin, UINT32 periodClk){
+    this->SetPeriodClkAndDuty16(pin, periodClk, this->GetRawDuty16(pin));
+  }
+  //Atribui o período, em microssegundos.
+  void SetPeriod(UINT8 pin, TIME_US period){
+    this->SetPeriodClkAndDuty16(pin, fxPwm_T1::MicrosToClk(period), this->GetRawDuty16(pin));
+  }
+  //Atribui o ciclo de trabalho, de 0 (0%) até fxPwm_DUTY16_MAX (100%).
+  void SetDuty16(UINT8 pin, UINT16 duty16){
+    this->SetPeriodClkAndDuty16(pin, this->GetPeriodClk(pin), duty16);
+  }
+
+#ifndef fxPwm_NO_FLOAT
+  //Atribui a frequência, em hertz.
+  void SetFrequency(UINT8 pin, FLOAT frequency){
+    this->SetPeriod(pin, (frequency<=0.0)?(0):((TIME_US)(1000000.0/(FLOAT)frequency+0.5)));
+  }
+  //Atribui o ciclo de trabalho, de 0.0 (0%) até 1.0 (100%).
+  void SetDuty(UINT8 pin, FLOAT duty){
+    duty = (duty<0.0)?(0.0):((duty>1.0)?(1.0):(duty));
+    this->SetDuty16(pin, (UINT16)(duty*(FLOAT)fxPwm_DUTY16_MAX + 0.5));
+  }
+#endif
+
+  //Ativa a saída de modulação em um pino. O pino começa em nível BAIXO.
+  void EnablePin(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF || enabled[t]!=FALSE){
+      return;
+    }
+    fxPwm_SaveSREG();cli();
+    *portOutputRegister(digitalPinToPort(pin)) &= (BYTE)~digitalPinToBitMask(pin);
+    outHint[t] = 0x00;
+    if(periodClk[t]==0){
+      next[t] = fxPwm_NO_NEXT_EVENT;
+      scheduled[t] = FALSE;
+    }else{
+      UpdateClock();
+      next[t] = clockCount;
+      scheduled[t] = TRUE;
+      SetNextFireMin(next[t]);
+    }
+    enabled[t] = TRUE;
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Desativa a saída de modulação em um pino, deixando-o em nível BAIXO.
+  void DisablePin(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    if(t==0xFF){
+      return;
+    }
+    fxPwm_SaveSREG();cli();
+    enabled[t] = FALSE;
+    next[t] = fxPwm_NO_NEXT_EVENT;
+    scheduled[t] = FALSE;
+    outHint[t] = 0x00;
+    *portOutputRegister(digitalPinToPort(pin)) &= (BYTE)~digitalPinToBitMask(pin);
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Ativa todos os pinos, começando todos no mesmo instante.
+  void EnableAll(){
+    fxPwm_SaveSREG();cli();
+    UpdateClock();
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      if(enabled[t]!=FALSE){
+        continue;
+      }
+      *portOutputRegister(digitalPinToPort(pinList[t])) &= (BYTE)~digitalPinToBitMask(pinList[t]);
+      outHint[t] = 0x00;
+      next[t] = (periodClk[t]==0)?(fxPwm_NO_NEXT_EVENT):(clockCount);
+      scheduled[t] = (periodClk[t]==0)?(FALSE):(TRUE);
+      enabled[t] = TRUE;
+    }
+    SetNextFireMin(clockCount);
+    fxPwm_RestoreSREG();
+
+    return;
+  }
+
+  //Desativa todos os pinos.
+  void DisableAll(){
+    UINT8 t;
+    for(t=0;t<numChannels;t++){
+      this->DisablePin(pinList[t]);
+    }
+
+    return;
+  }
+
+  //===============================================================
+  //Métodos de aquisição de informação.
+  //===============================================================
+
+  //Retorna a quantidade de pinos.
+  UINT8 GetNumRegisteredPorts(){
+    return numChannels;
+  }
+
+  //Retorna o período de um pino, em ciclos do timer.
+  UINT32 GetPeriodClk(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    return (t==0xFF)?(0):(periodClk[t]);
+  }
+  //Retorna o período de um pino, em microssegundos.
+  TIME_US GetPeriod(UINT8 pin){
+    return fxPwm_T1::ClkToMicros(this->GetPeriodClk(pin));
+  }
+  //Retorna o ciclo de trabalho de um pino, de 0 até fxPwm_DUTY16_MAX.
+  UINT16 GetRawDuty16(UINT8 pin){
+    UINT8 t = GetIndex(pin);
+    return (t==0xFF)?(0):(duty16[t]);
+  }
+
+#ifndef fxPwm_NO_FLOAT
+  //Retorna a frequência de um pino, em hertz.
+  FLOAT GetFrequency(UINT8 pin){
+    UINT32 period = this->GetPeriodClk(pin);
+    return (period==0)?(0.0):(1000000000.0/((FLOAT)period*(FLOAT)fxPwm_T1::nsPerTimerClock));
+  }
+  //Retorna o ciclo de trabalho de um pino, de 0.0 até 1.0.
+  FLOAT GetDuty(UINT8 pin){
+    return (FLOAT)this->GetRawDuty16(pin)/(FLOAT)fxPwm_DUTY16_MAX;
+  }
+#endif
+
+  //Retorna a contagem de tempo, em microssegundos, do TIMER1.
+  TIME_US Micros(){
+    return fxPwm_T1::ClkToMicros(clockCount);
+  }
+};
+
+//Definições dos membros estáticos.
+template<UINT8... pins> constexpr UINT8 fxPwmStatic<pins...>::pinList[sizeof...(pins)];
+template<UINT8... pins> volatile BOOL fxPwmStatic<pins...>::enabled[sizeof...(pins)];
+template<UINT8... pins> volatile BYTE fxPwmStatic<pins...>::outHint[sizeof...(pins)];
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::next[sizeof...(pins)];
+template<UINT8... pins> volatile BOOL fxPwmStatic<pins...>::scheduled[sizeof...(pins)];
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::highPeriod[sizeof...(pins)];
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::lowPeriod[sizeof...(pins)];
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::shadowHigh[sizeof...(pins)];
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::shadowLow[sizeof...(pins)];
+template<UINT8... pins> volatile UINT8 fxPwmStatic<pins...>::shadowSeq[sizeof...(pins)];
+template<UINT8... pins> UINT8 fxPwmStatic<pins...>::latchedSeq[sizeof...(pins)];
+template<UINT8... pins> UINT32 fxPwmStatic<pins...>::periodClk[sizeof...(pins)];
+template<UINT8... pins> UINT16 fxPwmStatic<pins...>::duty16[sizeof...(pins)];
+template<UINT8... pins> volatile UINT16 fxPwmStatic<pins...>::lastClock;
+template<UINT8... pins> volatile TIME_CLOCK fxPwmStatic<pins...>::clockCount;
+
+#endif
@@ -14,17 +14,20 @@
  *  -----------------------------------------------------------
  *  17-07-2018: primeira documentação
  *  21-07-2018: adição do tipo UINT64 e INT64.
+ *  17-10-2026: tipos de largura fixa (stdint) e inclusão da camada de abstração de hardware.
+ *  17-10-2026: opção fxPwm_NO_FLOAT.
+ *  17-10-2026: TIME_CLOCK_DIFF, diferença com sinal entre tempos.
  */
 
 #ifndef FXPWMTYPES_H
 #define FXPWMTYPES_H
 
-#include "arduino.h"
+#include <fxPwm_Hal.h>
 
-typedef unsigned char BYTE;
+typedef uint8_t BYTE;
 
-typedef unsigned char UINT8;
-typedef signed char INT8;
+typedef uint8_t UINT8;
+typedef int8_t INT8;
 
 #ifndef UINT8_MAX
 #define UINT8_MAX 255
@@ -40,8 +43,8 @@ typedef signed char INT8;
 #define INT8_MIN -128
 #endif
 
-typedef unsigned int UINT16;
-typedef signed int INT16;
+typedef uint16_t UINT16;
+typedef int16_t INT16;
 
 #ifndef UINT16_MAX
 #define UINT16_MAX 65535
@@ -57,8 +60,8 @@ typedef signed int INT16;
 #define INT16_MIN -32768
 #endif
 
-typedef unsigned long UINT32;
-typedef signed long INT32;
+typedef uint32_t UINT32;
+typedef int32_t INT32;
 
 #ifndef UINT32_MAX
 #define UINT32_MAX 4294967295
@@ -91,7 +94,13 @@ typedef int64_t INT64;
 #define INT64_MIN -9223372036854775808
 #endif
 
+//Descomente (ou defina antes de compilar) para retirar da biblioteca todas as funções com FLOAT.
+//Sobram as funções inteiras (SetPeriodClk, SetDuty16, SetMap16...), e o ponto flutuante por software não é ligado.
+//#define fxPwm_NO_FLOAT
+
+#ifndef fxPwm_NO_FLOAT
 typedef float FLOAT;
+#endif
 
 #ifdef TIME_IS_64
 
@@ -105,6 +114,7 @@ typedef UINT64 TIME_US;
 #endif
 
 typedef UINT64 TIME_CLOCK;
+typedef INT64 TIME_CLOCK_DIFF;
 
 #ifndef TIME_CLOCK_MAX
 #define TIME_CLOCK_MAX UINT64_MAX
@@ -125,6 +135,7 @@ typedef UINT32 TIME_US;
 #endif
 
 typedef UINT32 TIME_CLOCK;
+typedef INT32 TIME_CLOCK_DIFF;
 
 #ifndef TIME_CLOCK_MAX
 #define TIME_CLOCK_MAX UINT32_MAX
@@ -146,4 +157,4 @@ typedef bool BOOL;
 #endif
 
 #endif
-
+
@@ -0,0 +1,411 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Frame.cpp
+ *  Agendador por tabela de bordas pré-compilada (fxPwm_Scheduler
+ *  igual a fxPwm_SCHEDULER_FRAME).
+ *  Sempre que uma porta muda, todas as portas habilitadas são
+ *  compiladas numa tabela de entradas (espera, registrador,
+ *  bits a setar, bits a limpar) que cobre o hiperperíodo.
+ *  O Tick() só executa a entrada atual e avança o índice.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: tabela nova só começa no início do hiperperíodo. Usa os períodos pedidos (shadowHigh, shadowLow).
+ *  17-10-2026: estatísticas (fxPwm_STATS): cada entrada com escrita conta como uma borda.
+ *  17-10-2026: grupos travados (fxPwm_LockGroup) entram na tabela com as escritas da sua última tabela.
+ *  17-10-2026: vindo do SCAN, a tabela espera o maior tempo morto dos grupos travados, com os pinos deles em BAIXO.
+ *  17-10-2026: portas em modo PDM não cabem na tabela: com uma delas habilitada, o SCAN é usado.
+ *  17-10-2026: registradores do timer do motor (fxPwm_HAL_Timer). Escritas em PORTx atômicas.
+ *  17-10-2026: portas no PWM por hardware ficam fora da tabela.
+ *  17-10-2026: portas com trajetória não cabem na tabela: com uma delas habilitada, o SCAN é usado.
+ *  17-10-2026: motor com fila de comandos (fxPwm_Queue) usa o SCAN.
+ *  17-10-2026: modo fatiado (fxPwm_SliceBudget): no fim da fatia a tabela continua da mesma entrada, sem escorregar.
+ *  17-10-2026: sem tabela, as portas só recomeçam na volta da tabela para o SCAN, e não a cada mudança.
+ *  17-10-2026: no modo fatiado, atraso da tabela medido na largura do TIME_CLOCK, e não em INT16.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_Hal.h>
+
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+
+//Máximo divisor comum, para o cálculo do hiperperíodo.
+static UINT32 fxPwm_Gcd(UINT32 a, UINT32 b){
+  while(b!=0){
+    UINT32 r = a%b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+//Indica se a porta participa da tabela.
+inline BOOL fxPwm_T1::FrameIncludes(fxPwm_Port *port){
+  return (port->enabled!=FALSE && port->pdm==FALSE && port->hw==FALSE && port->port!=NULL && (port->shadowHigh+port->shadowLow)>0)?(TRUE):(FALSE);
+}
+
+//Indica se o grupo travado de uma porta participa da tabela. Retorna a última tabela do grupo, ou NULL.
+fxPwm_LockEdge *fxPwm_T1::FrameLock(fxPwm_Port *port, UINT8 *length, UINT32 *period){
+  fxPwm_LockGroup *lock = port->lockGroup;
+  if(port->enabled==FALSE){
+    return NULL;
+  }
+  UINT8 latest = lock->Latest();
+  *length = lock->length[latest];
+  *period = lock->period[latest];
+
+  return (*length>0)?(lock->edges[latest]):(NULL);
+}
+
+//Acrescenta uma escrita no grupo de entradas do instante atual (a partir de groupStart).
+//Escritas no mesmo registrador são juntadas numa entrada só.
+static BOOL fxPwm_FrameWrite(fxPwm_FrameEntry *frame, UINT8 *length, UINT8 groupStart, volatile BYTE *port, BYTE setMask, BYTE clearMask){
+  UINT8 t;
+  for(t=groupStart;t<*length;t++){
+    if(frame[t].port==port){
+      frame[t].setMask |= setMask;
+      frame[t].clearMask |= clearMask;
+      return TRUE;
+    }
+  }
+
+  if(*length>=fxPwm_FrameMaxEntries){
+    //Não cabe.
+    return FALSE;
+  }
+
+  frame[*length].delta = 0;
+  frame[*length].port = port;
+  frame[*length].setMask = setMask;
+  frame[*length].clearMask = clearMask;
+  (*length)++;
+
+  return TRUE;
+}
+
+//Atribui a espera até o próximo grupo na última entrada.
+//Esperas maiores que fxPwm_MaxTimerClkSum são quebradas em entradas vazias.
+static BOOL fxPwm_FrameWait(fxPwm_FrameEntry *frame, UINT8 *length, UINT32 delta){
+  while(delta>fxPwm_MaxTimerClkSum){
+    frame[*length-1].delta = fxPwm_MaxTimerClkSum;
+    delta -= fxPwm_MaxTimerClkSum;
+    if(*length>=fxPwm_FrameMaxEntries){
+      return FALSE;
+    }
+    frame[*length].port = NULL;
+    frame[*length].setMask = 0x00;
+    frame[*length].clearMask = 0x00;
+    (*length)++;
+  }
+  frame[*length-1].delta = (UINT16)delta;
+
+  return TRUE;
+}
+
+//Compila as portas habilitadas numa tabela, com os últimos períodos pedidos.
+//Cada porta oscilante sobe no instante 0 de cada período e desce após highPeriod.
+//Portas com 0% ou 100% só recebem uma escrita no instante 0.
+//Retorna FALSE se a tabela não couber em fxPwm_FrameMaxEntries, ou se houver porta PDM habilitada
+//(o passo do PDM é feito pelo Tick() do SCAN).
+BOOL fxPwm_T1::CompileFrame(fxPwm_FrameEntry *frame, UINT8 *length){
+  fxPwm_Port **portIndex;
+  fxPwm_Port *port;
+  UINT64 hyper = 1;
+  UINT32 period;
+  fxPwm_LockEdge *lockEdges;
+  UINT8 lockLength, e;
+
+  *length = 0;
+
+  if(this->queue!=NULL){
+    //Os comandos da fila são executados pelo Tick(), que então funciona como SCAN.
+    return FALSE;
+  }
+
+  //Hiperperíodo: MMC dos períodos das portas que oscilam.
+  for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+    if((port->pdm!=FALSE || port->trajectory!=NULL || port->glide!=NULL) && port->enabled!=FALSE){
+      //O passo do PDM, o da trajetória e o da varredura são do Tick(), por porta.
+      return FALSE;
+    }
+    if(port->lockGroup!=NULL){
+      //Grupo travado: só o período do grupo.
+      if(this->FrameLock(port, &lockLength, &period)==NULL){
+        continue;
+      }
+    }else if(this->FrameIncludes(port)==FALSE || port->shadowHigh==0 || port->shadowLow==0){
+      continue;
+    }else{
+      period = port->shadowHigh + port->shadowLow;
+    }
+    hyper = (hyper/fxPwm_Gcd((UINT32)hyper, period))*period;
+    if(hyper>0x7FFFFFFF){
+      //Longo demais.
+      return FALSE;
+    }
+  }
+  if(hyper==1){
+    //Nada oscila. Só reafirmar os níveis de tempos em tempos.
+    hyper = maxTimerPeriod;
+  }
+
+  //Percorre os instantes de borda em ordem.
+  UINT32 t = 0;
+  UINT32 nextT, r, edge;
+  UINT8 groupStart;
+  do{
+    groupStart = *length;
+    nextT = (UINT32)hyper;
+
+    for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+      if(port->lockGroup!=NULL){
+        //Grupo travado: as escritas da tabela do grupo neste instante, e a próxima.
+        if((lockEdges = this->FrameLock(port, &lockLength, &period))==NULL){
+          continue;
+        }
+        r = t%period;
+        edge = t - r + period;
+        for(e=0;e<lockLength;e++){
+          if(lockEdges[e].offset==r){
+            if(fxPwm_FrameWrite(frame, length, groupStart, lockEdges[e].port, lockEdges[e].setMask, lockEdges[e].clearMask)==FALSE){
+              return FALSE;
+            }
+          }else if(lockEdges[e].offset>r){
+            edge = t - r + lockEdges[e].offset;
+            break;
+          }
+        }
+        nextT = (edge<nextT)?(edge):(nextT);
+        continue;
+      }
+      if(this->FrameIncludes(port)==FALSE){
+        continue;
+      }
+
+      if(port->shadowHigh==0 || port->shadowLow==0){
+        //Nível fixo.
+        if(t==0 && fxPwm_FrameWrite(frame, length, groupStart, port->port,
+            (port->shadowLow==0)?(port->mask):(0x00), (port->shadowLow==0)?(0x00):(port->mask))==FALSE){
+          return FALSE;
+        }
+        continue;
+      }
+
+      period = port->shadowHigh + port->shadowLow;
+      r = t%period;
+      if(r==0){
+        if(fxPwm_FrameWrite(frame, length, groupStart, port->port, port->mask, 0x00)==FALSE){
+          return FALSE;
+        }
+      }else if(r==port->shadowHigh){
+        if(fxPwm_FrameWrite(frame, length, groupStart, port->port, 0x00, port->mask)==FALSE){
+          return FALSE;
+        }
+      }
+
+      //Próxima borda desta porta.
+      edge = (r<port->shadowHigh)?(t - r + port->shadowHigh):(t - r + period);
+      nextT = (edge<nextT)?(edge):(nextT);
+    }
+
+    if(*length==groupStart){
+      //Nenhuma escrita neste instante: só acontece em t=0 sem portas.
+      if(fxPwm_FrameWrite(frame, length, groupStart, NULL, 0x00, 0x00)==FALSE){
+        return FALSE;
+      }
+    }
+
+    if(fxPwm_FrameWait(frame, length, nextT - t)==FALSE){
+      return FALSE;
+    }
+    t = nextT;
+  }while(t<hyper);
+
+  return TRUE;
+}
+
+//Recompila a tabela se alguma porta mudou.
+//Se couber, pede ao Tick() que troque de tabela no início do próximo hiperperíodo (ou logo, se estiver no SCAN).
+//Se não couber, volta a funcionar como SCAN.
+void fxPwm_T1::UpdateFrame(){
+  if(this->frameDirty==FALSE || this->IsAllocated()==FALSE || this->batchDepth>0){
+    //Nada mudou, ou dentro de um lote (o EndUpdate() chama de novo).
+    return;
+  }
+
+  UINT8 back;
+  BOOL compiled;
+
+  //A tabela de trás vai ser reescrita: cancelar qualquer troca pendente.
+  //São escritas de um byte, e o Tick() só mexe em frameFront se frameSwap estiver setado.
+  this->frameSwap = FALSE;
+  this->frameDirty = FALSE;
+  back = this->frameFront^1;
+
+  //Compilação com interrupções no estado de quem chamou.
+  compiled = this->CompileFrame(this->frames[back], &this->frameLength[back]);
+
+  if(compiled!=FALSE){
+    this->frameSwap = TRUE;
+    if(this->frameActive==FALSE){
+      //Vindo do SCAN: começar a tabela o quanto antes.
+      fxPwm_SaveSREG();cli();
+      this->SetNextFireMin(this->clockCount);
+      fxPwm_RestoreSREG();
+    }
+    return;
+  }
+
+  //Não coube. Se a tabela estava em execução, recomeçar todas portas pelo SCAN.
+  fxPwm_Port **portIndex;
+  fxPwm_Port *port;
+  fxPwm_SaveSREG();cli();
+  if(this->frameActive==FALSE){
+    //Já no SCAN: as portas seguem seus próprios períodos, sem cortes.
+    fxPwm_RestoreSREG();
+    return;
+  }
+  this->frameActive = FALSE;
+  for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+    if(port->lockGroup!=NULL){
+      if(port->enabled!=FALSE){
+        port->lockGroup->Restart(this->clockCount);
+      }
+    }else if(this->FrameIncludes(port)!=FALSE){
+      port->next = this->clockCount;
+      port->scheduled = TRUE;
+      port->outHint = 0x00;
+    }
+  }
+  this->SetNextFireMin(this->clockCount);
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//Tira os bits de um registrador da tabela em execução, para que uma saída desabilitada pare logo.
+//A tabela seguinte já é compilada sem eles.
+void fxPwm_T1::FrameForget(volatile BYTE *port, BYTE mask){
+  if(port==NULL || this->frames[0]==NULL){
+    return;
+  }
+
+  UINT8 t;
+  fxPwm_FrameEntry *frame = this->frames[this->frameFront];
+  for(t=0;t<this->frameLength[this->frameFront];t++){
+    if(frame[t].port==port){
+      frame[t].setMask &= ~mask;
+    }
+  }
+
+  return;
+}
+
+//Executa as entradas vencidas da tabela.
+//O OCRxB é sempre somado do delta da entrada, de modo que a tabela não acumula atraso.
+//Esperas menores que minTimerDelta são feitas aqui mesmo.
+void fxPwm_T1::TickFrame(){
+  UINT16 start = *this->hw->tcnt;
+  this->clockCount += (TIME_CLOCK)(UINT16)(start - lastClock);
+  this->lastClock = start;
+
+  if(this->frameActive==FALSE){
+    //Vindo do SCAN: começar a nova tabela agora.
+    this->frameIndex = 0;
+    this->frameCompare = start;
+    this->frameActive = TRUE;
+
+    //Grupos travados estão no meio de um período: os pinos vão para BAIXO,
+    //e a tabela só começa depois do maior tempo morto.
+    fxPwm_Port **portIndex;
+    fxPwm_Port *port;
+    UINT32 guard = 0, dead;
+    for(portIndex=this->ports;(port=*portIndex)!=NULL;portIndex++){
+      if(port->lockGroup!=NULL && port->enabled!=FALSE && (dead = port->lockGroup->Quiesce())>guard){
+        guard = dead;
+      }
+    }
+    if(guard>0){
+      guard = (guard<minTimerDelta)?(minTimerDelta):((guard>fxPwm_MaxTimerClkSum)?(fxPwm_MaxTimerClkSum):(guard));
+      this->frameWait = (UINT16)guard;
+      this->frameCompare = start + (UINT16)guard;
+      *this->hw->ocrb = this->frameCompare;
+      return;
+    }
+  }else if((UINT16)(start - (UINT16)(this->frameCompare - this->frameWait))<this->frameWait){
+    //Chamada antes da hora (comparação pendente de um OCRxB antigo). Só reagendar.
+    *this->hw->ocrb = this->frameCompare;
+    return;
+  }
+
+  fxPwm_FrameEntry *frame = this->frames[this->frameFront];
+  UINT8 length = this->frameLength[this->frameFront];
+  fxPwm_FrameEntry *entry;
+  UINT16 scheduled;
+
+  for(;;){
+    if(this->frameIndex==0 && this->frameSwap!=FALSE){
+      //Trocar de tabela só no início do hiperperíodo, quando todas as portas
+      //começam um período: nenhum pulso é cortado.
+      this->frameSwap = FALSE;
+      this->frameFront ^= 1;
+      frame = this->frames[this->frameFront];
+      length = this->frameLength[this->frameFront];
+    }
+
+    entry = &frame[this->frameIndex];
+    fxPwm_HAL_Cycles(16);
+    if(entry->port!=NULL){
+#ifdef fxPwm_STATS
+      this->StatsEdge((UINT16)(*this->hw->tcnt - this->frameCompare));
+#endif
+      fxPwm_HAL_WriteBits(entry->port, entry->setMask, entry->clearMask);
+    }
+
+    scheduled = this->frameCompare;
+    this->frameCompare = scheduled + entry->delta;
+    this->frameWait = entry->delta;
+    this->frameIndex = (this->frameIndex+1>=length)?(0):(this->frameIndex+1);
+
+    //Se der tempo, sair e esperar pela interrupção.
+    if((UINT32)(UINT16)(*this->hw->tcnt - scheduled) + minTimerDelta <= entry->delta){
+      *this->hw->ocrb = this->frameCompare;
+      return;
+    }
+
+    if((UINT16)(*this->hw->tcnt - start)>maxTimerDuration){
+#ifdef fxPwm_SliceBudget
+      //Fim da fatia: a próxima chamada continua da mesma entrada, e a tabela não escorrega
+      //enquanto o atraso for pequeno. A entrada está a menos de minTimerDelta, ou já venceu.
+      //O atraso é medido desde a borda anterior, na largura do TIME_CLOCK, como no Tick(): o
+      //INT16 erraria com maxTimerPeriod acima de 32767.
+      UINT16 now = *this->hw->tcnt;
+      if(fxPwm_TIME_DIFF((TIME_CLOCK)(UINT16)(now - scheduled), entry->delta)<(TIME_CLOCK_DIFF)maxTimerPeriod){
+#ifdef fxPwm_STATS
+        this->stats.deadlineHits++;
+#endif
+        *this->hw->ocrb = now + minTimerDelta;
+        return;
+      }
+#endif
+      //Sobrecarga: deixar a tabela escorregar em vez de prender a CPU aqui.
+#ifdef fxPwm_STATS
+      this->stats.deadlineHits++;
+#endif
+      this->frameCompare = *this->hw->tcnt + minTimerDelta;
+      this->frameWait = minTimerDelta;
+      *this->hw->ocrb = this->frameCompare;
+      return;
+    }
+
+    //Pouco tempo: esperar aqui mesmo pela próxima entrada.
+    while((UINT16)(*this->hw->tcnt - scheduled)<entry->delta);
+  }
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Glide.cpp
+ *  Arquivo contendo definição dos métodos da classe
+ *  fxPwm_Glide. O passo de cada período fica no Tick()
+ *  (fxPwm_T1::StepGlide).
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_Glide.h>
+
+//Limita um período a um ciclo do timer até fxPwm_GLIDE_MAX_CLK, e o passa para ponto fixo 24.8.
+static UINT32 fxPwm_GlideFixed(UINT32 periodClk){
+  periodClk = (periodClk<1)?(1):((periodClk>fxPwm_GLIDE_MAX_CLK)?(fxPwm_GLIDE_MAX_CLK):(periodClk));
+  return periodClk<<8;
+}
+
+//Limita um passo a limit, e a pelo menos uma unidade no sentido da varredura, para que ela sempre ande.
+static INT32 fxPwm_GlideStep(INT64 step, INT32 limit, BOOL up){
+  if(step>limit){
+    return limit;
+  }
+  if(step< -(INT64)limit){
+    return -limit;
+  }
+  if(step==0){
+    return (up!=FALSE)?(1):(-1);
+  }
+  return (INT32)step;
+}
+
+//Construtor.
+fxPwm_Glide::fxPwm_Glide(){
+  this->mode = fxPwm_GLIDE_NONE;
+  this->repeat = FALSE;
+  this->done = FALSE;
+  this->period = 0;
+  this->start = 0;
+  this->end = 0;
+  this->step = 0;
+  this->rate = 0;
+  this->duty16 = fxPwm_DUTY16_MAX/2 + 1;
+  this->port = NULL;
+
+  return;
+}
+
+//Destrutor. A porta fica no período atual.
+fxPwm_Glide::~fxPwm_Glide(){
+  if(this->port!=NULL){
+    this->port->SetGlide(NULL);
+  }
+
+  return;
+}
+
+//Entrega a varredura ao Tick() de uma vez.
+void fxPwm_Glide::Begin(UINT8 mode, UINT32 start, UINT32 end, INT32 step, INT32 rate, BOOL repeat){
+  fxPwm_SaveSREG();cli();
+  this->start = start;
+  this->end = end;
+  this->period = start;
+  this->step = step;
+  this->rate = rate;
+  this->repeat = (repeat!=FALSE)?(TRUE):(FALSE);
+  this->done = (start==end)?(TRUE):(FALSE);
+  this->mode = mode;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//Com n passos de P1 até P2 em linha reta, a duração é n*(P1+P2)/2.
+//Então o passo (P2-P1)/n é (P2²-P1²)/(2*duração).
+void fxPwm_Glide::LinearClk(UINT32 period1Clk, UINT32 period2Clk, UINT32 durationClk, BOOL repeat){
+  UINT32 start = fxPwm_GlideFixed(period1Clk);
+  UINT32 end = fxPwm_GlideFixed(period2Clk);
+  durationClk = (durationClk<1)?(1):(durationClk);
+  INT64 p1 = start>>8;
+  INT64 p2 = end>>8;
+  INT64 step = (p2*p2 - p1*p1)*256/(2*(INT64)durationClk);
+
+  this->Begin(fxPwm_GLIDE_LINEAR, start, end, fxPwm_GlideStep(step, (INT32)(fxPwm_GLIDE_MAX_CLK<<8), (end>start)?(TRUE):(FALSE)), 0, repeat);
+
+  return;
+}
+
+//Com razão r por passo, a duração é a soma de P1*r^k até chegar em P2: (P2-P1)/(r-1).
+//Então r-1 é (P2-P1)/duração, sem potências nem logaritmos.
+void fxPwm_Glide::ExponentialClk(UINT32 period1Clk, UINT32 period2Clk, UINT32 durationClk, BOOL repeat){
+  UINT32 start = fxPwm_GlideFixed(period1Clk);
+  UINT32 end = fxPwm_GlideFixed(period2Clk);
+  durationClk = (durationClk<1)?(1):(durationClk);
+  INT64 rate = (((INT64)(end>>8) - (INT64)(start>>8))<<31)/(INT64)durationClk;
+
+  this->Begin(fxPwm_GLIDE_EXPONENTIAL, start, end, 0, fxPwm_GlideStep(rate, 0x7FFFFFFF, (end>start)?(TRUE):(FALSE)), repeat);
+
+  return;
+}
+
+void fxPwm_Glide::Linear(TIME_US period1, TIME_US period2, TIME_US duration, BOOL repeat){
+  this->LinearClk(fxPwm_T1::MicrosToClk(period1), fxPwm_T1::MicrosToClk(period2), fxPwm_T1::MicrosToClk(duration), repeat);
+}
+
+void fxPwm_Glide::Exponential(TIME_US period1, TIME_US period2, TIME_US duration, BOOL repeat){
+  this->ExponentialClk(fxPwm_T1::MicrosToClk(period1), fxPwm_T1::MicrosToClk(period2), fxPwm_T1::MicrosToClk(duration), repeat);
+}
+
+UINT8 fxPwm_Glide::GetMode(){
+  return this->mode;
+}
+
+UINT32 fxPwm_Glide::GetPeriodClk(){
+  fxPwm_SaveSREG();cli();
+  UINT32 period = this->period;
+  fxPwm_RestoreSREG();
+
+  return period>>8;
+}
+
+TIME_US fxPwm_Glide::GetPeriod(){
+  return fxPwm_T1::ClkToMicros(this->GetPeriodClk());
+}
+
+BOOL fxPwm_Glide::IsDone(){
+  return this->done;
+}
+
+fxPwm_Port *fxPwm_Glide::GetPort(){
+  return this->port;
+}
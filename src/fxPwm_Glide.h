@@ -0,0 +1,96 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Glide.h
+ *  Cabeçalho contendo declaração da classe fxPwm_Glide, uma
+ *  varredura do período de uma porta (linear ou exponencial,
+ *  uma vez ou repetida) que o Tick() avança uma vez por período
+ *  da porta, em ciclos do timer.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwm_Glide_H
+#define fxPwm_Glide_H
+
+#include <fxPwmTypes.h>
+
+class fxPwm_Port;
+
+//Modos de uma varredura.
+//NONE: nunca configurada. O Tick() não mexe na porta.
+//LINEAR: o período muda do mesmo tanto a cada período (a frequência sobe ou desce cada vez mais rápido).
+//EXPONENTIAL: o período muda na mesma razão a cada período, como a frequência: mesma quantidade
+//de semitons por segundo, o glissando musical.
+#define fxPwm_GLIDE_NONE        0
+#define fxPwm_GLIDE_LINEAR      1
+#define fxPwm_GLIDE_EXPONENTIAL 2
+
+//Maior período de uma varredura, em ciclos do timer (cerca de 2 s com o timer em 2 MHz).
+//O período é guardado em ponto fixo 24.8, com folga para que a soma de um passo nunca estoure 31 bits.
+#define fxPwm_GLIDE_MAX_CLK 0x3FFFFFUL
+
+//Classe que encapsula uma varredura do período de uma porta (fxPwm_Port::SetGlide).
+//No início de cada período da porta, o Tick() aplica o período atual da varredura, com o ciclo de trabalho
+//da porta, e calcula o próximo somando ao período em ciclos do timer, sem FLOAT e sem divisões.
+//A duração é exata, a menos dos arredondamentos: cada passo dura o próprio período.
+class fxPwm_Glide{
+private:
+  //Modo (fxPwm_GLIDE_LINEAR etc.).
+  volatile UINT8 mode;
+  //Recomeça do período inicial ao chegar no final (chirp).
+  BOOL repeat;
+  //Indica que a varredura chegou ao período final e parou.
+  volatile BOOL done;
+  //Períodos atual, inicial e final, em ciclos do timer, em ponto fixo 24.8.
+  volatile UINT32 period;
+  UINT32 start;
+  UINT32 end;
+  //Passo da varredura linear, em ciclos do timer em ponto fixo 24.8.
+  INT32 step;
+  //Razão da varredura exponencial menos 1, em ponto fixo de 31 bits: período += período*rate/2^31.
+  INT32 rate;
+  //Ciclo de trabalho da porta, de 0 até fxPwm_DUTY16_MAX, atribuído pelas funções da porta.
+  volatile UINT16 duty16;
+
+  //Porta que a varredura move, ou NULL.
+  fxPwm_Port *port;
+
+  //Começa uma varredura já calculada.
+  void Begin(UINT8 mode, UINT32 start, UINT32 end, INT32 step, INT32 rate, BOOL repeat);
+public:
+  friend class fxPwm_T1;
+  friend class fxPwm_Port;
+
+  //Inicializa uma varredura sem modo.
+  fxPwm_Glide();
+
+  //Destrutor. Tira a varredura da porta.
+  ~fxPwm_Glide();
+
+  //Varredura linear do período, de period1Clk até period2Clk, durante durationClk, tudo em ciclos do timer.
+  //Com repeat, recomeça de period1Clk a cada vez que chega em period2Clk (chirp). Começa no próximo período da porta.
+  //Períodos limitados a fxPwm_GLIDE_MAX_CLK.
+  void LinearClk(UINT32 period1Clk, UINT32 period2Clk, UINT32 durationClk, BOOL repeat);
+  //Varredura exponencial do período (e da frequência), como LinearClk().
+  void ExponentialClk(UINT32 period1Clk, UINT32 period2Clk, UINT32 durationClk, BOOL repeat);
+  //Como LinearClk() e ExponentialClk(), com tudo em microssegundos.
+  void Linear(TIME_US period1, TIME_US period2, TIME_US duration, BOOL repeat);
+  void Exponential(TIME_US period1, TIME_US period2, TIME_US duration, BOOL repeat);
+
+  //Retorna o modo (fxPwm_GLIDE_LINEAR etc.).
+  UINT8 GetMode();
+  //Retorna o período atual, em ciclos do timer.
+  UINT32 GetPeriodClk();
+  //Retorna o período atual, em microssegundos.
+  TIME_US GetPeriod();
+  //Indica se a varredura chegou ao período final. Uma varredura repetida nunca acaba.
+  BOOL IsDone();
+  //Retorna a porta que a varredura move, ou NULL.
+  fxPwm_Port *GetPort();
+};
+
+#endif
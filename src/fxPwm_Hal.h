@@ -0,0 +1,150 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Hal.h
+ *  Camada de abstração de hardware da biblioteca fxPwm.
+ *  Seleciona entre o núcleo do Arduino (AVR) e o simulador
+ *  de host (fxPwm_Sim.h), que permite compilar e medir o
+ *  modulador fora do microcontrolador.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: registrador e máscara de pinos constantes (fxPwm_HAL_PinPort, fxPwm_HAL_PinMask).
+ *  17-10-2026: registradores de um timer de 16 bits (fxPwm_HAL_Timer), para os motores em TIMER1, 3, 4 e 5.
+ *  17-10-2026: PWM por hardware do núcleo do Arduino (fxPwm_HAL_HwPwmTimer, analogWrite).
+ *  17-10-2026: leitura de tabelas em PROGMEM (fxPwm_HAL_ReadTable16).
+ *  17-10-2026: barreira do compilador (fxPwm_HAL_Barrier), para a fila de comandos sem travas.
+ *  17-10-2026: escrita atômica de bits de um registrador PORTx (fxPwm_HAL_WriteBits), usada pelos motores.
+ */
+
+#ifndef fxPwm_Hal_H
+#define fxPwm_Hal_H
+
+//Fora do ambiente do Arduino, compilar contra o simulador.
+#if !defined(ARDUINO) && !defined(fxPwm_HOST)
+#define fxPwm_HOST
+#endif
+
+#ifdef fxPwm_HOST
+
+//Registradores, pinos e interrupções simulados.
+#include <fxPwm_Sim.h>
+
+//Contabiliza ciclos de CPU gastos pelo código no simulador.
+#define fxPwm_HAL_Cycles(n) fxPwmSim.Consume(n)
+
+//Contador de um timer simulado: cada leitura custa ciclos.
+typedef fxPwm_SimTcnt fxPwm_HAL_Tcnt;
+
+//PWM por hardware simulado: o programa de teste escolhe os pinos com timer (fxPwm_Sim::hwTimer).
+#define fxPwm_HAL_HwPwmTimer(pin)        (((uint8_t)(pin)<NUM_DIGITAL_PINS)?(fxPwmSim.hwTimer[(uint8_t)(pin)]):((uint8_t)0xFF))
+#define fxPwm_HAL_HwPwmWrite(pin, value) fxPwmSim.HwPwmWrite(pin, value)
+#define fxPwm_HAL_HwPwmOff(pin)          fxPwmSim.HwPwmOff(pin)
+
+//No host, PROGMEM é memória comum.
+#define fxPwm_HAL_ReadTable16(address) (*(const uint16_t *)(address))
+
+#else
+
+#include "arduino.h"
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+//No hardware, o tempo passa sozinho.
+#define fxPwm_HAL_Cycles(n)
+
+typedef volatile uint16_t fxPwm_HAL_Tcnt;
+
+//Timer do PWM por hardware de um pino (0, 2, 3, 4 ou 5), ou 0xFF se o pino não tiver um.
+//Os pinos do TIMER1 ficam de fora: o TIMER1 é do fxPwm.
+static inline uint8_t fxPwm_HAL_HwPwmTimer(uint8_t pin){
+  switch(digitalPinToTimer(pin)){
+#if defined(TCCR0A)
+    case TIMER0A: case TIMER0B: return 0;
+#endif
+#if defined(TCCR2A)
+    case TIMER2A: case TIMER2B: return 2;
+#endif
+#if defined(TCNT3)
+    case TIMER3A: case TIMER3B: case TIMER3C: return 3;
+#endif
+#if defined(TCNT4) && defined(TCNT5)
+    //Só nas placas Mega: no ATmega32U4, o TIMER4 é de 10 bits, com outra configuração.
+    case TIMER4A: case TIMER4B: case TIMER4C: return 4;
+    case TIMER5A: case TIMER5B: case TIMER5C: return 5;
+#endif
+    default: return 0xFF;
+  }
+}
+
+//O analogWrite() liga a saída do timer no pino, e o digitalWrite() a desliga.
+#define fxPwm_HAL_HwPwmWrite(pin, value) analogWrite(pin, value)
+#define fxPwm_HAL_HwPwmOff(pin)          digitalWrite(pin, LOW)
+
+//Tabelas constantes ficam na flash (PROGMEM), lidas com lpm.
+#define fxPwm_HAL_ReadTable16(address) pgm_read_word(address)
+
+#endif
+
+//Período do PWM por hardware de um timer, em ciclos de CPU, como o núcleo do Arduino o configura (wiring.c):
+//pré-escalar 64, com o TIMER0 em fast PWM (256 passos) e os outros em phase correct (510 passos).
+//Com 16MHz, 1024us (976,56Hz) no TIMER0 e 2040us (490,20Hz) nos outros. Ciclo de trabalho de 8 bits.
+#define fxPwm_HAL_HwPwmCycles(timer) (((timer)==0)?(64UL*256):(64UL*510))
+
+//Barreira do compilador: as escritas de antes não passam para depois (GCC nos dois casos).
+//O AVR não reordena acessos à memória, e o simulador roda numa linha só.
+#define fxPwm_HAL_Barrier() __asm__ __volatile__("" ::: "memory")
+
+//Registrador PORTx e máscara de um pino, para pinos conhecidos em tempo de compilação (fxPwmStatic).
+//Com o pino constante, o compilador resolve o registrador e a máscara, e as escritas de um bit viram sbi/cbi.
+#if defined(fxPwm_HOST)
+#define fxPwm_HAL_PinPort(pin)  (fxPwmSim.port[(pin)>>3])
+#define fxPwm_HAL_PinMask(pin)  ((uint8_t)(1<<((pin)&0x07)))
+#elif defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega8__)
+//Uno, Nano, Pro Mini: pinos 0~7 no PORTD, 8~13 no PORTB e 14~19 (A0~A5) no PORTC.
+#define fxPwm_HAL_PinPort(pin)  (*(((pin)<8)?(&PORTD):(((pin)<14)?(&PORTB):(&PORTC))))
+#define fxPwm_HAL_PinMask(pin)  ((uint8_t)(1<<(((pin)<8)?(pin):(((pin)<14)?((pin)-8):((pin)-14)))))
+#else
+//Mapeamento desconhecido: consultar as tabelas do Arduino. Funciona, mas sem sbi/cbi.
+#define fxPwm_HAL_PinPort(pin)  (*portOutputRegister(digitalPinToPort(pin)))
+#define fxPwm_HAL_PinMask(pin)  (digitalPinToBitMask(pin))
+#endif
+
+//Registradores de um timer de 16 bits, para que o mesmo motor rode em qualquer um deles.
+//TCCRxC não entra: o motor não o usa.
+struct fxPwm_HAL_Timer{
+  fxPwm_HAL_Tcnt *tcnt;
+  volatile uint16_t *icr;
+  volatile uint16_t *ocra;
+  volatile uint16_t *ocrb;
+  volatile uint8_t *tccra;
+  volatile uint8_t *tccrb;
+  volatile uint8_t *timsk;
+  volatile uint8_t *tifr;
+};
+
+//Registradores do timer n, para a tabela de timers. Só para timers que existem (TCNTn definido).
+#define fxPwm_HAL_TIMER(n) {&TCNT##n, &ICR##n, &OCR##n##A, &OCR##n##B, &TCCR##n##A, &TCCR##n##B, &TIMSK##n, &TIFR##n}
+//Timer que não existe no microcontrolador.
+#define fxPwm_HAL_NO_TIMER {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL}
+
+//Salva e restaura o registrador de estado, para seções críticas.
+#ifndef fxPwm_SaveSREG
+#define fxPwm_SaveSREG() uint8_t sreg_saved = SREG
+#endif
+
+#ifndef fxPwm_RestoreSREG
+#define fxPwm_RestoreSREG() SREG = sreg_saved
+#endif
+
+//Seta e limpa bits de um registrador PORTx numa leitura-modificação-escrita atômica: a interrupção de
+//outro motor (AddShard) pode escrever no mesmo registrador entre a leitura e a escrita.
+static inline void fxPwm_HAL_WriteBits(volatile uint8_t *port, uint8_t setMask, uint8_t clearMask){
+  fxPwm_SaveSREG();cli();
+  *port = (uint8_t)((*port & ~clearMask) | setMask);
+  fxPwm_RestoreSREG();
+}
+
+#endif
@@ -0,0 +1,393 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_LockGroup.cpp
+ *  Arquivo contendo definição dos métodos da classe
+ *  fxPwm_LockGroup.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: o grupo usa o motor em que sua porta (carrier) está registrada.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_LockGroup.h>
+
+//Fração de 16 bits de um período: period*value16/65536, como em fxPwm_Port::SetPeriodClkAndDuty16().
+static UINT32 fxPwm_LockFraction(UINT32 period, UINT16 value16){
+  return (value16==fxPwm_DUTY16_MAX)?(period):
+    ((period>>16)*(UINT32)value16 + (((period&0xFFFF)*(UINT32)value16)>>16));
+}
+
+//Acrescenta a escrita do nível de um pino no instante offset, mantendo a tabela ordenada pelo instante.
+//Escritas no mesmo instante e registrador são juntadas numa só.
+static UINT8 fxPwm_LockWrite(fxPwm_LockEdge *edges, UINT8 length, UINT32 offset, fxPwm_LockPin *pin, BOOL level){
+  UINT8 t;
+  for(t=0;t<length && edges[t].offset<=offset;t++){
+    if(edges[t].offset==offset && edges[t].port==pin->port){
+      edges[t].setMask = (level!=FALSE)?(edges[t].setMask | pin->mask):(edges[t].setMask & ~pin->mask);
+      edges[t].clearMask = (level!=FALSE)?(edges[t].clearMask & ~pin->mask):(edges[t].clearMask | pin->mask);
+      return length;
+    }
+  }
+
+  //Abrir espaço depois das escritas do mesmo instante.
+  UINT8 u;
+  for(u=length;u>t;u--){
+    edges[u] = edges[u-1];
+  }
+  edges[t].offset = offset;
+  edges[t].port = pin->port;
+  edges[t].group = 0xFF;
+  edges[t].setMask = (level!=FALSE)?(pin->mask):(0x00);
+  edges[t].clearMask = (level!=FALSE)?(0x00):(pin->mask);
+
+  return length+1;
+}
+
+//Limpa todos itens do grupo.
+void fxPwm_LockGroup::Cleanup(){
+  UINT8 t;
+  this->numPins = 0;
+  for(t=0;t<fxPwm_LockMaxPins;t++){
+    this->pins[t].pinNumber = 0xFF;
+    this->pins[t].port = NULL;
+    this->pins[t].ddr = NULL;
+    this->pins[t].mask = 0x00;
+    this->pins[t].phase16 = 0;
+    this->pins[t].duty16 = fxPwm_DUTY16_MAX/2 + 1;
+    this->pins[t].complementOf = 0xFF;
+    this->pins[t].deadClk = 0;
+  }
+  this->periodClk = 0;
+  this->length[0] = 0;
+  this->length[1] = 0;
+  this->period[0] = 0;
+  this->period[1] = 0;
+  this->front = 0;
+  this->swap = FALSE;
+  this->edgeIndex = 0;
+  this->origin = 0;
+
+  return;
+}
+
+//Construtor. A porta sem pino passa a representar o grupo.
+fxPwm_LockGroup::fxPwm_LockGroup(){
+  this->Cleanup();
+  this->carrier.lockGroup = this;
+
+  return;
+}
+
+//Destrutor. A porta deixa de apontar para o grupo antes de ser destruída.
+fxPwm_LockGroup::~fxPwm_LockGroup(){
+  this->Disable();
+  this->carrier.engine->RemoveGroup(this);
+  this->carrier.lockGroup = NULL;
+
+  return;
+}
+
+//Retorna a última tabela compilada.
+UINT8 fxPwm_LockGroup::Latest(){
+  return (this->swap!=FALSE)?(this->front^1):(this->front);
+}
+
+//Coloca todos os pinos em nível BAIXO.
+void fxPwm_LockGroup::ClearPins(){
+  UINT8 t;
+  for(t=0;t<this->numPins;t++){
+    *this->pins[t].port &= ~this->pins[t].mask;
+  }
+
+  return;
+}
+
+//Coloca os pinos em nível BAIXO e retorna o maior tempo morto do grupo:
+//a espera até que qualquer pino possa subir de novo.
+UINT32 fxPwm_LockGroup::Quiesce(){
+  UINT8 t;
+  UINT32 dead = 0;
+  this->ClearPins();
+  for(t=0;t<this->numPins;t++){
+    if(this->pins[t].complementOf!=0xFF && this->pins[t].deadClk>dead){
+      dead = this->pins[t].deadClk;
+    }
+  }
+
+  return dead;
+}
+
+//Compila a linha do tempo de todos os pinos num período, na tabela de trás.
+//Cada pino recebe uma escrita com seu nível no instante 0, e mais uma na subida e outra na descida.
+//Assim o nível de todos os pinos no começo de cada período vem da tabela, e não do período anterior.
+//Fora de um lote, a nova tabela entra no início do próximo período (veja fxPwm_T1::ProcessLockEdge()).
+void fxPwm_LockGroup::Compile(){
+  UINT8 back, t;
+  UINT8 length = 0;
+  UINT32 period = this->periodClk;
+  UINT32 rise, high, fall;
+  fxPwm_LockPin *pin;
+  fxPwm_LockPin *reference;
+  fxPwm_LockEdge *edges;
+
+  //A tabela de trás vai ser reescrita: cancelar qualquer troca pendente.
+  //É uma escrita de um byte, e o Tick() só mexe em front se swap estiver setado.
+  this->swap = FALSE;
+  back = this->front^1;
+  edges = this->edges[back];
+
+  for(t=0;t<this->numPins && period>0;t++){
+    pin = &this->pins[t];
+    if(pin->complementOf==0xFF){
+      rise = fxPwm_LockFraction(period, pin->phase16);
+      high = fxPwm_LockFraction(period, pin->duty16);
+    }else{
+      //Complemento: ALTO entre a descida do outro pino e a próxima subida dele, menos o tempo morto dos dois lados.
+      reference = &this->pins[pin->complementOf];
+      high = fxPwm_LockFraction(period, reference->duty16);
+      rise = fxPwm_LockFraction(period, reference->phase16) + high + pin->deadClk;
+      high = (high + 2*pin->deadClk<period)?(period - high - 2*pin->deadClk):(0);
+    }
+    rise %= period;
+
+    //Nível no início do período: ALTO se o pulso começa em 0 ou passa do fim do período.
+    length = fxPwm_LockWrite(edges, length, 0, pin,
+      (high>=period || (high>0 && (rise==0 || rise + high>period)))?(TRUE):(FALSE));
+    if(high>0 && high<period){
+      if(rise!=0){
+        length = fxPwm_LockWrite(edges, length, rise, pin, TRUE);
+      }
+      fall = rise + high;
+      fall = (fall>=period)?(fall - period):(fall);
+      if(fall!=0){
+        length = fxPwm_LockWrite(edges, length, fall, pin, FALSE);
+      }
+    }
+  }
+  this->length[back] = length;
+  this->period[back] = period;
+  this->swap = TRUE;
+
+  if(this->carrier.engine->batchDepth>0){
+    //Dentro de um lote: o EndUpdate() recomeça o grupo com a tabela nova.
+    this->carrier.staged = TRUE;
+  }else if(this->carrier.enabled!=FALSE && (this->carrier.scheduled==FALSE || length==0)){
+    //O grupo ainda não modulava (período 0), ou parou de modular: aplicar agora.
+    fxPwm_SaveSREG();cli();
+    this->Restart(this->carrier.engine->clockCount);
+    this->carrier.engine->Reschedule(&this->carrier);
+    fxPwm_RestoreSREG();
+  }
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->carrier.engine->frameDirty = TRUE;
+  this->carrier.engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+//Recomeça o período do grupo em origin, trocando para a tabela nova se houver.
+//O grupo pode estar no meio de um período: os pinos vão para BAIXO agora, e o período só começa
+//depois do maior tempo morto (Quiesce()), para que nenhum complemento suba junto com o outro pino.
+//Sem nada a modular, os pinos ficam em nível BAIXO e o grupo sai do agendador.
+BOOL fxPwm_LockGroup::Restart(TIME_CLOCK origin){
+  if(this->swap!=FALSE){
+    this->front ^= 1;
+    this->swap = FALSE;
+  }
+  this->edgeIndex = 0;
+  origin += this->Quiesce();
+  this->origin = origin;
+
+  if(this->length[this->front]==0){
+    this->carrier.next = fxPwm_NO_NEXT_EVENT;
+    this->carrier.scheduled = FALSE;
+    return FALSE;
+  }
+
+  this->carrier.next = origin + this->edges[this->front][0].offset;
+  this->carrier.scheduled = TRUE;
+
+  return TRUE;
+}
+
+//Acrescenta um pino ao grupo.
+UINT8 fxPwm_LockGroup::AddPin(UINT8 pinNumber){
+  UINT8 portN = digitalPinToPort(pinNumber);
+  if(this->numPins>=fxPwm_LockMaxPins || portN==NOT_A_PIN || fxPwm.GetPort(pinNumber)!=NULL){
+    return 0xFF;
+  }
+
+  UINT8 t;
+  for(t=0;t<this->numPins;t++){
+    if(this->pins[t].pinNumber==pinNumber){
+      //Já está no grupo.
+      return 0xFF;
+    }
+  }
+
+  fxPwm_LockPin *pin = &this->pins[this->numPins];
+  pin->pinNumber = pinNumber;
+  pin->port = portOutputRegister(portN);
+  pin->ddr = portModeRegister(portN);
+  pin->mask = digitalPinToBitMask(pinNumber);
+  pin->phase16 = 0;
+  pin->duty16 = fxPwm_DUTY16_MAX/2 + 1;
+  pin->complementOf = 0xFF;
+  pin->deadClk = 0;
+
+  fxPwm_SaveSREG();cli();
+  if(this->carrier.enabled!=FALSE){
+    //Grupo já modulando: o pino entra em modo de saída, BAIXO até a tabela nova.
+    *pin->ddr |= pin->mask;
+    *pin->port &= ~pin->mask;
+  }
+  this->numPins++;
+  fxPwm_RestoreSREG();
+
+  this->Compile();
+
+  return this->numPins-1;
+}
+
+UINT8 fxPwm_LockGroup::GetNumPins(){
+  return this->numPins;
+}
+
+//Atribui o período do grupo. Períodos longos demais são limitados, como nas portas.
+void fxPwm_LockGroup::SetPeriodClk(UINT32 periodClk){
+  if((TIME_CLOCK)periodClk>fxPwm_MAX_PERIOD_CLK){
+    periodClk = (UINT32)fxPwm_MAX_PERIOD_CLK;
+  }
+  this->periodClk = periodClk;
+  this->Compile();
+
+  return;
+}
+
+void fxPwm_LockGroup::SetPeriod(TIME_US period){
+  this->SetPeriodClk(fxPwm_T1::MicrosToClk(period));
+}
+
+UINT32 fxPwm_LockGroup::GetPeriodClk(){
+  return this->periodClk;
+}
+
+//Atribui o ciclo de trabalho de um pino.
+void fxPwm_LockGroup::SetDuty16(UINT8 member, UINT16 duty16){
+  if(member>=this->numPins){
+    return;
+  }
+  this->pins[member].duty16 = duty16;
+  this->Compile();
+
+  return;
+}
+
+//Atribui a fase da subida de um pino.
+void fxPwm_LockGroup::SetPhase16(UINT8 member, UINT16 phase16){
+  if(member>=this->numPins){
+    return;
+  }
+  this->pins[member].phase16 = phase16;
+  this->Compile();
+
+  return;
+}
+
+//Faz de um pino o complemento de outro, ou desfaz (of igual a 0xFF).
+//Complementos não encadeiam: o outro pino não pode ser complemento, e nenhum pino pode ser complemento deste.
+BOOL fxPwm_LockGroup::SetComplement(UINT8 member, UINT8 of, UINT32 deadClk){
+  if(member>=this->numPins || (of!=0xFF && (of>=this->numPins || of==member || this->pins[of].complementOf!=0xFF))){
+    return FALSE;
+  }
+
+  UINT8 t;
+  for(t=0;t<this->numPins && of!=0xFF;t++){
+    if(this->pins[t].complementOf==member){
+      return FALSE;
+    }
+  }
+
+  this->pins[member].complementOf = of;
+  this->pins[member].deadClk = ((TIME_CLOCK)deadClk>fxPwm_MAX_PERIOD_CLK)?((UINT32)fxPwm_MAX_PERIOD_CLK):(deadClk);
+  this->Compile();
+
+  return TRUE;
+}
+
+#ifndef fxPwm_NO_FLOAT
+//Atribui frequência. Se frequency<=0.0, atribui período 0.
+void fxPwm_LockGroup::SetFrequency(FLOAT frequency){
+  this->SetPeriodClk(fxPwm_T1::MicrosToClk((frequency<=0.0)?(0):((TIME_US)(1000000.0/(FLOAT)frequency+0.5))));
+}
+
+void fxPwm_LockGroup::SetDuty(UINT8 member, FLOAT duty){
+  duty = (duty<0.0)?(0.0):((duty>1.0)?(1.0):(duty));
+  this->SetDuty16(member, (UINT16)(duty*(FLOAT)fxPwm_DUTY16_MAX + 0.5));
+}
+
+void fxPwm_LockGroup::SetPhase(UINT8 member, FLOAT phase){
+  phase = (phase<0.0)?(0.0):((phase>1.0)?(1.0):(phase));
+  this->SetPhase16(member, (UINT16)(phase*(FLOAT)fxPwm_DUTY16_MAX + 0.5));
+}
+#endif
+
+//Habilita a modulação, com todos os pinos começando o período agora.
+//Dentro de um lote, o grupo só começa no EndUpdate(), junto com as portas.
+void fxPwm_LockGroup::Enable(){
+  if(this->carrier.enabled!=FALSE || this->carrier.index==0xFF){
+    return;
+  }
+
+  fxPwm_SaveSREG();cli();
+
+  //Configurar modo de saída e colocar em nível BAIXO.
+  UINT8 t;
+  for(t=0;t<this->numPins;t++){
+    *this->pins[t].ddr |= this->pins[t].mask;
+  }
+  this->ClearPins();
+
+  this->carrier.enabled = TRUE;
+  if(this->carrier.engine->batchDepth>0){
+    this->carrier.next = fxPwm_NO_NEXT_EVENT;
+    this->carrier.scheduled = FALSE;
+    this->carrier.staged = TRUE;
+  }else{
+    this->Restart(this->carrier.engine->clockCount);
+    this->carrier.engine->Reschedule(&this->carrier);
+  }
+  fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->carrier.engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+//Desabilita a modulação, com todos os pinos em nível BAIXO.
+void fxPwm_LockGroup::Disable(){
+  fxPwm_SaveSREG();cli();
+  this->ClearPins();
+  this->carrier.enabled = FALSE;
+  this->carrier.next = fxPwm_NO_NEXT_EVENT;
+  this->carrier.scheduled = FALSE;
+  this->carrier.engine->Reschedule(&this->carrier);
+  fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->carrier.engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+BOOL fxPwm_LockGroup::IsEnabled(){
+  return this->carrier.enabled;
+}
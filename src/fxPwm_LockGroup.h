@@ -0,0 +1,162 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_LockGroup.h
+ *  Cabeçalho contendo declaração da classe fxPwm_LockGroup, um
+ *  grupo de pinos travados no mesmo período, com fases fixas
+ *  entre si (por exemplo saídas complementares com tempo morto
+ *  para meia ponte). O grupo é um só evento no agendador.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwm_LockGroup_H
+#define fxPwm_LockGroup_H
+
+#include <fxPwmTypes.h>
+#include <fxPwm_Port.h>
+
+//Máximo de pinos num grupo travado.
+//Cada grupo guarda duas tabelas de até três escritas por pino, com 9 bytes por escrita no AVR.
+#ifndef fxPwm_LockMaxPins
+#define fxPwm_LockMaxPins 4
+#endif
+
+//Máximo de escritas na tabela de um grupo: nível no início do período, subida e descida de cada pino.
+#define fxPwm_LOCK_MAX_EDGES (fxPwm_LockMaxPins*3)
+
+//Escrita da tabela de um grupo travado.
+//No instante offset de cada período, seta e limpa bits de um registrador.
+struct fxPwm_LockEdge{
+  //Instante da escrita, em ciclos do timer a partir do início do período.
+  UINT32 offset;
+  //Registrador da porta.
+  volatile BYTE *port;
+  //Grupo do registrador no Tick() (fxPwm_T1::groups), ou 0xFF se ainda não tiver.
+  UINT8 group;
+  //Bits a setar e a limpar no registrador.
+  BYTE setMask;
+  BYTE clearMask;
+};
+
+//Pino de um grupo travado.
+struct fxPwm_LockPin{
+  //Número do pino do Arduino.
+  UINT8 pinNumber;
+  //Registradores da porta e máscara do pino.
+  volatile BYTE *port;
+  volatile BYTE *ddr;
+  BYTE mask;
+  //Fase da subida e ciclo de trabalho, de 0 até fxPwm_DUTY16_MAX, em fração do período do grupo.
+  UINT16 phase16;
+  UINT16 duty16;
+  //Pino do grupo do qual este é o complemento, ou 0xFF.
+  UINT8 complementOf;
+  //Tempo morto do complemento, em ciclos do timer: depois da descida e antes da subida do outro pino.
+  UINT32 deadClk;
+};
+
+//Classe que encapsula um grupo de pinos travados no mesmo período.
+//Todos os pinos seguem uma única linha do tempo, compilada numa tabela de escritas
+//ordenadas pelo instante no período. O agendador só vê uma porta sem pino (carrier),
+//com um único próximo evento. Escritas no mesmo instante e registrador viram uma só.
+class fxPwm_LockGroup{
+private:
+  //Porta que representa o grupo no agendador.
+  //Não tem pino: o Tick() a reconhece por fxPwm_Port::lockGroup e executa a tabela.
+  fxPwm_Port carrier;
+
+  //Pinos do grupo.
+  fxPwm_LockPin pins[fxPwm_LockMaxPins];
+  //Quantidade de pinos.
+  UINT8 numPins;
+  //Período pedido, em ciclos do timer.
+  UINT32 periodClk;
+
+  //Tabelas de escritas: uma em execução (front) e outra para compilação.
+  fxPwm_LockEdge edges[2][fxPwm_LOCK_MAX_EDGES];
+  //Quantidade de escritas e período de cada tabela.
+  UINT8 length[2];
+  UINT32 period[2];
+  //Índice da tabela em execução.
+  volatile UINT8 front;
+  //Pede ao Tick() que troque de tabela no início do próximo período.
+  volatile BOOL swap;
+  //Índice da próxima escrita da tabela em execução.
+  UINT8 edgeIndex;
+  //Início do período atual, em ciclos do timer.
+  TIME_CLOCK origin;
+
+  //Realiza limpeza.
+  void Cleanup();
+  //Compila os pinos na tabela de trás e pede a troca ao Tick().
+  void Compile();
+  //Recomeça o período em origin, já com a última tabela compilada.
+  //Retorna FALSE se não há nada a modular. Deve ser chamado com interrupções desabilitadas.
+  BOOL Restart(TIME_CLOCK origin);
+  //Retorna a última tabela compilada (a de trás, se a troca estiver pendente).
+  UINT8 Latest();
+  //Coloca os pinos em nível BAIXO.
+  void ClearPins();
+  //Coloca os pinos em nível BAIXO e retorna o maior tempo morto, em ciclos do timer.
+  //Deve ser chamado com interrupções desabilitadas.
+  UINT32 Quiesce();
+public:
+  friend class fxPwm_T1;
+  friend class fxPwm_Port;
+
+  //Inicializa um grupo vazio.
+  fxPwm_LockGroup();
+
+  //Destrutor. Desabilita e tira o grupo do fxPwm.
+  ~fxPwm_LockGroup();
+
+  //Acrescenta um pino ao grupo, com ciclo de trabalho 50% e fase 0.
+  //Retorna a posição do pino no grupo, usada pelos outros métodos, ou 0xFF se não foi possível
+  //(grupo cheio, pino inválido, ou pino registrado como porta no fxPwm).
+  UINT8 AddPin(UINT8 pinNumber);
+
+  //Retorna a quantidade de pinos do grupo.
+  UINT8 GetNumPins();
+
+  //Atribui o período do grupo, em ciclos do timer. Período 0 deixa todos os pinos em nível BAIXO.
+  void SetPeriodClk(UINT32 periodClk);
+  //Atribui o período do grupo, em microssegundos.
+  void SetPeriod(TIME_US period);
+  //Retorna o período do grupo, em ciclos do timer.
+  UINT32 GetPeriodClk();
+
+  //Atribui o ciclo de trabalho de um pino, de 0 até fxPwm_DUTY16_MAX.
+  void SetDuty16(UINT8 member, UINT16 duty16);
+  //Atribui a fase da subida de um pino, de 0 até fxPwm_DUTY16_MAX, em fração do período.
+  void SetPhase16(UINT8 member, UINT16 phase16);
+  //Faz de um pino o complemento de outro, com tempo morto em ciclos do timer:
+  //ele sobe deadClk depois da descida do outro, e desce deadClk antes da próxima subida.
+  //O ciclo de trabalho e a fase do pino passam a ser os do complemento. O outro pino não pode ser um complemento.
+  //Com of igual a 0xFF, o pino volta a ter ciclo de trabalho e fase próprios. Retorna FALSE se não foi possível.
+  //Para que o tempo morto valha também quando o ciclo de trabalho muda, o outro pino deve ter fase 0:
+  //assim nenhum pulso do complemento passa do fim do período, onde a tabela é trocada.
+  BOOL SetComplement(UINT8 member, UINT8 of, UINT32 deadClk);
+
+#ifndef fxPwm_NO_FLOAT
+  //Atribui a frequência do grupo, em hertz.
+  void SetFrequency(FLOAT frequency);
+  //Atribui o ciclo de trabalho de um pino, de 0.0 até 1.0.
+  void SetDuty(UINT8 member, FLOAT duty);
+  //Atribui a fase da subida de um pino, de 0.0 até 1.0 do período.
+  void SetPhase(UINT8 member, FLOAT phase);
+#endif
+
+  //Habilita a modulação. Os pinos são colocados em modo de saída.
+  //O grupo precisa estar registrado (fxPwm_T1::RegisterGroup).
+  void Enable();
+  //Desabilita a modulação, deixando todos os pinos em nível BAIXO.
+  void Disable();
+  //Indica se o grupo está modulando.
+  BOOL IsEnabled();
+};
+
+#endif
@@ -9,19 +9,29 @@
  *  -----------------------------------------------------------
  *  21-07-2018: primeira documentação.
  *	25-07-2018: destrutor.
+ *  17-10-2026: períodos novos aplicados pelo Tick() no início do período, sem cli().
+ *  17-10-2026: SetPeriodClkAndDuty16() inteira; funções com FLOAT opcionais (fxPwm_NO_FLOAT).
+ *  17-10-2026: SetPinNumber() atualiza a tabela de pinos se a porta estiver registrada.
+ *  17-10-2026: comparações de tempo que sobrevivem à volta do clockCount. Período limitado a fxPwm_MAX_PERIOD_CLK.
+ *  17-10-2026: Enable() começa a porta na fase escolhida pelo escalonamento (fxPwm_T1::SetStagger).
+ *  17-10-2026: Enable() e Disable() de uma porta de grupo travado passam para o grupo.
+ *  17-10-2026: modo de densidade de pulsos (SetPdm()).
+ *  17-10-2026: tudo passa pelo motor em que a porta está registrada (engine), não mais pelo fxPwm.
+ *  17-10-2026: período que bate com o do timer do pino vai para o PWM por hardware (hw).
+ *  17-10-2026: trajetória do ciclo de trabalho (SetTrajectory()).
+ *  17-10-2026: varredura do período (SetGlide()).
+ *  17-10-2026: mapeamentos numa tabela dividida entre as portas (ChangeMap()). Release() para o destrutor e o pool.
  */
 
 #include <fxPwmTypes.h>
 #include <fxPwm.h>
 #include <fxPwm_Port.h>
+#include <fxPwm_LockGroup.h>
+#include <fxPwm_Trajectory.h>
+#include <fxPwm_Glide.h>
 
-#ifndef fxPwm_SaveSREG
-#define fxPwm_SaveSREG() BYTE sreg_saved = SREG
-#endif
-
-#ifndef fxPwm_RestoreSREG
-#define fxPwm_RestoreSREG() SREG = sreg_saved
-#endif
+//Tabela de mapeamentos.
+fxPwm_PortMap fxPwm_Port::maps[fxPwm_MaxMaps];
 
 //Limpa todos itens da classe, e atribui valores padrões onde precisar.
 void fxPwm_Port::Cleanup(){
@@ -30,20 +40,42 @@ void fxPwm_Port::Cleanup(){
   this->enabled = FALSE;
   this->pinNumber = 0xFF;
 
-  this->dutyMapMulti = 1.0;
-  this->dutyMapDelta = 0.0;
+  this->map = 0xFF;
 
   this->port = NULL;
   this->ddr = NULL;
   this->mask = 0x00;
   this->outHint = 0x00;
 
-  this->period = 0;
-  this->duty = 0.5;
+  this->periodClk = 0;
+  this->duty16 = fxPwm_DUTY16_MAX/2 + 1;
 
   this->next = fxPwm_NO_NEXT_EVENT;
+  this->scheduled = FALSE;
   this->highPeriod = 0;
   this->lowPeriod = 0;
+  this->heapIndex = 0xFF;
+  this->group = 0xFF;
+  this->lockGroup = NULL;
+  this->index = 0xFF;
+  this->engine = &fxPwm;
+  this->internal = fxPwm_PORT_USER;
+
+  this->shadowHigh = 0;
+  this->shadowLow = 0;
+  this->shadowSeq = 0;
+  this->latchedSeq = 0;
+  this->staged = FALSE;
+  this->phase = 0;
+
+  this->pdm = FALSE;
+  this->pdmDuty = 0;
+  this->pdmAccumulator = 0;
+  this->pdmNextPort = NULL;
+
+  this->hw = FALSE;
+  this->trajectory = NULL;
+  this->glide = NULL;
 
   fxPwm_RestoreSREG();
   
@@ -52,11 +84,14 @@ void fxPwm_Port::Cleanup(){
 
 //Agenda um evento para esse objeto, se estiver habilitado.
 void fxPwm_Port::ResetPhase(){
-  if(this->enabled==TRUE && this->period!=0){
+  if(this->enabled==TRUE && this->pdm==FALSE && this->hw==FALSE && this->periodClk!=0){
     //Verificar se vale a pena agendar.
-    TIME_CLOCK minNext = fxPwm.clockCount + this->highPeriod + this->lowPeriod;
-    this->next = (this->next>minNext)?(minNext):(this->next);
-    fxPwm.SetNextFireMin(this->next);
+    TIME_CLOCK minNext = this->engine->clockCount + this->highPeriod + this->lowPeriod;
+    if(this->scheduled==FALSE || fxPwm_TIME_BEFORE(minNext, this->next)){
+      this->next = minNext;
+    }
+    this->scheduled = TRUE;
+    this->engine->Reschedule(this);
   }
 
   return;
@@ -66,9 +101,24 @@ void fxPwm_Port::ResetPhase(){
 //Para isso ele consulta se o pino é válido.
 //Se for, busca os ponteiros associados aos registradores do pino.
 void fxPwm_Port::SetPinNumber(UINT8 pinNumber){
+  if(this->hw!=FALSE){
+    //O timer do pino antigo para. O período é reavaliado no pino novo.
+    BOOL enabled = this->HwRelease();
+    this->SetPinNumber(pinNumber);
+    this->SetPeriodClkAndDuty16(this->periodClk, this->duty16);
+    if(enabled!=FALSE){
+      this->Enable();
+    }
+    return;
+  }
+
   UINT8 portN = digitalPinToPort(pinNumber);
 
   fxPwm_SaveSREG();cli();
+  if(this->index!=0xFF){
+    //Porta registrada: o pino antigo sai da tabela de pinos.
+    this->engine->UnmapPin(this->pinNumber, this);
+  }
   if(portN==NOT_A_PIN){
     //Pino inválido.
     this->port = NULL;
@@ -76,6 +126,8 @@ void fxPwm_Port::SetPinNumber(UINT8 pinNumber){
     this->mask = 0x00;
     this->pinNumber = 0xFF;
     this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
+    this->engine->Reschedule(this);
     fxPwm_RestoreSREG();
     return;
   }
@@ -85,8 +137,16 @@ void fxPwm_Port::SetPinNumber(UINT8 pinNumber){
   this->ddr = portModeRegister(portN);
   this->mask = digitalPinToBitMask(pinNumber);
   this->pinNumber = pinNumber;
+  if(this->index!=0xFF){
+    this->engine->MapPin(this);
+  }
 
   fxPwm_RestoreSREG();
+
+  //O pino novo pode ter PWM por hardware.
+  if(fxPwm_T1::HwAccepts(this, this->periodClk, this->duty16)!=FALSE){
+    this->SetPeriodClkAndDuty16(this->periodClk, this->duty16);
+  }
   
   return;
 }
@@ -108,33 +168,67 @@ fxPwm_Port::fxPwm_Port(UINT8 pinNumber){
 
 //Destrutir para garantir suavidade.
 fxPwm_Port::~fxPwm_Port(){
+  if(this->index!=0xFF){
+    //Ainda registrada (uma porta do pool no fim do programa, por exemplo): sair do motor antes.
+    this->internal = fxPwm_PORT_USER;
+    this->engine->RemovePort(this);
+  }
+  this->Release();
+
+  return;
+}
+
+void fxPwm_Port::Release(){
   this->Disable();
+  if(this->trajectory!=NULL){
+    this->trajectory->port = NULL;
+  }
+  if(this->glide!=NULL){
+    this->glide->port = NULL;
+  }
+  if(this->map!=0xFF){
+    maps[this->map].users--;
+  }
   this->Cleanup();
 
   return;
 }
 
-//Retorna o período diretamente, em microssegundos.
+//Retorna o período, em microssegundos.
 TIME_US fxPwm_Port::GetPeriod(){
-  return this->period;
+  return fxPwm_T1::ClkToMicros(this->periodClk);
 }
 
+//Retorna o período diretamente, em ciclos do timer.
+UINT32 fxPwm_Port::GetPeriodClk(){
+  return this->periodClk;
+}
+
+//Retorna o ciclo de trabalho de 16 bits diretamente.
+UINT16 fxPwm_Port::GetRawDuty16(){
+  return this->duty16;
+}
+
+#ifndef fxPwm_NO_FLOAT
 //Retorna o ciclo de trabalho mapeado.
 FLOAT fxPwm_Port::GetDuty(){
-  return (this->GetRawDuty() - this->dutyMapDelta)/this->dutyMapMulti;
+  if(this->map==0xFF){
+    return this->GetRawDuty();
+  }
+  return (this->GetRawDuty() - maps[this->map].delta)/maps[this->map].multi;
 }
 
 //Retorna o ciclo de trabalho diretamente.
 FLOAT fxPwm_Port::GetRawDuty(){
-  return this->duty;
+  return (FLOAT)this->duty16/(FLOAT)fxPwm_DUTY16_MAX;
 }
 
 //Retorna a frequência a partir do inverso do período.
 //Mas antes, verifica se o período não é 0 (inválido).
 FLOAT fxPwm_Port::GetFrequency(){
-  TIME_US period = this->GetPeriod();
-  return (period==0)?(0.0):(1000000.0/(FLOAT)period);
+  return (this->periodClk==0)?(0.0):(1000000000.0/((FLOAT)this->periodClk*(FLOAT)fxPwm_T1::nsPerTimerClock));
 }
+#endif
 
 //Retorna o estado lógico do pino (HIGH ou LOW).
 BOOL fxPwm_Port::GetPinState(){
@@ -170,29 +264,117 @@ void fxPwm_Port::SetPinState(BOOL state){
   }
 }
 
-//Atribui o período e o ciclo de trabalho.
+//Atribui o período, em ciclos do timer, e o ciclo de trabalho de 16 bits (já mapeado).
 //Todas as outras funções que atribuem ciclo de trabalho, frequência e duty chamam essa.
-//Escrever período 0 faz a modulação parar. O valor que fica na porta é BAIXO se duty<=0.5, e ALTO se duty>0.5.
-void fxPwm_Port::SetPeriodAndDuty(TIME_US period, FLOAT duty){
-  //Obtém valor mapeado do duty.
-  duty = duty * this->dutyMapMulti + this->dutyMapDelta;
-  
-  //Acerta o duty.
-  duty = (duty<0.0)?(0.0):((duty>1.0)?(1.0):(duty));
+//Só usa aritmética inteira de 32 bits.
+//Escrever período 0 faz a modulação parar. O valor que fica na porta é BAIXO se duty<=50%, e ALTO se duty>50%.
+//Se a porta já estiver modulando, os novos períodos só entram em vigor no início do próximo período,
+//sem desabilitar interrupções (veja shadowSeq).
+void fxPwm_Port::SetPeriodClkAndDuty16(UINT32 periodClk, UINT16 duty16){
+  //Períodos longos demais quebrariam as comparações de tempo.
+  if((TIME_CLOCK)periodClk>fxPwm_MAX_PERIOD_CLK){
+    periodClk = (UINT32)fxPwm_MAX_PERIOD_CLK;
+  }
+
+  if(this->glide!=NULL){
+    //A varredura divide cada período com o ciclo de trabalho da porta.
+    fxPwm_SaveSREG();cli();
+    this->glide->duty16 = duty16;
+    fxPwm_RestoreSREG();
+  }
+
+  //Período em nível ALTO e BAIXO.
+  UINT32 highPeriod = fxPwm_DUTY_CLK(periodClk, duty16);
+  UINT32 lowPeriod = periodClk - highPeriod;
+
+  if(fxPwm_T1::HwAccepts(this, periodClk, duty16)!=FALSE){
+    //O timer do pino gera o período sozinho: a porta sai do Tick(), mesmo dentro de um lote.
+    fxPwm_SaveSREG();cli();
+    this->periodClk = periodClk;
+    this->duty16 = duty16;
+    this->highPeriod = highPeriod;
+    this->lowPeriod = lowPeriod;
+    this->shadowHigh = highPeriod;
+    this->shadowLow = lowPeriod;
+    this->latchedSeq = this->shadowSeq;
+    if(this->hw==FALSE){
+      this->next = fxPwm_NO_NEXT_EVENT;
+      this->scheduled = FALSE;
+      this->staged = FALSE;
+      this->engine->Reschedule(this);
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+      this->engine->FrameForget(this->port, this->mask);
+#endif
+      *this->port &= ~this->mask;
+      this->outHint = 0x00;
+      this->hw = TRUE;
+    }
+    fxPwm_RestoreSREG();
+    if(this->enabled!=FALSE){
+      fxPwm_HAL_HwPwmWrite(this->pinNumber, fxPwm_HW_DUTY8(duty16));
+    }
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+    this->engine->frameDirty = TRUE;
+    this->engine->UpdateFrame();
+#endif
+    return;
+  }
+
+  if(this->hw!=FALSE){
+    //O período ou o ciclo de trabalho não cabem mais no timer do pino: volta para o Tick(), começando agora.
+    BOOL enabled = this->HwRelease();
+    this->SetPeriodClkAndDuty16(periodClk, duty16);
+    if(enabled!=FALSE){
+      this->Enable();
+    }
+    return;
+  }
+
+  if(this->pdm!=FALSE){
+    //Modo PDM: só o ciclo de trabalho vale. O período fica guardado para quando o modo for desligado.
+    this->periodClk = periodClk;
+    this->duty16 = duty16;
+    if(this->engine->batchDepth>0){
+      //Dentro de um lote, o EndUpdate() entrega o ciclo de trabalho ao passo do PDM.
+      this->staged = TRUE;
+      return;
+    }
+    fxPwm_SaveSREG();cli();
+    this->pdmDuty = duty16;
+    fxPwm_RestoreSREG();
+    return;
+  }
+
+  if(this->engine->batchDepth>0){
+    //Dentro de um lote: só guardar. O EndUpdate() aplica tudo no mesmo instante.
+    this->periodClk = periodClk;
+    this->duty16 = duty16;
+    this->shadowSeq++;
+    this->shadowHigh = highPeriod;
+    this->shadowLow = lowPeriod;
+    this->shadowSeq++;
+    this->staged = TRUE;
+    return;
+  }
 
   //Verifica se o período é válido.
-  if(period==0){
+  if(periodClk==0){
     fxPwm_SaveSREG();cli();
     //Sem período. Zerar variáveis de período mas impedir agendamento.
-    this->period = 0;
-    this->duty = duty;
+    this->periodClk = 0;
+    this->duty16 = duty16;
     this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
     this->highPeriod = 0;
     this->lowPeriod = 0;
+    this->shadowHigh = 0;
+    this->shadowLow = 0;
+    this->latchedSeq = this->shadowSeq;
+    this->engine->Reschedule(this);
 
     //Atribui valor na porta de acordo com o duty.
     if(this->port!=NULL && this->enabled!=FALSE){
-      if(duty>0.5){
+      if(duty16>fxPwm_DUTY16_MAX/2){
         *this->port |= this->mask;
       }else{
         *this->port &= ~this->mask;
@@ -200,49 +382,202 @@ void fxPwm_Port::SetPeriodAndDuty(TIME_US period, FLOAT duty){
     }
     
     fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+    this->engine->UpdateFrame();
+#endif
     return;
   }
   
-  //Calcular períodos.
-  
-  //Soma 500 para melhorar arredondamento.
-  UINT32 periodClk = (UINT32)((UINT64)period * 1000 + 500)/((UINT64)fxPwm_T1::nsPerTimerClock);
-
-  //Período em nível ALTO e BAIXO.
-  UINT32 highPeriod = (UINT32)((FLOAT)periodClk * duty);
-  UINT32 lowPeriod = periodClk - highPeriod;
+  if(this->enabled!=FALSE && this->port!=NULL && this->periodClk!=0){
+    //A porta está modulando. Entregar os valores ao Tick() pelo contador de sequência:
+    //ímpar durante a escrita, par quando os valores estão completos.
+    //Se o Tick() interromper no meio, ele vê o contador ímpar e deixa para o próximo período.
+    this->periodClk = periodClk;
+    this->duty16 = duty16;
+    this->shadowSeq++;
+    this->shadowHigh = highPeriod;
+    this->shadowLow = lowPeriod;
+    this->shadowSeq++;
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+    this->engine->frameDirty = TRUE;
+    this->engine->UpdateFrame();
+#endif
+    return;
+  }
 
+  //A porta não está modulando. Os valores podem ser atribuídos diretamente.
   //Calcula previsão do próximo evento.
-  TIME_CLOCK minNext = periodClk + fxPwm.clockCount;
+  TIME_CLOCK minNext = periodClk + this->engine->clockCount;
 
   //Atribui todos valores.
   fxPwm_SaveSREG();cli();
   
-  this->period = period;
-  this->duty = duty;
+  this->periodClk = periodClk;
+  this->duty16 = duty16;
   
   if(this->port!=NULL && this->ddr!=NULL && this->enabled!=FALSE){
     //Somente agendar próximo evento se estiver tudo certo.
-    this->next = (this->next>minNext)?(minNext):(this->next);
-    fxPwm.SetNextFireMin(this->next);
+    if(this->scheduled==FALSE || fxPwm_TIME_BEFORE(minNext, this->next)){
+      this->next = minNext;
+    }
+    this->scheduled = TRUE;
+    this->engine->Reschedule(this);
   }else{
     this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
+    this->engine->Reschedule(this);
   }
   
   this->highPeriod = highPeriod;
   this->lowPeriod = lowPeriod;
+  this->shadowHigh = highPeriod;
+  this->shadowLow = lowPeriod;
+  this->latchedSeq = this->shadowSeq;
 
   fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->engine->UpdateFrame();
+#endif
 
   return;
 }
 
+void fxPwm_Port::SetPeriodClk(UINT32 periodClk){
+  this->SetPeriodClkAndDuty16(periodClk, this->duty16);
+}
+
 void fxPwm_Port::SetPeriod(TIME_US period){
-  this->SetPeriodAndDuty(period, this->GetDuty());
+  this->SetPeriodClkAndDuty16(fxPwm_T1::MicrosToClk(period), this->duty16);
+}
+
+//Atribui o ciclo de trabalho de 16 bits, aplicando o mapeamento inteiro se houver.
+void fxPwm_Port::SetDuty16(UINT16 duty16){
+  fxPwm_PortMap *map = (this->map!=0xFF)?(&maps[this->map]):(NULL);
+  if(map!=NULL && map->value1!=map->value2){
+    //Limita o valor ao intervalo mapeado, para que a conta caiba em 32 bits.
+    UINT16 low = (map->value1<map->value2)?(map->value1):(map->value2);
+    UINT16 high = (map->value1<map->value2)?(map->value2):(map->value1);
+    duty16 = (duty16<low)?(low):((duty16>high)?(high):(duty16));
+    //Inclinação em 1/32768, com arredondamento.
+    INT32 mapped = (INT32)map->duty1 + ((((INT32)duty16 - (INT32)map->value1)*map->slope + 16384)>>15);
+    duty16 = (mapped<0)?(0):((mapped>fxPwm_DUTY16_MAX)?(fxPwm_DUTY16_MAX):((UINT16)mapped));
+  }
+  this->SetPeriodClkAndDuty16(this->periodClk, duty16);
+}
+
+//Calcula os parâmetros do mapeamento inteiro. Só aqui há uma divisão.
+void fxPwm_Port::SetMap16(UINT16 dutyValue1, UINT16 mappedValue1, UINT16 dutyValue2, UINT16 mappedValue2){
+  if(mappedValue1 == mappedValue2){
+    //Não há diferença. Não mexer.
+    return;
+  }
+  fxPwm_PortMap value;
+  this->GetMap(&value);
+  value.slope = ((INT32)dutyValue2 - (INT32)dutyValue1)*32768/((INT32)mappedValue2 - (INT32)mappedValue1);
+  value.duty1 = dutyValue1;
+  value.value1 = mappedValue1;
+  value.value2 = mappedValue2;
+  this->ChangeMap(&value);
+
+  return;
+}
+
+void fxPwm_Port::GetMap(fxPwm_PortMap *value){
+  if(this->map!=0xFF){
+    *value = maps[this->map];
+    return;
+  }
+#ifndef fxPwm_NO_FLOAT
+  value->multi = 1.0;
+  value->delta = 0.0;
+#endif
+  value->value1 = 0;
+  value->value2 = 0;
+  value->duty1 = 0;
+  value->slope = 0;
+
+  return;
+}
+
+//A posição antiga é soltada antes da procura, para que possa ser reaproveitada se só esta porta a usava.
+void fxPwm_Port::ChangeMap(const fxPwm_PortMap *value){
+  UINT8 old = this->map;
+  UINT8 found = 0xFF;
+  UINT8 t;
+  fxPwm_PortMap *entry;
+
+  if(old!=0xFF){
+    maps[old].users--;
+  }
+  this->map = 0xFF;
+
+#ifndef fxPwm_NO_FLOAT
+  if(value->value1==value->value2 && value->multi==1.0 && value->delta==0.0){
+#else
+  if(value->value1==value->value2){
+#endif
+    //Identidade: sem posição.
+    return;
+  }
+
+  for(t=0;t<fxPwm_MaxMaps;t++){
+    entry = &maps[t];
+    if(entry->users==0){
+      found = (found==0xFF)?(t):(found);
+      continue;
+    }
+#ifndef fxPwm_NO_FLOAT
+    if(entry->multi!=value->multi || entry->delta!=value->delta){
+      continue;
+    }
+#endif
+    if(entry->value1==value->value1 && entry->value2==value->value2 && entry->duty1==value->duty1 && entry->slope==value->slope){
+      //Mesmo mapeamento de outra porta.
+      found = t;
+      break;
+    }
+  }
+
+  if(found==0xFF){
+    //Tabela cheia: fica o mapeamento antigo.
+    if(old!=0xFF){
+      maps[old].users++;
+    }
+    this->map = old;
+    return;
+  }
+  if(maps[found].users==0){
+    maps[found] = *value;
+    maps[found].users = 0;
+  }
+  maps[found].users++;
+  this->map = found;
+
+  return;
+}
+
+#ifndef fxPwm_NO_FLOAT
+//Aplica o mapeamento do ciclo de trabalho e o converte para 16 bits.
+UINT16 fxPwm_Port::MapDuty(FLOAT duty){
+  //Obtém valor mapeado do duty.
+  if(this->map!=0xFF){
+    duty = duty * maps[this->map].multi + maps[this->map].delta;
+  }
+  
+  //Acerta o duty.
+  duty = (duty<0.0)?(0.0):((duty>1.0)?(1.0):(duty));
+
+  return (UINT16)(duty*(FLOAT)fxPwm_DUTY16_MAX + 0.5);
+}
+
+//Atribui o período, em microssegundos, e o ciclo de trabalho mapeado.
+//Escrever período 0 faz a modulação parar. O valor que fica na porta é BAIXO se duty<=0.5, e ALTO se duty>0.5.
+void fxPwm_Port::SetPeriodAndDuty(TIME_US period, FLOAT duty){
+  this->SetPeriodClkAndDuty16(fxPwm_T1::MicrosToClk(period), this->MapDuty(duty));
 }
 
 void fxPwm_Port::SetDuty(FLOAT duty){
-  this->SetPeriodAndDuty(this->GetPeriod(), duty);
+  this->SetPeriodClkAndDuty16(this->periodClk, this->MapDuty(duty));
 }
 
 //Atribui frequência. Se frequency<=0.0, atribui período 0.
@@ -251,7 +586,7 @@ void fxPwm_Port::SetFrequencyAndDuty(FLOAT frequency, FLOAT duty){
 }
 
 void fxPwm_Port::SetFrequency(FLOAT frequency){
-  this->SetFrequencyAndDuty(frequency, this->GetDuty());
+  this->SetPeriodClkAndDuty16(fxPwm_T1::MicrosToClk((frequency<=0.0)?(0):((TIME_US)(1000000.0/(FLOAT)frequency+0.5))), this->duty16);
 }
 
 //Calcula os parâmetros de mapeamento do ciclo de trabalho.
@@ -260,19 +595,50 @@ void fxPwm_Port::SetMap(FLOAT dutyValue1, FLOAT mappedValue1, FLOAT dutyValue2,
     //Não há diferença. Não mexer.
     return;
   }
-  this->dutyMapMulti = (dutyValue2 - dutyValue1) / (mappedValue2 - mappedValue1);
-  this->dutyMapDelta = dutyValue1 - mappedValue1*dutyMapMulti;
+  fxPwm_PortMap value;
+  this->GetMap(&value);
+  value.multi = (dutyValue2 - dutyValue1) / (mappedValue2 - mappedValue1);
+  value.delta = dutyValue1 - mappedValue1*value.multi;
+  this->ChangeMap(&value);
 
   return;
 }
+#endif
 
 //Habilita a modulação PWM na porta.
 //Coloca a porta em estado de saída e em nível BAIXO.
 void fxPwm_Port::Enable(){
+  if(this->lockGroup!=NULL){
+    //Porta de um grupo travado (EnableAll()).
+    this->lockGroup->Enable();
+    return;
+  }
   //Não habilitar se já estiver habilitado OU se algo estiver errado.
   if(this->enabled!=FALSE || this->pinNumber==0xFF){
     return;
   }
+  if(this->hw!=FALSE){
+    //PWM por hardware: começa já, sem agendamento, mesmo dentro de um lote.
+    this->enabled = TRUE;
+    fxPwm_HAL_HwPwmWrite(this->pinNumber, fxPwm_HW_DUTY8(this->duty16));
+    return;
+  }
+
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_FRAME
+  //Fase de começo, escolhida antes de desabilitar interrupções.
+  TIME_CLOCK ref = 0;
+  UINT32 phase = 0;
+  BOOL stagger = (this->engine->stagger!=FALSE && this->pdm==FALSE && this->periodClk!=0 && this->engine->batchDepth==0)?(TRUE):(FALSE);
+  if(stagger!=FALSE){
+    {
+      fxPwm_SaveSREG();cli();
+      ref = this->engine->clockCount;
+      fxPwm_RestoreSREG();
+    }
+    phase = this->engine->StaggerPhase(this, ref);
+  }
+#endif
+
   fxPwm_SaveSREG();cli();
 
   //Configurar modo de saída e colocar em nível BAIXO.
@@ -281,19 +647,199 @@ void fxPwm_Port::Enable(){
   this->outHint = 0x00;
 
   //Se não tiver período, não agendar evento.
-  if(this->period==0){
+  //Dentro de um lote, a porta só começa no EndUpdate(), junto com as outras.
+  //Em modo PDM, o nível é decidido pelo passo do PDM, sem evento próprio.
+  if(this->pdm!=FALSE || this->periodClk==0){
+    this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
+  }else if(this->engine->batchDepth>0){
     this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
+    this->staged = TRUE;
   }else{
-    this->next = fxPwm.clockCount;
-    fxPwm.SetNextFireMin(this->next);
+    this->next = this->engine->clockCount;
+#if fxPwm_Scheduler!=fxPwm_SCHEDULER_FRAME
+    if(stagger!=FALSE){
+      this->next = fxPwm_T1::StaggerNext(ref, phase, this->periodClk, this->engine->clockCount);
+    }
+#endif
+    this->scheduled = TRUE;
+    this->engine->Reschedule(this);
   }
   this->enabled = TRUE;
   fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->engine->UpdateFrame();
+#endif
+}
+
+//Liga ou desliga o modo de densidade de pulsos (PDM).
+//Ao desligar, a porta volta a modular pelo período guardado, a partir de agora.
+void fxPwm_Port::SetPdm(BOOL pdm){
+  pdm = (pdm!=FALSE)?(TRUE):(FALSE);
+  if(pdm==this->pdm || this->lockGroup!=NULL){
+    return;
+  }
+
+  if(pdm!=FALSE){
+    if(this->hw!=FALSE){
+      //O PDM é feito pelo Tick(): o timer do pino para.
+      fxPwm_HAL_HwPwmOff(this->pinNumber);
+      this->hw = FALSE;
+    }
+    fxPwm_SaveSREG();cli();
+    //Sai do agendamento por bordas e começa em nível BAIXO, com o acumulador zerado.
+    this->next = fxPwm_NO_NEXT_EVENT;
+    this->scheduled = FALSE;
+    this->staged = FALSE;
+    this->engine->Reschedule(this);
+    if(this->port!=NULL && this->enabled!=FALSE){
+      *this->port &= ~this->mask;
+    }
+    this->outHint = 0x00;
+    this->pdmDuty = this->duty16;
+    this->pdmAccumulator = 0;
+    this->pdm = TRUE;
+    this->engine->PdmLink(this);
+    fxPwm_RestoreSREG();
+  }else{
+    BOOL enabled = this->enabled;
+    fxPwm_SaveSREG();cli();
+    this->engine->PdmUnlink(this);
+    this->pdm = FALSE;
+    this->enabled = FALSE;
+    if(this->port!=NULL){
+      *this->port &= ~this->mask;
+    }
+    this->outHint = 0x00;
+    fxPwm_RestoreSREG();
+    //Recalcula os períodos e volta a agendar bordas.
+    this->SetPeriodClkAndDuty16(this->periodClk, this->duty16);
+    if(enabled!=FALSE){
+      this->Enable();
+    }
+  }
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->engine->frameDirty = TRUE;
+  this->engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+//Indica se a porta está em modo PDM.
+BOOL fxPwm_Port::GetPdm(){
+  return this->pdm;
+}
+
+//Atribui uma trajetória. A porta é reavaliada com o ciclo de trabalho que fica:
+//com trajetória, ela sai do PWM por hardware; sem, pode voltar para ele.
+void fxPwm_Port::SetTrajectory(fxPwm_Trajectory *trajectory){
+  if(trajectory==this->trajectory || this->lockGroup!=NULL){
+    return;
+  }
+  if(trajectory!=NULL && trajectory->port!=NULL){
+    //Sai da porta anterior.
+    trajectory->port->SetTrajectory(NULL);
+  }
+
+  fxPwm_Trajectory *old = this->trajectory;
+  fxPwm_SaveSREG();cli();
+  if(old!=NULL){
+    old->port = NULL;
+  }
+  if(trajectory!=NULL){
+    if(trajectory->mode==fxPwm_TRAJECTORY_NONE){
+      //Nunca configurada: começa no ciclo de trabalho da porta.
+      trajectory->value = (UINT32)this->duty16<<16;
+      trajectory->mode = fxPwm_TRAJECTORY_HOLD;
+    }
+    trajectory->port = this;
+  }
+  this->trajectory = trajectory;
+  fxPwm_RestoreSREG();
+
+  this->SetPeriodClkAndDuty16(this->periodClk, (old!=NULL && trajectory==NULL)?(old->GetDuty16()):(this->duty16));
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Portas com trajetória não cabem na tabela de bordas.
+  this->engine->frameDirty = TRUE;
+  this->engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+fxPwm_Trajectory *fxPwm_Port::GetTrajectory(){
+  return this->trajectory;
+}
+
+//Atribui uma varredura. Sem varredura, a porta fica no último período dela, e é reavaliada:
+//pode voltar para o PWM por hardware.
+void fxPwm_Port::SetGlide(fxPwm_Glide *glide){
+  if(glide==this->glide || this->lockGroup!=NULL){
+    return;
+  }
+  if(glide!=NULL && glide->port!=NULL){
+    //Sai da porta anterior.
+    glide->port->SetGlide(NULL);
+  }
+
+  fxPwm_Glide *old = this->glide;
+  fxPwm_SaveSREG();cli();
+  if(old!=NULL){
+    old->port = NULL;
+  }
+  if(glide!=NULL){
+    glide->duty16 = this->duty16;
+    glide->port = this;
+  }
+  this->glide = glide;
+  fxPwm_RestoreSREG();
+
+  this->SetPeriodClkAndDuty16((old!=NULL && glide==NULL && old->mode!=fxPwm_GLIDE_NONE)?(old->GetPeriodClk()):(this->periodClk), this->duty16);
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  //Portas com varredura não cabem na tabela de bordas.
+  this->engine->frameDirty = TRUE;
+  this->engine->UpdateFrame();
+#endif
+
+  return;
+}
+
+fxPwm_Glide *fxPwm_Port::GetGlide(){
+  return this->glide;
+}
+
+//Indica se a porta está no PWM por hardware do pino.
+BOOL fxPwm_Port::IsHardware(){
+  return this->hw;
+}
+
+//Desliga o PWM por hardware. A porta fica desabilitada, e quem chama decide se volta a habilitar.
+BOOL fxPwm_Port::HwRelease(){
+  BOOL enabled = this->enabled;
+  fxPwm_HAL_HwPwmOff(this->pinNumber);
+  fxPwm_SaveSREG();cli();
+  this->hw = FALSE;
+  this->enabled = FALSE;
+  this->outHint = 0x00;
+  fxPwm_RestoreSREG();
+
+  return enabled;
 }
 
 //Desabilita a porta, inibindo modulação.
 //Coloca a saída em nível BAIXO.
 void fxPwm_Port::Disable(){
+  if(this->lockGroup!=NULL){
+    //Porta de um grupo travado (DisableAll()).
+    this->lockGroup->Disable();
+    return;
+  }
+  if(this->hw!=FALSE){
+    //O timer do pino para. A porta continua no PWM por hardware, para o próximo Enable().
+    fxPwm_HAL_HwPwmOff(this->pinNumber);
+  }
   fxPwm_SaveSREG();cli();
   if(this->port!=NULL){
     //Escrever nível BAIXO na saída.
@@ -302,7 +848,12 @@ void fxPwm_Port::Disable(){
   }
   this->enabled = FALSE;
   this->next = fxPwm_NO_NEXT_EVENT;
+  this->scheduled = FALSE;
+  this->engine->Reschedule(this);
   fxPwm_RestoreSREG();
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  this->engine->UpdateFrame();
+#endif
 }
 
-
+
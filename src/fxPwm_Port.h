@@ -10,6 +10,20 @@
  *  -----------------------------------------------------------
  *  21-07-2018: primeira documentação.
  *  25-07-2018: destrutor.
+ *  17-10-2026: grupo do registrador PORTx.
+ *  17-10-2026: períodos com buffer duplo (shadowHigh, shadowLow).
+ *  17-10-2026: período em ciclos do timer e ciclo de trabalho em 16 bits. Mapeamento inteiro.
+ *  17-10-2026: marcação de mudança pendente num lote (staged).
+ *  17-10-2026: posição na lista de portas (index) e marcação de alocação interna.
+ *  17-10-2026: marcação de evento agendado (scheduled), no lugar de comparar com fxPwm_NO_NEXT_EVENT.
+ *  17-10-2026: fase escolhida pelo escalonamento (phase).
+ *  17-10-2026: porta que representa um grupo travado no agendador (lockGroup).
+ *  17-10-2026: modo de densidade de pulsos (pdm).
+ *  17-10-2026: motor em que a porta está registrada (engine).
+ *  17-10-2026: porta no PWM por hardware do pino (hw).
+ *  17-10-2026: trajetória do ciclo de trabalho avançada pelo Tick() (trajectory).
+ *  17-10-2026: varredura do período avançada pelo Tick() (glide).
+ *  17-10-2026: campos do Tick() no começo do objeto. Mapeamentos numa tabela dividida entre as portas (map).
  */
 
 #ifndef fxPwm_Port_H
@@ -17,52 +31,185 @@
 
 #include <fxPwmTypes.h>
 
+class fxPwm_LockGroup;
+class fxPwm_Trajectory;
+class fxPwm_Glide;
+class fxPwm_Queue;
+class fxPwm_T1;
+
 //Marcação de que não há um próximo evento no canal atual.
+//Só informativa: como os tempos dão a volta, quem diz se há evento é fxPwm_Port::scheduled.
 #define fxPwm_NO_NEXT_EVENT TIME_US_MAX
 
+//Comparações de tempo, em ciclos do timer, que continuam certas quando o clockCount dá a volta.
+//A diferença é lida com sinal, então valem enquanto os tempos comparados estiverem a menos de meia volta um do outro.
+#define fxPwm_TIME_DIFF(a,b)    ((TIME_CLOCK_DIFF)((TIME_CLOCK)(a)-(TIME_CLOCK)(b)))
+//a acontece antes de b.
+#define fxPwm_TIME_BEFORE(a,b)  (fxPwm_TIME_DIFF(a,b)<0)
+//O instante now já chegou em event.
+#define fxPwm_TIME_REACHED(now,event) (fxPwm_TIME_DIFF(now,event)>=0)
+
+//Maior período aceito, em ciclos do timer: um quarto da volta do clockCount,
+//para que os eventos agendados fiquem sempre bem dentro da janela das comparações.
+#define fxPwm_MAX_PERIOD_CLK ((TIME_CLOCK)1<<(sizeof(TIME_CLOCK)*8-2))
+
+//Ciclo de trabalho de 16 bits que corresponde a 100%.
+#define fxPwm_DUTY16_MAX 0xFFFF
+
+//Período ALTO, em ciclos do timer, de um período com um ciclo de trabalho de 16 bits.
+//periodClk*duty16/65536 em duas multiplicações de 32 bits, sem estourar.
+#define fxPwm_DUTY_CLK(periodClk, duty16) (((duty16)==fxPwm_DUTY16_MAX)?(periodClk): \
+  (((periodClk)>>16)*(UINT32)(duty16) + ((((periodClk)&0xFFFF)*(UINT32)(duty16))>>16)))
+
+//Máximo de mapeamentos do ciclo de trabalho diferentes (SetMap, SetMap16) em uso ao mesmo tempo, somando
+//todas as portas. Portas com o mesmo mapeamento dividem uma posição. Ocupa 19 bytes por posição no AVR
+//(11 com fxPwm_NO_FLOAT), no lugar de 18 bytes em cada porta.
+#ifndef fxPwm_MaxMaps
+#define fxPwm_MaxMaps 4
+#endif
+
+//Origem de uma porta (fxPwm_Port::internal).
+#define fxPwm_PORT_USER 0
+#define fxPwm_PORT_POOL 1
+#define fxPwm_PORT_HEAP 2
+
+//Mapeamento do ciclo de trabalho, dividido entre as portas que o usam.
+struct fxPwm_PortMap{
+#ifndef fxPwm_NO_FLOAT
+  //Mapeamento de SetMap(): dutyMap = multi*duty + delta.
+  FLOAT multi;
+  FLOAT delta;
+#endif
+  //Mapeamento inteiro de SetMap16().
+  //duty16 = duty1 + (valor - value1)*slope/32768, com o valor limitado entre value1 e value2.
+  //Sem mapeamento se value1==value2.
+  UINT16 value1;
+  UINT16 value2;
+  UINT16 duty1;
+  INT32 slope;
+  //Portas que usam a posição, ou 0 se ela estiver livre.
+  UINT8 users;
+};
+
 //Classe que encapsula dados de uma porta,
 //e métodos para manipulação dela.
 class fxPwm_Port{
 private:
-  //Indica se o canal está habilitado para modulação.
-  volatile BOOL enabled;
-  //Guarda número do pino associado, ou 0xFF se nada tiver associado.
-  UINT8 pinNumber;
+  //Campos lidos e escritos pelo Tick(), juntos no começo do objeto: no AVR, o acesso por ponteiro com
+  //deslocamento (ldd/std) só alcança 63 bytes, e campos além disso custam instruções a mais.
+
+  //Próximo evento agendado.
+  volatile TIME_US next;
+  //Indica que next é um evento agendado. Se for FALSE, o Tick() ignora a porta.
+  volatile BOOL scheduled;
+  //Dica para o valor da saída.
+  volatile BYTE outHint;
 
-  //Valores de referência para mapeamento do ciclo de trabalho.
-  //O valor mapeado do ciclo de trabalho é dado pela equação:
-  //dutyMap = dutyMapMulti*duty + dutyMapDelta.
-  FLOAT dutyMapMulti;
-  FLOAT dutyMapDelta;
+  //Período ALTO, em ciclos do timer.
+  volatile TIME_US highPeriod;
+  //Período BAIXO, em ciclos do timer.
+  volatile TIME_US lowPeriod;
 
   //Ponteiro para o registrador da porta.
   volatile BYTE *port;
-  //Ponteiro para o registrador de direção da forta.
-  volatile BYTE *ddr;
   //Valor da máscara correspondente.
   volatile BYTE mask;
-  //Dica para o valor da saída.
-  volatile BYTE outHint;
+  //Grupo do registrador PORTx no agendador, ou 0xFF se não tiver.
+  UINT8 group;
 
-  //Período da classe, em microssegundos.
-  TIME_US period;
-  //Ciclo de trabalho.
-  FLOAT duty;
+  //Grupo travado representado por esta porta, ou NULL para uma porta comum.
+  //Uma porta assim não tem pino: o Tick() executa a tabela do grupo no lugar das bordas.
+  fxPwm_LockGroup *lockGroup;
 
-  //Próximo evento agendado.
-  volatile TIME_US next;
+  //Contador de sequência dos períodos pedidos: ímpar enquanto estão sendo escritos.
+  volatile UINT8 shadowSeq;
+  //Valor de shadowSeq na última cópia feita pelo Tick().
+  UINT8 latchedSeq;
+  //Períodos ALTO e BAIXO pedidos por último, em ciclos do timer.
+  //O Tick() os copia para highPeriod e lowPeriod no início do próximo período.
+  volatile TIME_US shadowHigh;
+  volatile TIME_US shadowLow;
 
-  //Período ALTO, em ciclos do timer.
-  volatile TIME_US highPeriod;
-  //Período BAIXO, em ciclos do timer.
-  volatile TIME_US lowPeriod;
+  //Varredura do período, avançada pelo Tick() no início de cada período, ou NULL.
+  fxPwm_Glide *glide;
+  //Trajetória do ciclo de trabalho, avançada pelo Tick() no início de cada período, ou NULL.
+  fxPwm_Trajectory *trajectory;
+
+  //Posição da porta no heap do agendador, ou 0xFF se não estiver nele.
+  UINT8 heapIndex;
+
+  //Indica se o canal está habilitado para modulação.
+  volatile BOOL enabled;
+  //Próxima porta da lista do PDM (fxPwm_T1::pdmPorts).
+  fxPwm_Port *pdmNextPort;
+  //Ciclo de trabalho usado pelo passo do PDM. Só muda fora de um lote.
+  volatile UINT16 pdmDuty;
+  //Acumulador do PDM: o nível é ALTO nos passos em que a soma passa de fxPwm_DUTY16_MAX.
+  UINT16 pdmAccumulator;
+
+  //Daqui em diante, configuração, usada fora da interrupção.
+
+  //Guarda número do pino associado, ou 0xFF se nada tiver associado.
+  UINT8 pinNumber;
+  //Ponteiro para o registrador de direção da forta.
+  volatile BYTE *ddr;
+
+  //Período, em ciclos do timer.
+  UINT32 periodClk;
+  //Ciclo de trabalho já mapeado, de 0 (0%) até fxPwm_DUTY16_MAX (100%).
+  UINT16 duty16;
+  //Mapeamento do ciclo de trabalho (SetMap, SetMap16): posição em maps, ou 0xFF sem mapeamento.
+  UINT8 map;
+
+  //Indica que a porta mudou dentro de um lote (fxPwm_T1::BeginUpdate) e espera o EndUpdate().
+  BOOL staged;
+  //Fase de começo escolhida pelo escalonamento (fxPwm_T1::SetStagger) antes do EndUpdate(), em ciclos do timer.
+  UINT32 phase;
+
+  //Posição da porta na lista de portas registradas (fxPwm_T1::ports), ou 0xFF se não estiver registrada.
+  UINT8 index;
+  //Motor em que a porta está registrada. Fora de um motor, o fxPwm.
+  fxPwm_T1 *engine;
+  //Indica que a porta foi alocada pelo RegisterPort(pin) (fxPwm_PORT_POOL ou fxPwm_PORT_HEAP),
+  //e deve ser devolvida ao ser removida. fxPwm_PORT_USER para portas do programa.
+  UINT8 internal;
+
+  //Indica que a porta está em modo de densidade de pulsos (PDM): sem agendamento por bordas,
+  //o nível é decidido a cada passo do PDM (fxPwm_T1::pdmPeriod) por um acumulador de primeira ordem.
+  BOOL pdm;
+
+  //Indica que o timer do pino gera o sinal sozinho (fxPwm_T1::HwAccepts()): sem agendamento por bordas,
+  //o ciclo de trabalho vai para o analogWrite(). Os períodos ALTO e BAIXO continuam calculados,
+  //para a volta ao agendamento.
+  BOOL hw;
+
+  //Mapeamentos em uso, de todas as portas. Portas com o mesmo mapeamento dividem uma posição.
+  static fxPwm_PortMap maps[fxPwm_MaxMaps];
+  //Troca o mapeamento da porta por value, dividindo uma posição igual ou ocupando uma livre.
+  //Sem posição livre, o mapeamento não muda.
+  void ChangeMap(const fxPwm_PortMap *value);
+  //Copia o mapeamento da porta em value (sem mapeamento, a identidade).
+  void GetMap(fxPwm_PortMap *value);
+
+#ifndef fxPwm_NO_FLOAT
+  //Aplica o mapeamento e converte um ciclo de trabalho para 16 bits.
+  UINT16 MapDuty(FLOAT duty);
+#endif
 
   //Realiza limpeza.
   void Cleanup();
+  //Desabilita a porta, a solta da trajetória, da varredura e do mapeamento, e a limpa. Usado pelo destrutor
+  //e pela devolução ao fxPwm_T1::pool.
+  void Release();
   //Recalcula parâmetros de fase da classe, e agenda próximo evento.
   void ResetPhase();
+  //Desliga o PWM por hardware do pino, deixando a porta desabilitada em nível BAIXO.
+  //Retorna se a porta estava habilitada.
+  BOOL HwRelease();
 public:
   friend class fxPwm_T1;
+  friend class fxPwm_LockGroup;
+  friend class fxPwm_Queue;
 
   //Atribui um pino.
   void SetPinNumber(UINT8 pinNumber);
@@ -74,14 +221,20 @@ public:
   //Destrutor.
   ~fxPwm_Port();
 
-  //Retorna o período configurado.
+  //Retorna o período configurado, em microssegundos.
   TIME_US GetPeriod();
+  //Retorna o período configurado, em ciclos do timer.
+  UINT32 GetPeriodClk();
+  //Retorna o ciclo de trabalho sem mapeamento, de 0 até fxPwm_DUTY16_MAX.
+  UINT16 GetRawDuty16();
+#ifndef fxPwm_NO_FLOAT
   //Retorna o ciclo de trabalho configurado, com mapeamento. Inicialmente 0.5.
   FLOAT GetDuty();
   //Retorna o ciclo de trabalho sem mapeamento.
   FLOAT GetRawDuty();
   //Retorna a frequência configurada.
   FLOAT GetFrequency();
+#endif
 
   //Retorna o estado lógico do pino (LOW, HIGH)
   BOOL GetPinState();
@@ -89,17 +242,63 @@ public:
   //Atribui o estado lógico do pino. (LOW, HIGH)
   void SetPinState(BOOL state);
 
+  //Atribui o período, em ciclos do timer, e o ciclo de trabalho sem mapeamento, de 0 até fxPwm_DUTY16_MAX.
+  //Todas as outras funções que atribuem período e ciclo de trabalho chamam essa. Não usa FLOAT.
+  void SetPeriodClkAndDuty16(UINT32 periodClk, UINT16 duty16);
+
+  //Atribui o período, em ciclos do timer.
+  void SetPeriodClk(UINT32 periodClk);
+  //Atribui o ciclo de trabalho de 16 bits, passando pelo mapeamento inteiro (SetMap16), se houver.
+  void SetDuty16(UINT16 duty16);
+  //Mapeia o ciclo de trabalho de 16 bits: SetDuty16(mappedValue1) resulta em dutyValue1, e SetDuty16(mappedValue2) em dutyValue2.
+  void SetMap16(UINT16 dutyValue1, UINT16 mappedValue1, UINT16 dutyValue2, UINT16 mappedValue2);
+
+  //Atribui o período, em microssegundos.
+  void SetPeriod(TIME_US period);
+
+#ifndef fxPwm_NO_FLOAT
   //Atribui o valor do período e o ciclo de trabalho.
   void SetPeriodAndDuty(TIME_US period, FLOAT duty);
 
   //Atribui várias variáveis.
-  void SetPeriod(TIME_US period);
   void SetDuty(FLOAT duty);
   void SetFrequencyAndDuty(FLOAT frequency, FLOAT duty);
   void SetFrequency(FLOAT frequency);
 
   //Mapeia o ciclo de trabalho.
   void SetMap(FLOAT dutyValue1, FLOAT mappedValue1, FLOAT dutyValue2, FLOAT mappedValue2);
+#endif
+
+  //Liga ou desliga o modo de densidade de pulsos (PDM).
+  //Nesse modo a frequência não importa: a cada passo do PDM, comum a todas as portas PDM, a saída fica ALTA
+  //ou BAIXA de modo que a média siga o ciclo de trabalho, com resolução de 16 bits.
+  //O período atribuído fica guardado e volta a valer quando o modo é desligado.
+  void SetPdm(BOOL pdm);
+  //Indica se a porta está em modo PDM.
+  BOOL GetPdm();
+
+  //Atribui uma trajetória ao ciclo de trabalho (veja fxPwm_Trajectory), ou a tira com NULL.
+  //Daí em diante o Tick() aplica o valor da trajetória no início de cada período, e o ciclo de trabalho
+  //atribuído pelas outras funções não vale (o período vale). Sem trajetória, a porta fica no último valor dela.
+  //Uma trajetória move uma porta só: atribuída a outra, sai da anterior. Sem efeito em portas PDM,
+  //e uma porta com trajetória não vai para o PWM por hardware.
+  void SetTrajectory(fxPwm_Trajectory *trajectory);
+  //Retorna a trajetória da porta, ou NULL.
+  fxPwm_Trajectory *GetTrajectory();
+
+  //Atribui uma varredura ao período (veja fxPwm_Glide), ou a tira com NULL.
+  //Enquanto a varredura tiver modo, o Tick() aplica o período dela no início de cada período, com o ciclo de
+  //trabalho atribuído pelas outras funções, e o período atribuído por elas não vale. Sem varredura, a porta fica
+  //no último período dela. Uma varredura move uma porta só: atribuída a outra, sai da anterior.
+  //Sem efeito em portas PDM, e uma porta com varredura não vai para o PWM por hardware.
+  void SetGlide(fxPwm_Glide *glide);
+  //Retorna a varredura da porta, ou NULL.
+  fxPwm_Glide *GetGlide();
+
+  //Indica se a porta está no PWM por hardware do pino, fora do Tick().
+  //Com fxPwm_HW_PWM, a porta passa para o hardware sozinha quando o período atribuído bate com o do timer do pino
+  //e o ciclo de trabalho cabe em 8 bits (veja fxPwm_T1::HwAccepts()), e volta para o Tick() quando deixa de caber.
+  BOOL IsHardware();
 
   //Habilita a modulação PWM.
   void Enable();
@@ -108,4 +307,4 @@ public:
 };
 
 #endif
-
+
@@ -0,0 +1,145 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Queue.cpp
+ *  Arquivo contendo definição dos métodos da classe
+ *  fxPwm_Queue, o lado do produtor. A execução dos comandos
+ *  fica no Tick() (fxPwm_T1::TickQueue).
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_Queue.h>
+
+//Construtor.
+fxPwm_Queue::fxPwm_Queue(){
+  this->head = 0;
+  this->tail = 0;
+  this->cursor = 0;
+  this->engine = NULL;
+
+  return;
+}
+
+//Destrutor. Os comandos pendentes são descartados.
+fxPwm_Queue::~fxPwm_Queue(){
+  if(this->engine!=NULL){
+    this->engine->SetQueue(NULL);
+  }
+
+  return;
+}
+
+UINT8 fxPwm_Queue::Next(UINT8 index){
+  return (index+1>=fxPwm_QueueSize)?(0):(index+1);
+}
+
+//O relógio do motor só anda no Tick(): ler o TCNTx para saber o agora.
+void fxPwm_Queue::Sync(){
+  fxPwm_T1 *engine = this->engine;
+  if(engine==NULL || engine->IsAllocated()==FALSE){
+    return;
+  }
+
+  fxPwm_SaveSREG();cli();
+  UINT16 lastTCNT = *engine->hw->tcnt;
+  engine->clockCount += (TIME_CLOCK)(UINT16)(lastTCNT - engine->lastClock);
+  engine->lastClock = lastTCNT;
+  this->cursor = engine->clockCount + fxPwm_T1::minTimerDelta;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+void fxPwm_Queue::Wait(TIME_US delay){
+  this->cursor += fxPwm_T1::MicrosToClk(delay);
+}
+
+void fxPwm_Queue::WaitClk(UINT32 delayClk){
+  this->cursor += delayClk;
+}
+
+TIME_CLOCK fxPwm_Queue::GetCursor(){
+  return this->cursor;
+}
+
+BOOL fxPwm_Queue::Push(UINT8 pin, TIME_US period, UINT16 duty16, BOOL enable){
+  if(this->engine==NULL){
+    return FALSE;
+  }
+
+  return this->PushClk(this->engine->GetPort(pin), fxPwm_T1::MicrosToClk(period), duty16, enable);
+}
+
+//O comando é escrito inteiro antes de tail andar: o Tick() nunca vê um comando pela metade.
+BOOL fxPwm_Queue::PushClk(fxPwm_Port *port, UINT32 periodClk, UINT16 duty16, BOOL enable){
+  fxPwm_T1 *engine = this->engine;
+  //Só portas com pino, deste motor.
+  if(engine==NULL || port==NULL || port->engine!=engine || port->index==0xFF || port->lockGroup!=NULL || port->port==NULL){
+    return FALSE;
+  }
+  UINT8 tail = this->tail;
+  UINT8 next = Next(tail);
+  if(next==this->head){
+    //Cheia.
+    return FALSE;
+  }
+  //Períodos longos demais quebrariam as comparações de tempo.
+  if((TIME_CLOCK)periodClk>fxPwm_MAX_PERIOD_CLK){
+    periodClk = (UINT32)fxPwm_MAX_PERIOD_CLK;
+  }
+
+  fxPwm_Command *command = &this->commands[tail];
+  command->at = this->cursor;
+  command->port = port;
+  command->periodClk = periodClk;
+  command->duty16 = duty16;
+  command->enable = (enable!=FALSE)?(TRUE):(FALSE);
+  fxPwm_HAL_Barrier();
+  this->tail = next;
+
+  //O Tick() pode estar agendado para depois do comando.
+#if fxPwm_Scheduler==fxPwm_SCHEDULER_FRAME
+  if(engine->frameActive!=FALSE){
+    //A tabela de bordas ainda está saindo (SetQueue()): o Tick() acha o comando ao voltar ao SCAN.
+    return TRUE;
+  }
+#endif
+  engine->SetNextFireMin(command->at);
+
+  return TRUE;
+}
+
+UINT8 fxPwm_Queue::GetCount(){
+  UINT8 head = this->head;
+  UINT8 tail = this->tail;
+
+  return (tail>=head)?(tail - head):(fxPwm_QueueSize - head + tail);
+}
+
+UINT8 fxPwm_Queue::GetFree(){
+  return fxPwm_QueueSize - 1 - this->GetCount();
+}
+
+BOOL fxPwm_Queue::IsEmpty(){
+  return (this->head==this->tail)?(TRUE):(FALSE);
+}
+
+//Com interrupções desabilitadas, o programa pode mexer no índice do Tick().
+void fxPwm_Queue::Clear(){
+  fxPwm_SaveSREG();cli();
+  this->head = this->tail;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+fxPwm_T1 *fxPwm_Queue::GetEngine(){
+  return this->engine;
+}
@@ -0,0 +1,101 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Queue.h
+ *  Cabeçalho contendo declaração da classe fxPwm_Queue, uma
+ *  fila de comandos com hora marcada (período, ciclo de traba-
+ *  lho e habilitação de uma porta), preenchida pelo programa e
+ *  executada pelo Tick() no ciclo do timer pedido.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwm_Queue_H
+#define fxPwm_Queue_H
+
+#include <fxPwmTypes.h>
+
+class fxPwm_Port;
+class fxPwm_T1;
+
+//Capacidade de uma fila de comandos, de 2 até 255. Cada comando ocupa 13 bytes no AVR.
+#ifndef fxPwm_QueueSize
+#define fxPwm_QueueSize 16
+#endif
+
+//Comando com hora marcada.
+struct fxPwm_Command{
+  //Instante em que o comando vale, no relógio do motor (ciclos do timer).
+  TIME_CLOCK at;
+  //Porta do comando, ou NULL se ela foi removida do motor antes da hora.
+  fxPwm_Port *port;
+  //Período, em ciclos do timer, e ciclo de trabalho, de 0 até fxPwm_DUTY16_MAX.
+  UINT32 periodClk;
+  UINT16 duty16;
+  //Habilita a porta com esses valores, ou a desabilita (nível BAIXO).
+  BOOL enable;
+};
+
+//Classe que encapsula uma fila de comandos de um motor (fxPwm_T1::SetQueue).
+//É um buffer circular sem travas, com um produtor (o programa, fora de interrupções) e um consumidor
+//(o Tick()): cada lado só escreve o seu índice, de um byte. O Tick() executa cada comando quando chega
+//a hora dele, com a precisão do timer, e a porta recomeça o período nesse instante.
+//Os instantes são marcados por um cursor: Sync() o traz para agora, Wait() o avança, e Push() coloca
+//um comando nele. Assim uma sequência tocada com Wait() não acumula o atraso do programa.
+class fxPwm_Queue{
+private:
+  //Comandos. Posições de head até tail (exclusive) estão pendentes.
+  fxPwm_Command commands[fxPwm_QueueSize];
+  //Próximo comando a executar, escrito só pelo Tick().
+  volatile UINT8 head;
+  //Próxima posição livre, escrita só pelo programa.
+  volatile UINT8 tail;
+
+  //Instante dos próximos comandos, no relógio do motor.
+  TIME_CLOCK cursor;
+
+  //Motor que executa a fila, ou NULL.
+  fxPwm_T1 *engine;
+
+  //Posição seguinte no buffer circular.
+  static UINT8 Next(UINT8 index);
+public:
+  friend class fxPwm_T1;
+
+  //Inicializa uma fila vazia.
+  fxPwm_Queue();
+
+  //Destrutor. Tira a fila do motor.
+  ~fxPwm_Queue();
+
+  //Traz o cursor para agora (mais fxPwm_MinTimerDelta, para que o primeiro comando não chegue atrasado).
+  void Sync();
+  //Avança o cursor.
+  void Wait(TIME_US delay);
+  void WaitClk(UINT32 delayClk);
+  //Retorna o cursor, no relógio do motor (ciclos do timer).
+  TIME_CLOCK GetCursor();
+
+  //Coloca um comando no cursor: período (em microssegundos) e ciclo de trabalho de um pino, e habilita
+  //ou desabilita. Retorna FALSE se a fila estiver cheia, se não estiver num motor, ou se o pino não
+  //estiver registrado nele (grupos travados não são aceitos).
+  BOOL Push(UINT8 pin, TIME_US period, UINT16 duty16, BOOL enable);
+  //Como Push(), com a porta e o período em ciclos do timer.
+  BOOL PushClk(fxPwm_Port *port, UINT32 periodClk, UINT16 duty16, BOOL enable);
+
+  //Quantidade de comandos pendentes e de posições livres.
+  UINT8 GetCount();
+  UINT8 GetFree();
+  //Indica se todos os comandos já foram executados.
+  BOOL IsEmpty();
+  //Descarta os comandos pendentes.
+  void Clear();
+
+  //Retorna o motor que executa a fila, ou NULL.
+  fxPwm_T1 *GetEngine();
+};
+
+#endif
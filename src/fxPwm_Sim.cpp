@@ -0,0 +1,355 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Sim.cpp
+ *  Implementação do simulador de host da biblioteca fxPwm.
+ *  No Arduino, esse arquivo não gera código.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: uma interrupção por vez, com uma instrução do programa principal entre elas.
+ *  17-10-2026: duração da interrupção mais longa.
+ *  17-10-2026: TIMER3, TIMER4 e TIMER5.
+ *  17-10-2026: PWM por hardware dos pinos.
+ *  17-10-2026: Print::write() de vários bytes.
+ */
+
+#include <fxPwm_Hal.h>
+
+#ifdef fxPwm_HOST
+
+#include <chrono>
+
+//Instância.
+fxPwm_Sim fxPwmSim;
+
+//===============================================================
+//Print
+//===============================================================
+
+//Escreve byte a byte, como a implementação padrão do núcleo do Arduino.
+size_t Print::write(const uint8_t *buffer, size_t size){
+  size_t n = 0;
+  while(size-->0){
+    n += this->write(*buffer++);
+  }
+
+  return n;
+}
+
+//===============================================================
+//fxPwm_SimTcnt
+//===============================================================
+
+//Leitura do contador. Consome alguns ciclos antes, de modo que
+//laços que esperam o contador avançar não fiquem presos.
+fxPwm_SimTcnt::operator uint16_t(){
+  fxPwmSim.Consume(fxPwm_SimTcntReadCycles);
+  return this->value;
+}
+
+//Escrita do contador.
+fxPwm_SimTcnt &fxPwm_SimTcnt::operator=(uint16_t value){
+  this->value = value;
+  return *this;
+}
+
+//===============================================================
+//fxPwm_SimTimer16
+//===============================================================
+
+fxPwm_SimTimer16::fxPwm_SimTimer16(){
+  this->compA = NULL;
+  this->compB = NULL;
+  this->Reset();
+
+  return;
+}
+
+//Zera todos registradores, como no reset do microcontrolador.
+void fxPwm_SimTimer16::Reset(){
+  this->residual = 0;
+  this->tcnt.value = 0;
+  this->icr = 0;
+  this->ocra = 0;
+  this->ocrb = 0;
+  this->tccra = 0;
+  this->tccrb = 0;
+  this->tccrc = 0;
+  this->timsk = 0;
+  this->tifr = 0;
+
+  return;
+}
+
+//Divisor de acordo com os bits CS do TCCRxB.
+uint16_t fxPwm_SimTimer16::GetDivider(){
+  switch(this->tccrb & 0b111){
+    case 0b001: return 1;
+    case 0b010: return 8;
+    case 0b011: return 64;
+    case 0b100: return 256;
+    case 0b101: return 1024;
+    default:    return 0; //Parado ou clock externo (não simulado).
+  }
+}
+
+//Avança o contador. A comparação acontece quando o contador passa a ser igual ao OCRx,
+//e o estouro quando passa de 0xFFFF para 0x0000.
+void fxPwm_SimTimer16::Advance(uint32_t cpuCycles){
+  uint16_t divider = this->GetDivider();
+  if(divider==0){
+    return;
+  }
+
+  uint64_t acc = (uint64_t)this->residual + cpuCycles;
+  uint64_t ticks = acc/divider;
+  this->residual = (uint32_t)(acc%divider);
+  if(ticks==0){
+    return;
+  }
+
+  uint16_t now = this->tcnt.value;
+  //Distância, em ciclos do timer, até cada evento. 0 significa uma volta inteira.
+  uint32_t toA = (uint16_t)(this->ocra - now);
+  uint32_t toB = (uint16_t)(this->ocrb - now);
+  uint32_t toOvf = (uint16_t)(0 - now);
+  toA = (toA==0)?(65536):(toA);
+  toB = (toB==0)?(65536):(toB);
+  toOvf = (toOvf==0)?(65536):(toOvf);
+
+  //TIFR: OCFxB=bit2, OCFxA=bit1, TOVx=bit0.
+  if(ticks>=toA){
+    this->tifr |= 0b010;
+  }
+  if(ticks>=toB){
+    this->tifr |= 0b100;
+  }
+  if(ticks>=toOvf){
+    this->tifr |= 0b001;
+  }
+
+  this->tcnt.value = (uint16_t)(now + ticks);
+
+  return;
+}
+
+//Calcula a distância, em ciclos de CPU, até a próxima comparação habilitada.
+uint32_t fxPwm_SimTimer16::CyclesToNextMatch(){
+  uint16_t divider = this->GetDivider();
+  if(divider==0 || (this->timsk & 0b110)==0){
+    return 0;
+  }
+
+  uint16_t now = this->tcnt.value;
+  uint32_t best = 65536;
+  if(this->timsk & 0b010){
+    uint32_t toA = (uint16_t)(this->ocra - now);
+    toA = (toA==0)?(65536):(toA);
+    best = (toA<best)?(toA):(best);
+  }
+  if(this->timsk & 0b100){
+    uint32_t toB = (uint16_t)(this->ocrb - now);
+    toB = (toB==0)?(65536):(toB);
+    best = (toB<best)?(toB):(best);
+  }
+
+  return best*divider - this->residual;
+}
+
+//===============================================================
+//fxPwm_Sim
+//===============================================================
+
+fxPwm_Sim::fxPwm_Sim(){
+  this->timer1.compA = fxPwm_Sim_Timer1CompA;
+  this->timer1.compB = fxPwm_Sim_Timer1CompB;
+  this->timer3.compA = fxPwm_Sim_Timer3CompA;
+  this->timer3.compB = fxPwm_Sim_Timer3CompB;
+  this->timer4.compA = fxPwm_Sim_Timer4CompA;
+  this->timer4.compB = fxPwm_Sim_Timer4CompB;
+  this->timer5.compA = fxPwm_Sim_Timer5CompA;
+  this->timer5.compB = fxPwm_Sim_Timer5CompB;
+  this->timers[0] = &this->timer1;
+  this->timers[1] = &this->timer3;
+  this->timers[2] = &this->timer4;
+  this->timers[3] = &this->timer5;
+  this->observer = NULL;
+  this->Reset();
+
+  return;
+}
+
+//Reseta registradores e contadores.
+void fxPwm_Sim::Reset(){
+  uint8_t t;
+  for(t=0;t<fxPwm_SimPorts;t++){
+    this->port[t] = 0;
+    this->ddr[t] = 0;
+    this->lastPort[t] = 0;
+  }
+  for(t=0;t<fxPwm_SimTimers;t++){
+    this->timers[t]->Reset();
+  }
+  for(t=0;t<NUM_DIGITAL_PINS;t++){
+    this->hwTimer[t] = 0xFF;
+    this->hwDuty[t] = -1;
+  }
+  this->sreg = 0x80;
+  this->inIsr = false;
+  this->cycles = 0;
+  this->isrCycles = 0;
+  this->isrCount = 0;
+  this->isrMaxCycles = 0;
+  this->isrHostNs = 0;
+
+  return;
+}
+
+//Avisa o observador sobre as portas que mudaram desde a última verificação.
+void fxPwm_Sim::Observe(){
+  uint8_t t;
+  for(t=0;t<fxPwm_SimPorts;t++){
+    uint8_t value = this->port[t];
+    if(value!=this->lastPort[t]){
+      if(this->observer!=NULL){
+        this->observer(t, this->lastPort[t], value, this->cycles);
+      }
+      this->lastPort[t] = value;
+    }
+  }
+
+  return;
+}
+
+//Consome ciclos. Mudanças nas portas feitas até aqui são datadas antes do avanço.
+void fxPwm_Sim::Consume(uint32_t cpuCycles){
+  this->Observe();
+  this->cycles += cpuCycles;
+  if(this->inIsr){
+    this->isrCycles += cpuCycles;
+  }
+  uint8_t t;
+  for(t=0;t<fxPwm_SimTimers;t++){
+    this->timers[t]->Advance(cpuCycles);
+  }
+
+  return;
+}
+
+//Atende a interrupção pendente de maior prioridade (TIMER1 antes dos outros, COMPA antes de COMPB).
+//O hardware limpa o bit I na entrada, e o RETI o restaura na saída.
+void fxPwm_Sim::Dispatch(){
+  while(!this->inIsr && (this->sreg & 0x80)){
+    void (*vector)(void) = NULL;
+    fxPwm_SimTimer16 *timer = NULL;
+    uint8_t pending = 0;
+    uint8_t t;
+    for(t=0;t<fxPwm_SimTimers && pending==0;t++){
+      timer = this->timers[t];
+      pending = timer->tifr & timer->timsk & 0b110;
+    }
+
+    if(pending & 0b010){
+      timer->tifr &= (uint8_t)~0b010;
+      vector = timer->compA;
+    }else if(pending & 0b100){
+      timer->tifr &= (uint8_t)~0b100;
+      vector = timer->compB;
+    }else{
+      return;
+    }
+
+    if(vector==NULL){
+      continue;
+    }
+
+    this->inIsr = true;
+    this->sreg &= (uint8_t)~0x80;
+    this->isrCount++;
+    uint64_t isrStart = this->isrCycles;
+    this->Consume(fxPwm_SimIsrOverhead);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    vector();
+    this->isrHostNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    this->Observe();
+    if(this->isrCycles - isrStart > this->isrMaxCycles){
+      this->isrMaxCycles = (uint32_t)(this->isrCycles - isrStart);
+    }
+    this->sreg |= 0x80;
+    this->inIsr = false;
+    return;
+  }
+
+  return;
+}
+
+//Deixa o programa principal ocioso por alguns ciclos.
+//Salta direto para a próxima comparação em vez de avançar ciclo a ciclo.
+//Mesmo com interrupções seguidas (CPU saturada), o tempo avança e a função retorna.
+void fxPwm_Sim::Run(uint64_t cpuCycles){
+  uint64_t end = this->cycles + cpuCycles;
+
+  this->Dispatch();
+  while(this->cycles<end){
+    uint64_t step = end - this->cycles;
+    step = (step>0x40000000)?(0x40000000):(step);
+    uint32_t toMatch = 0;
+    bool pending = false;
+    uint8_t t;
+    for(t=0;t<fxPwm_SimTimers;t++){
+      uint32_t toTimer = this->timers[t]->CyclesToNextMatch();
+      toMatch = (toTimer!=0 && (toMatch==0 || toTimer<toMatch))?(toTimer):(toMatch);
+      pending = pending || (this->timers[t]->tifr & this->timers[t]->timsk & 0b110);
+    }
+    if((this->sreg & 0x80) && pending){
+      //Outra interrupção já pendente: como no AVR, o programa principal executa uma instrução antes dela.
+      step = 1;
+    }else if(toMatch!=0 && toMatch<step){
+      step = toMatch;
+    }
+    this->Consume((uint32_t)step);
+    this->Dispatch();
+  }
+
+  return;
+}
+
+//Retorna o nível do pino na porta simulada.
+uint8_t fxPwm_Sim::GetPinState(uint8_t pin){
+  if(digitalPinToPort(pin)==NOT_A_PIN){
+    return LOW;
+  }
+  return (*portOutputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin))?(HIGH):(LOW);
+}
+
+//Liga o PWM por hardware. Nos valores 0 e 255 o núcleo do Arduino não usa o timer, só o nível fixo.
+void fxPwm_Sim::HwPwmWrite(uint8_t pin, uint8_t value){
+  if(digitalPinToPort(pin)==NOT_A_PIN){
+    return;
+  }
+  *portModeRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+  if(value==0){
+    *portOutputRegister(digitalPinToPort(pin)) &= (uint8_t)~digitalPinToBitMask(pin);
+  }else if(value==255){
+    *portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+  }
+  this->hwDuty[pin] = value;
+
+  return;
+}
+
+//Desliga o PWM por hardware e coloca o pino em nível BAIXO.
+void fxPwm_Sim::HwPwmOff(uint8_t pin){
+  if(digitalPinToPort(pin)==NOT_A_PIN){
+    return;
+  }
+  *portOutputRegister(digitalPinToPort(pin)) &= (uint8_t)~digitalPinToBitMask(pin);
+  this->hwDuty[pin] = -1;
+
+  return;
+}
+
+#endif
@@ -0,0 +1,287 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Sim.h
+ *  Simulador de host para a biblioteca fxPwm.
+ *  Emula os timers de 16 bits TIMER1, 3, 4 e 5 (pré-escalar,
+ *  estouro e comparação A/B com disparo de interrupção), o
+ *  registrador SREG e os registradores PORTx/DDRx, no lugar do
+ *  núcleo do Arduino.
+ *  Só é compilado quando fxPwm_HOST está definido.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ *  17-10-2026: duração da interrupção mais longa (isrMaxCycles).
+ *  17-10-2026: TIMER3, TIMER4 e TIMER5, como nas placas Mega.
+ *  17-10-2026: PWM por hardware dos pinos (hwTimer, analogWrite()), sem forma de onda.
+ *  17-10-2026: classes Print e Stream do núcleo do Arduino, para o protocolo binário (fxPwm_Stream.h).
+ *  17-10-2026: ISR_BLOCK, usado pelo modo fatiado (fxPwm_SliceBudget).
+ */
+
+#ifndef fxPwm_Sim_H
+#define fxPwm_Sim_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ========================================================
+// Parâmetros do simulador.
+// ========================================================
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+//Quantidade de portas (PORTx) simuladas, com 8 pinos cada.
+#ifndef fxPwm_SimPorts
+#define fxPwm_SimPorts 8
+#endif
+
+//Ciclos gastos para entrar e sair de uma interrupção (prólogo e epílogo).
+#ifndef fxPwm_SimIsrOverhead
+#define fxPwm_SimIsrOverhead 40
+#endif
+
+//Ciclos gastos em cada leitura do TCNTx.
+//Também garante que laços de espera no TCNT1 avancem o tempo.
+#ifndef fxPwm_SimTcntReadCycles
+#define fxPwm_SimTcntReadCycles 2
+#endif
+
+// ========================================================
+// Substitutos do núcleo do Arduino.
+// ========================================================
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define NOT_A_PIN 0
+#define NUM_DIGITAL_PINS (fxPwm_SimPorts*8)
+
+#ifndef LED_BUILTIN
+#define LED_BUILTIN 13
+#endif
+
+//Pinos são numerados em sequência: pino p fica na porta p/8+1, bit p%8.
+#define digitalPinToPort(p)     (((uint8_t)(p)<NUM_DIGITAL_PINS)?((uint8_t)((p)>>3)+1):(NOT_A_PIN))
+#define digitalPinToBitMask(p)  ((uint8_t)(1<<((p)&0x07)))
+#define portOutputRegister(n)   (&fxPwmSim.port[(n)-1])
+#define portModeRegister(n)     (&fxPwmSim.ddr[(n)-1])
+
+//Sem memória de programa separada: PROGMEM é memória comum (fxPwm_HAL_ReadTable16).
+#define PROGMEM
+
+#define SREG fxPwmSim.sreg
+#define cli() (fxPwmSim.sreg &= (uint8_t)~0x80)
+#define sei() (fxPwmSim.sreg |= (uint8_t)0x80)
+
+#define TCCR1A fxPwmSim.timer1.tccra
+#define TCCR1B fxPwmSim.timer1.tccrb
+#define TCCR1C fxPwmSim.timer1.tccrc
+#define TCNT1  fxPwmSim.timer1.tcnt
+#define ICR1   fxPwmSim.timer1.icr
+#define OCR1A  fxPwmSim.timer1.ocra
+#define OCR1B  fxPwmSim.timer1.ocrb
+#define TIMSK1 fxPwmSim.timer1.timsk
+#define TIFR1  fxPwmSim.timer1.tifr
+
+#define TCCR3A fxPwmSim.timer3.tccra
+#define TCCR3B fxPwmSim.timer3.tccrb
+#define TCCR3C fxPwmSim.timer3.tccrc
+#define TCNT3  fxPwmSim.timer3.tcnt
+#define ICR3   fxPwmSim.timer3.icr
+#define OCR3A  fxPwmSim.timer3.ocra
+#define OCR3B  fxPwmSim.timer3.ocrb
+#define TIMSK3 fxPwmSim.timer3.timsk
+#define TIFR3  fxPwmSim.timer3.tifr
+
+#define TCCR4A fxPwmSim.timer4.tccra
+#define TCCR4B fxPwmSim.timer4.tccrb
+#define TCCR4C fxPwmSim.timer4.tccrc
+#define TCNT4  fxPwmSim.timer4.tcnt
+#define ICR4   fxPwmSim.timer4.icr
+#define OCR4A  fxPwmSim.timer4.ocra
+#define OCR4B  fxPwmSim.timer4.ocrb
+#define TIMSK4 fxPwmSim.timer4.timsk
+#define TIFR4  fxPwmSim.timer4.tifr
+
+#define TCCR5A fxPwmSim.timer5.tccra
+#define TCCR5B fxPwmSim.timer5.tccrb
+#define TCCR5C fxPwmSim.timer5.tccrc
+#define TCNT5  fxPwmSim.timer5.tcnt
+#define ICR5   fxPwmSim.timer5.icr
+#define OCR5A  fxPwmSim.timer5.ocra
+#define OCR5B  fxPwmSim.timer5.ocrb
+#define TIMSK5 fxPwmSim.timer5.timsk
+#define TIFR5  fxPwmSim.timer5.tifr
+
+//Vetores de interrupção viram funções comuns, chamadas pelo simulador.
+#define TIMER1_COMPA_vect fxPwm_Sim_Timer1CompA
+#define TIMER1_COMPB_vect fxPwm_Sim_Timer1CompB
+#define TIMER3_COMPA_vect fxPwm_Sim_Timer3CompA
+#define TIMER3_COMPB_vect fxPwm_Sim_Timer3CompB
+#define TIMER4_COMPA_vect fxPwm_Sim_Timer4CompA
+#define TIMER4_COMPB_vect fxPwm_Sim_Timer4CompB
+#define TIMER5_COMPA_vect fxPwm_Sim_Timer5CompA
+#define TIMER5_COMPB_vect fxPwm_Sim_Timer5CompB
+#define ISR_NOBLOCK
+#define ISR_BLOCK
+#define ISR(vector, ...) void vector(void)
+
+//Declarados fracos: vetores sem rotina ficam nulos e não são chamados.
+void fxPwm_Sim_Timer1CompA(void) __attribute__((weak));
+void fxPwm_Sim_Timer1CompB(void) __attribute__((weak));
+void fxPwm_Sim_Timer3CompA(void) __attribute__((weak));
+void fxPwm_Sim_Timer3CompB(void) __attribute__((weak));
+void fxPwm_Sim_Timer4CompA(void) __attribute__((weak));
+void fxPwm_Sim_Timer4CompB(void) __attribute__((weak));
+void fxPwm_Sim_Timer5CompA(void) __attribute__((weak));
+void fxPwm_Sim_Timer5CompB(void) __attribute__((weak));
+
+//Quantidade de timers simulados.
+#define fxPwm_SimTimers 4
+
+//Saída e entrada de bytes, como as classes Print e Stream do núcleo do Arduino (a Serial, por exemplo).
+//Só o que a biblioteca usa.
+class Print{
+public:
+  virtual ~Print(){}
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+};
+
+class Stream : public Print{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// ========================================================
+// Classes do simulador.
+// ========================================================
+
+//Registrador TCNTx: cada leitura consome ciclos, como no hardware.
+class fxPwm_SimTcnt{
+private:
+  uint16_t value;
+public:
+  friend class fxPwm_SimTimer16;
+
+  operator uint16_t();
+  fxPwm_SimTcnt &operator=(uint16_t value);
+};
+
+//Timer de 16 bits em modo normal.
+class fxPwm_SimTimer16{
+private:
+  //Ciclos de CPU acumulados abaixo de um ciclo do timer.
+  uint32_t residual;
+
+  //Retorna o divisor do pré-escalar, ou 0 se o timer estiver parado.
+  uint16_t GetDivider();
+public:
+  friend class fxPwm_Sim;
+  friend class fxPwm_SimTcnt;
+
+  fxPwm_SimTcnt tcnt;
+  volatile uint16_t icr;
+  volatile uint16_t ocra;
+  volatile uint16_t ocrb;
+  volatile uint8_t tccra;
+  volatile uint8_t tccrb;
+  volatile uint8_t tccrc;
+  volatile uint8_t timsk;
+  volatile uint8_t tifr;
+
+  //Vetores de interrupção de comparação.
+  void (*compA)(void);
+  void (*compB)(void);
+
+  fxPwm_SimTimer16();
+
+  //Volta ao estado de reset.
+  void Reset();
+
+  //Avança o contador conforme os ciclos de CPU e marca as flags de comparação.
+  void Advance(uint32_t cpuCycles);
+
+  //Retorna quantos ciclos de CPU faltam para a próxima comparação, ou 0 se não houver.
+  uint32_t CyclesToNextMatch();
+};
+
+//Observador de mudanças de nível nas portas simuladas.
+//Recebe o índice da porta, o valor anterior, o valor novo e o ciclo de CPU.
+typedef void (*fxPwm_SimObserver)(uint8_t port, uint8_t before, uint8_t after, uint64_t cycle);
+
+//Microcontrolador simulado.
+class fxPwm_Sim{
+private:
+  //Última cópia das portas, para detectar mudanças.
+  uint8_t lastPort[fxPwm_SimPorts];
+  //Indica que alguma interrupção está em execução.
+  bool inIsr;
+  //Timers, na ordem de prioridade das interrupções.
+  fxPwm_SimTimer16 *timers[fxPwm_SimTimers];
+
+  //Compara as portas com a última cópia e avisa o observador.
+  void Observe();
+
+  //Atende a interrupção pendente de maior prioridade, se estiverem habilitadas.
+  void Dispatch();
+public:
+  fxPwm_SimTimer16 timer1;
+  fxPwm_SimTimer16 timer3;
+  fxPwm_SimTimer16 timer4;
+  fxPwm_SimTimer16 timer5;
+  volatile uint8_t sreg;
+  volatile uint8_t port[fxPwm_SimPorts];
+  volatile uint8_t ddr[fxPwm_SimPorts];
+
+  //Ciclos de CPU desde o reset.
+  uint64_t cycles;
+  //Ciclos de CPU gastos dentro de interrupções.
+  uint64_t isrCycles;
+  //Quantidade de interrupções atendidas.
+  uint32_t isrCount;
+  //Ciclos de CPU da interrupção mais longa, com entrada e saída.
+  uint32_t isrMaxCycles;
+  //Tempo real do host gasto dentro das interrupções, em nanossegundos.
+  uint64_t isrHostNs;
+
+  //Observador de mudanças nas portas, ou NULL.
+  fxPwm_SimObserver observer;
+
+  //Timer do PWM por hardware de cada pino (0, 2, 3, 4 ou 5), ou 0xFF se não tiver.
+  //No reset nenhum pino tem: o programa de teste escolhe quais têm, depois do Reset().
+  uint8_t hwTimer[NUM_DIGITAL_PINS];
+  //Último valor do analogWrite() em cada pino, ou -1 com o PWM por hardware desligado.
+  //Só o valor é guardado: a forma de onda do timer não é simulada.
+  int16_t hwDuty[NUM_DIGITAL_PINS];
+
+  fxPwm_Sim();
+
+  //Volta ao estado de reset. Interrupções ficam habilitadas, como após o setup() do Arduino.
+  void Reset();
+
+  //Consome ciclos de CPU, avançando os timers.
+  void Consume(uint32_t cpuCycles);
+
+  //Executa o programa principal (ocioso) por alguns ciclos, atendendo interrupções.
+  void Run(uint64_t cpuCycles);
+
+  //Retorna o nível de um pino.
+  uint8_t GetPinState(uint8_t pin);
+
+  //Liga o PWM por hardware num pino, como o analogWrite(): pino em modo de saída,
+  //e 0 e 255 viram nível BAIXO e ALTO fixos.
+  void HwPwmWrite(uint8_t pin, uint8_t value);
+  //Desliga o PWM por hardware num pino e o coloca em nível BAIXO, como o digitalWrite().
+  void HwPwmOff(uint8_t pin);
+};
+
+extern fxPwm_Sim fxPwmSim;
+
+#endif
@@ -0,0 +1,338 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Stream.cpp
+ *  Arquivo contendo definição do leitor, do codificador e da
+ *  Stream de laço do protocolo binário de controle.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_Stream.h>
+
+//Partes do quadro esperadas pelo leitor.
+#define fxPwm_PARSER_SYNC   0
+#define fxPwm_PARSER_HEADER 1
+#define fxPwm_PARSER_RECORD 2
+#define fxPwm_PARSER_CRC    3
+
+//Tamanho dos registros de cada operação.
+static const UINT8 fxPwm_streamRecordSizes[fxPwm_STREAM_OPS] = fxPwm_STREAM_RECORD_SIZES;
+
+//Sem tabela, para não gastar 256 bytes: 8 passos por byte, poucos perto do tempo de um byte na serial.
+UINT8 fxPwm_StreamCrc8(UINT8 crc, UINT8 value){
+  UINT8 bit;
+  crc ^= value;
+  for(bit=0;bit<8;bit++){
+    crc = (crc&0x80)?((UINT8)((crc<<1) ^ 0x07)):((UINT8)(crc<<1));
+  }
+
+  return crc;
+}
+
+//===============================================================
+//fxPwm_Parser
+//===============================================================
+
+fxPwm_Parser::fxPwm_Parser(){
+  this->engine = &fxPwm;
+  this->batch = FALSE;
+  this->frames = 0;
+  this->errors = 0;
+  this->Reset();
+
+  return;
+}
+
+fxPwm_Parser::fxPwm_Parser(fxPwm_T1 *engine){
+  this->engine = engine;
+  this->batch = FALSE;
+  this->frames = 0;
+  this->errors = 0;
+  this->Reset();
+
+  return;
+}
+
+void fxPwm_Parser::Reset(){
+  this->state = fxPwm_PARSER_SYNC;
+  this->header = 0;
+  this->crc = 0;
+  this->record = 0;
+  this->offset = 0;
+
+  return;
+}
+
+//Cada byte vai direto para o campo do registro atual.
+BOOL fxPwm_Parser::Feed(UINT8 value){
+  UINT8 op = (this->header>>4)&0x07;
+
+  switch(this->state){
+    case fxPwm_PARSER_SYNC:
+      if(value==fxPwm_STREAM_SYNC){
+        this->state = fxPwm_PARSER_HEADER;
+      }
+      return FALSE;
+
+    case fxPwm_PARSER_HEADER:
+      op = (value>>4)&0x07;
+      if(op>=fxPwm_STREAM_OPS || (value&0x0F)>fxPwm_StreamMaxRecords || (op==fxPwm_STREAM_NOP && (value&0x0F)!=0)){
+        //Cabeçalho impossível: provavelmente um SYNC falso.
+        this->errors++;
+        this->state = (value==fxPwm_STREAM_SYNC)?(fxPwm_PARSER_HEADER):(fxPwm_PARSER_SYNC);
+        return FALSE;
+      }
+      this->header = value;
+      this->crc = fxPwm_StreamCrc8(0, value);
+      this->record = 0;
+      this->offset = 0;
+      this->state = ((value&0x0F)==0)?(fxPwm_PARSER_CRC):(fxPwm_PARSER_RECORD);
+      return FALSE;
+
+    case fxPwm_PARSER_RECORD:{
+      fxPwm_StreamRecord *record = &this->records[this->record];
+      this->crc = fxPwm_StreamCrc8(this->crc, value);
+      if(this->offset==0){
+        record->pin = value;
+        record->period = 0;
+        record->duty16 = 0;
+      }else if(op==fxPwm_STREAM_PERIOD || (op==fxPwm_STREAM_PERIOD_DUTY && this->offset<=3)){
+        record->period |= (UINT32)value<<(8*(this->offset - 1));
+      }else{
+        //Ciclo de trabalho, ou estado de ENABLE.
+        record->duty16 |= (UINT16)value<<(8*(this->offset - ((op==fxPwm_STREAM_PERIOD_DUTY)?(4):(1))));
+      }
+      this->offset++;
+      if(this->offset>=fxPwm_streamRecordSizes[op]){
+        this->offset = 0;
+        this->record++;
+        if(this->record>=(this->header&0x0F)){
+          this->state = fxPwm_PARSER_CRC;
+        }
+      }
+      return FALSE;
+    }
+
+    default:
+      this->state = fxPwm_PARSER_SYNC;
+      if(value!=this->crc){
+        this->errors++;
+        return FALSE;
+      }
+      this->Apply();
+      return TRUE;
+  }
+}
+
+//Os registros entram no lote do motor, e só valem juntos no EndUpdate().
+void fxPwm_Parser::Apply(){
+  UINT8 op = (this->header>>4)&0x07;
+  UINT8 count = this->header&0x0F;
+  UINT8 t;
+
+  if(count>0 && this->batch==FALSE){
+    this->engine->BeginUpdate();
+    this->batch = TRUE;
+  }
+  for(t=0;t<count;t++){
+    fxPwm_StreamRecord *record = &this->records[t];
+    fxPwm_Port *port = this->engine->GetPort(record->pin);
+    if(port==NULL){
+      continue;
+    }
+    switch(op){
+      case fxPwm_STREAM_DUTY:
+        port->SetDuty16(record->duty16);
+        break;
+      case fxPwm_STREAM_PERIOD:
+        port->SetPeriod(record->period);
+        break;
+      case fxPwm_STREAM_PERIOD_DUTY:
+        port->SetPeriod(record->period);
+        port->SetDuty16(record->duty16);
+        break;
+      case fxPwm_STREAM_ENABLE:
+        if(record->duty16!=0){
+          port->Enable();
+        }else{
+          port->Disable();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  if((this->header&fxPwm_STREAM_COMMIT)!=0 && this->batch!=FALSE){
+    this->engine->EndUpdate();
+    this->batch = FALSE;
+  }
+  this->frames++;
+
+  return;
+}
+
+UINT8 fxPwm_Parser::Poll(Stream &stream){
+  UINT8 frames = 0;
+  while(stream.available()>0){
+    if(this->Feed((UINT8)stream.read())!=FALSE && frames<0xFF){
+      frames++;
+    }
+  }
+
+  return frames;
+}
+
+BOOL fxPwm_Parser::InBatch(){
+  return this->batch;
+}
+
+UINT16 fxPwm_Parser::GetFrames(){
+  return this->frames;
+}
+
+UINT16 fxPwm_Parser::GetErrors(){
+  return this->errors;
+}
+
+//===============================================================
+//fxPwm_Encoder
+//===============================================================
+
+fxPwm_Encoder::fxPwm_Encoder(Print &output){
+  this->output = &output;
+  this->op = fxPwm_STREAM_NOP;
+  this->count = 0;
+  this->length = 0;
+
+  return;
+}
+
+UINT8 *fxPwm_Encoder::Add(UINT8 op){
+  if(this->count>0 && (op!=this->op || this->count>=fxPwm_StreamMaxRecords)){
+    this->Send(FALSE);
+  }
+  this->op = op;
+  this->count++;
+  UINT8 *record = &this->data[this->length];
+  this->length += fxPwm_streamRecordSizes[op];
+
+  return record;
+}
+
+void fxPwm_Encoder::Send(BOOL commit){
+  UINT8 header = (UINT8)((this->op<<4) | this->count | ((commit!=FALSE)?(fxPwm_STREAM_COMMIT):(0)));
+  UINT8 crc = fxPwm_StreamCrc8(0, header);
+  UINT8 t;
+
+  for(t=0;t<this->length;t++){
+    crc = fxPwm_StreamCrc8(crc, this->data[t]);
+  }
+  this->output->write((uint8_t)fxPwm_STREAM_SYNC);
+  this->output->write(header);
+  this->output->write(this->data, this->length);
+  this->output->write(crc);
+
+  this->op = fxPwm_STREAM_NOP;
+  this->count = 0;
+  this->length = 0;
+
+  return;
+}
+
+void fxPwm_Encoder::Duty(UINT8 pin, UINT16 duty16){
+  UINT8 *record = this->Add(fxPwm_STREAM_DUTY);
+  record[0] = pin;
+  record[1] = (UINT8)duty16;
+  record[2] = (UINT8)(duty16>>8);
+}
+
+void fxPwm_Encoder::Period(UINT8 pin, UINT32 period){
+  period = (period>fxPwm_STREAM_MAX_PERIOD)?(fxPwm_STREAM_MAX_PERIOD):(period);
+  UINT8 *record = this->Add(fxPwm_STREAM_PERIOD);
+  record[0] = pin;
+  record[1] = (UINT8)period;
+  record[2] = (UINT8)(period>>8);
+  record[3] = (UINT8)(period>>16);
+}
+
+void fxPwm_Encoder::PeriodDuty(UINT8 pin, UINT32 period, UINT16 duty16){
+  period = (period>fxPwm_STREAM_MAX_PERIOD)?(fxPwm_STREAM_MAX_PERIOD):(period);
+  UINT8 *record = this->Add(fxPwm_STREAM_PERIOD_DUTY);
+  record[0] = pin;
+  record[1] = (UINT8)period;
+  record[2] = (UINT8)(period>>8);
+  record[3] = (UINT8)(period>>16);
+  record[4] = (UINT8)duty16;
+  record[5] = (UINT8)(duty16>>8);
+}
+
+void fxPwm_Encoder::Enable(UINT8 pin, BOOL enable){
+  UINT8 *record = this->Add(fxPwm_STREAM_ENABLE);
+  record[0] = pin;
+  record[1] = (enable!=FALSE)?(1):(0);
+}
+
+void fxPwm_Encoder::Flush(){
+  if(this->count>0){
+    this->Send(FALSE);
+  }
+}
+
+//Sem registros pendentes, um quadro NOP só com o COMMIT.
+void fxPwm_Encoder::Commit(){
+  this->Send(TRUE);
+}
+
+//===============================================================
+//fxPwm_Loopback
+//===============================================================
+
+fxPwm_Loopback::fxPwm_Loopback(){
+  this->head = 0;
+  this->tail = 0;
+
+  return;
+}
+
+size_t fxPwm_Loopback::write(uint8_t value){
+  UINT8 next = (this->tail+1>=fxPwm_LoopbackSize)?(0):(this->tail+1);
+  if(next==this->head){
+    return 0;
+  }
+  this->buffer[this->tail] = value;
+  this->tail = next;
+
+  return 1;
+}
+
+int fxPwm_Loopback::available(){
+  UINT8 head = this->head;
+  UINT8 tail = this->tail;
+
+  return (tail>=head)?(tail - head):(fxPwm_LoopbackSize - head + tail);
+}
+
+int fxPwm_Loopback::read(){
+  if(this->head==this->tail){
+    return -1;
+  }
+  UINT8 value = this->buffer[this->head];
+  this->head = (this->head+1>=fxPwm_LoopbackSize)?(0):(this->head+1);
+
+  return value;
+}
+
+int fxPwm_Loopback::peek(){
+  if(this->head==this->tail){
+    return -1;
+  }
+
+  return this->buffer[this->head];
+}
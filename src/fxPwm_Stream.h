@@ -0,0 +1,189 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Stream.h
+ *  Cabeçalho contendo o protocolo binário de controle do fxPwm
+ *  por uma Stream (Serial, por exemplo): o leitor incremental
+ *  (fxPwm_Parser), que entrega os quadros ao lote do motor, o
+ *  codificador (fxPwm_Encoder), para o outro lado, e uma Stream
+ *  de laço (fxPwm_Loopback), para testes.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwm_Stream_H
+#define fxPwm_Stream_H
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+
+// ========================================================
+// Protocolo.
+// ========================================================
+
+//Quadro: SYNC, cabeçalho, registros e CRC.
+//  SYNC: fxPwm_STREAM_SYNC. Como cabeçalho, ele é inválido (operação 7): uma sequência de SYNCs não engana o leitor.
+//  Cabeçalho: bit 7 COMMIT (fecha o lote depois do quadro), bits 6~4 operação, bits 3~0 quantidade de registros.
+//  Registros: todos da operação do cabeçalho. O primeiro byte é o pino (handle), e os valores são little-endian.
+//  CRC: CRC-8 (polinômio 0x07, valor inicial 0) do cabeçalho e dos registros.
+#define fxPwm_STREAM_SYNC   0x7E
+#define fxPwm_STREAM_COMMIT 0x80
+
+//Operações, e o tamanho dos registros de cada uma, em bytes.
+//NOP: sem registros. Com COMMIT, só fecha o lote.
+//DUTY: pino, ciclo de trabalho de 16 bits (2 bytes, com o mapeamento de SetMap16).
+//PERIOD: pino, período em microssegundos (3 bytes).
+//PERIOD_DUTY: pino, período (3 bytes) e ciclo de trabalho (2 bytes).
+//ENABLE: pino, 0 para desabilitar ou outro valor para habilitar (1 byte).
+#define fxPwm_STREAM_NOP         0
+#define fxPwm_STREAM_DUTY        1
+#define fxPwm_STREAM_PERIOD      2
+#define fxPwm_STREAM_PERIOD_DUTY 3
+#define fxPwm_STREAM_ENABLE      4
+#define fxPwm_STREAM_OPS         5
+#define fxPwm_STREAM_RECORD_SIZES {0, 3, 4, 6, 2}
+#define fxPwm_STREAM_MAX_RECORD  6
+
+//Maior período de um registro, em microssegundos.
+#define fxPwm_STREAM_MAX_PERIOD 0xFFFFFFUL
+
+//Máximo de registros num quadro, de 1 até 15. O leitor recusa quadros maiores,
+//e o codificador não os gera. Ocupa 7 bytes por registro no leitor, e 6 no codificador.
+#ifndef fxPwm_StreamMaxRecords
+#define fxPwm_StreamMaxRecords 8
+#endif
+
+//Capacidade da Stream de laço, em bytes, até 255 (uma posição fica sempre livre).
+#ifndef fxPwm_LoopbackSize
+#define fxPwm_LoopbackSize 64
+#endif
+
+//Soma um byte no CRC-8 do protocolo.
+UINT8 fxPwm_StreamCrc8(UINT8 crc, UINT8 value);
+
+// ========================================================
+// Leitor.
+// ========================================================
+
+//Registro decodificado, esperando o CRC do quadro.
+struct fxPwm_StreamRecord{
+  UINT8 pin;
+  UINT32 period;
+  //Ciclo de trabalho, ou o estado de ENABLE.
+  UINT16 duty16;
+};
+
+//Classe que lê quadros byte a byte, direto do buffer de recepção da Stream, sem guardar os bytes:
+//cada campo é decodificado no registro assim que chega. Quando o CRC confere, os registros entram num lote
+//do motor (BeginUpdate()), que continua aberto entre quadros até um quadro com COMMIT (EndUpdate()).
+//Assim vários quadros mudam várias portas no mesmo instante. Quadros com erro são descartados inteiros,
+//e o leitor procura o próximo SYNC.
+class fxPwm_Parser{
+private:
+  //Motor que recebe os quadros.
+  fxPwm_T1 *engine;
+
+  //Parte do quadro esperada (fxPwm_PARSER_SYNC etc., em fxPwm_Stream.cpp).
+  UINT8 state;
+  //Cabeçalho do quadro atual, e CRC até aqui.
+  UINT8 header;
+  UINT8 crc;
+  //Registro atual, e byte dentro dele.
+  UINT8 record;
+  UINT8 offset;
+  //Registros do quadro atual.
+  fxPwm_StreamRecord records[fxPwm_StreamMaxRecords];
+
+  //Indica que o lote do motor foi aberto por este leitor.
+  BOOL batch;
+
+  //Quadros aplicados e quadros descartados.
+  UINT16 frames;
+  UINT16 errors;
+
+  //Aplica o quadro atual, já conferido.
+  void Apply();
+public:
+  //Leitor para o fxPwm.
+  fxPwm_Parser();
+  //Leitor para outro motor.
+  fxPwm_Parser(fxPwm_T1 *engine);
+
+  //Lê um byte. Retorna TRUE se ele completou um quadro, que foi aplicado.
+  BOOL Feed(UINT8 value);
+  //Lê todos os bytes disponíveis na Stream. Retorna a quantidade de quadros aplicados.
+  UINT8 Poll(Stream &stream);
+  //Descarta o quadro pela metade. O lote aberto continua aberto.
+  void Reset();
+
+  //Indica se há um lote aberto, esperando um quadro com COMMIT.
+  BOOL InBatch();
+  //Quantidade de quadros aplicados e descartados (CRC errado ou quadro grande demais).
+  UINT16 GetFrames();
+  UINT16 GetErrors();
+};
+
+// ========================================================
+// Codificador.
+// ========================================================
+
+//Classe que monta quadros para uma Print (Serial, por exemplo), do lado que controla o fxPwm.
+//Registros seguidos da mesma operação vão no mesmo quadro, até fxPwm_StreamMaxRecords. Um registro de outra
+//operação, ou com o quadro cheio, envia o quadro atual sem COMMIT. Commit() envia o último com COMMIT.
+//Não depende do motor: compila também no host, contra o simulador.
+class fxPwm_Encoder{
+private:
+  //Saída dos quadros.
+  Print *output;
+  //Operação e quantidade de registros do quadro atual.
+  UINT8 op;
+  UINT8 count;
+  //Registros do quadro atual, já no formato do protocolo.
+  UINT8 data[fxPwm_StreamMaxRecords*fxPwm_STREAM_MAX_RECORD];
+  UINT8 length;
+
+  //Começa um registro de uma operação, enviando o quadro atual se preciso. Retorna onde escrever o registro.
+  UINT8 *Add(UINT8 op);
+  //Envia o quadro atual, com ou sem COMMIT.
+  void Send(BOOL commit);
+public:
+  fxPwm_Encoder(Print &output);
+
+  //Registros, na mesma ordem em que vão ser aplicados. Períodos em microssegundos, até fxPwm_STREAM_MAX_PERIOD.
+  void Duty(UINT8 pin, UINT16 duty16);
+  void Period(UINT8 pin, UINT32 period);
+  void PeriodDuty(UINT8 pin, UINT32 period, UINT16 duty16);
+  void Enable(UINT8 pin, BOOL enable);
+
+  //Envia os registros pendentes, sem fechar o lote.
+  void Flush();
+  //Envia os registros pendentes e fecha o lote: as mudanças desde o último Commit() valem juntas.
+  void Commit();
+};
+
+// ========================================================
+// Stream de laço.
+// ========================================================
+
+//Stream em memória: o que é escrito pode ser lido de volta, na ordem. Serve de Serial de mentira
+//para testar o codificador e o leitor juntos, no host ou na placa.
+class fxPwm_Loopback : public Stream{
+private:
+  UINT8 buffer[fxPwm_LoopbackSize];
+  volatile UINT8 head;
+  volatile UINT8 tail;
+public:
+  fxPwm_Loopback();
+
+  //Escreve um byte. Retorna 0 se estiver cheia.
+  virtual size_t write(uint8_t value);
+  using Print::write;
+  virtual int available();
+  virtual int read();
+  virtual int peek();
+};
+
+#endif
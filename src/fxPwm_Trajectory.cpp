@@ -0,0 +1,175 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Trajectory.cpp
+ *  Arquivo contendo definição dos métodos da classe
+ *  fxPwm_Trajectory. O passo de cada período fica no Tick()
+ *  (fxPwm_T1::StepTrajectory).
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#include <fxPwmTypes.h>
+#include <fxPwm.h>
+#include <fxPwm_Port.h>
+#include <fxPwm_Trajectory.h>
+
+//Um período de senoide, (1 - cos)/2, em 64 passos.
+const UINT16 fxPwm_SineTable[1<<fxPwm_SINE_TABLE_BITS] PROGMEM = {
+  0x0000, 0x009E, 0x0276, 0x0583, 0x09BE, 0x0F1D, 0x1592, 0x1D0E,
+  0x257D, 0x2ECC, 0x38E3, 0x43A9, 0x4F04, 0x5AD8, 0x6707, 0x7374,
+  0x7FFF, 0x8C8B, 0x98F8, 0xA527, 0xB0FB, 0xBC56, 0xC71C, 0xD133,
+  0xDA82, 0xE2F1, 0xEA6D, 0xF0E2, 0xF641, 0xFA7C, 0xFD89, 0xFF61,
+  0xFFFF, 0xFF61, 0xFD89, 0xFA7C, 0xF641, 0xF0E2, 0xEA6D, 0xE2F1,
+  0xDA82, 0xD133, 0xC71C, 0xBC56, 0xB0FB, 0xA527, 0x98F8, 0x8C8B,
+  0x8000, 0x7374, 0x6707, 0x5AD8, 0x4F04, 0x43A9, 0x38E3, 0x2ECC,
+  0x257D, 0x1D0E, 0x1592, 0x0F1D, 0x09BE, 0x0583, 0x0276, 0x009E
+};
+
+//Construtor. Sem modo até ser configurada ou atribuída a uma porta.
+fxPwm_Trajectory::fxPwm_Trajectory(){
+  this->mode = fxPwm_TRAJECTORY_NONE;
+  this->value = 0;
+  this->target = 0;
+  this->step = 0;
+  this->remaining = 0;
+  this->shift = 0;
+  this->table = NULL;
+  this->tableBits = 0;
+  this->phase = 0;
+  this->increment = 0;
+  this->port = NULL;
+
+  return;
+}
+
+//Destrutor. A porta volta ao ciclo de trabalho fixo, no valor atual.
+fxPwm_Trajectory::~fxPwm_Trajectory(){
+  if(this->port!=NULL){
+    this->port->SetTrajectory(NULL);
+  }
+
+  return;
+}
+
+//Para o Tick() de mexer no valor, e retorna o valor atual.
+//A configuração seguinte pode então fazer contas longas com interrupções habilitadas.
+UINT32 fxPwm_Trajectory::Freeze(){
+  fxPwm_SaveSREG();cli();
+  this->mode = fxPwm_TRAJECTORY_HOLD;
+  UINT32 value = this->value;
+  fxPwm_RestoreSREG();
+
+  return value;
+}
+
+void fxPwm_Trajectory::Hold(UINT16 duty16){
+  fxPwm_SaveSREG();cli();
+  this->value = (UINT32)duty16<<16;
+  this->mode = fxPwm_TRAJECTORY_HOLD;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//O passo é calculado uma vez aqui, com a divisão. O último passo cai exatamente no alvo.
+void fxPwm_Trajectory::Ramp(UINT16 duty16, UINT32 periods){
+  if(periods==0){
+    this->Hold(duty16);
+    return;
+  }
+  UINT32 value = this->Freeze();
+  UINT32 target = (UINT32)duty16<<16;
+  //Com 2 passos ou mais, o passo cabe em 31 bits. Com 1 passo ele não é usado.
+  INT32 step = (periods>1)?((INT32)(((INT64)target - (INT64)value)/(INT64)periods)):(0);
+
+  fxPwm_SaveSREG();cli();
+  this->target = target;
+  this->step = step;
+  this->remaining = periods;
+  this->mode = fxPwm_TRAJECTORY_RAMP;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+void fxPwm_Trajectory::Approach(UINT16 duty16, UINT8 shift){
+  this->Freeze();
+
+  fxPwm_SaveSREG();cli();
+  this->target = (UINT32)duty16<<16;
+  this->shift = (shift>15)?(15):(shift);
+  this->mode = fxPwm_TRAJECTORY_APPROACH;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+void fxPwm_Trajectory::Table(const UINT16 *table, UINT8 tableBits, UINT32 increment){
+  if(table==NULL || tableBits<1 || tableBits>16){
+    return;
+  }
+  this->Freeze();
+
+  fxPwm_SaveSREG();cli();
+  this->table = table;
+  this->tableBits = tableBits;
+  this->phase = 0;
+  this->increment = increment;
+  this->value = (UINT32)fxPwm_HAL_ReadTable16(table)<<16;
+  this->mode = fxPwm_TRAJECTORY_TABLE;
+  fxPwm_RestoreSREG();
+
+  return;
+}
+
+//2^32*pwmPeriod/wavePeriod: a volta do acumulador de fase é a tabela inteira.
+UINT32 fxPwm_Trajectory::Increment(UINT32 pwmPeriod, UINT32 wavePeriod){
+  if(wavePeriod==0){
+    return 0;
+  }
+  UINT64 increment = ((UINT64)pwmPeriod<<32)/wavePeriod;
+
+  return (increment>0xFFFFFFFF)?(0xFFFFFFFF):((UINT32)increment);
+}
+
+UINT8 fxPwm_Trajectory::GetMode(){
+  return this->mode;
+}
+
+UINT16 fxPwm_Trajectory::GetDuty16(){
+  fxPwm_SaveSREG();cli();
+  UINT32 value = this->value;
+  fxPwm_RestoreSREG();
+
+  return (UINT16)(value>>16);
+}
+
+BOOL fxPwm_Trajectory::IsDone(){
+  BOOL done;
+  fxPwm_SaveSREG();cli();
+  switch(this->mode){
+    case fxPwm_TRAJECTORY_RAMP:
+      done = (this->remaining==0)?(TRUE):(FALSE);
+      break;
+    case fxPwm_TRAJECTORY_APPROACH:
+      done = (this->value==this->target)?(TRUE):(FALSE);
+      break;
+    case fxPwm_TRAJECTORY_TABLE:
+      done = FALSE;
+      break;
+    default:
+      done = TRUE;
+      break;
+  }
+  fxPwm_RestoreSREG();
+
+  return done;
+}
+
+fxPwm_Port *fxPwm_Trajectory::GetPort(){
+  return this->port;
+}
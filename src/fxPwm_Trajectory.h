@@ -0,0 +1,103 @@
+/*  -----------------------------------------------------------
+ *  Andrei Alves Cardoso 17-10-2026
+ *  -----------------------------------------------------------
+ *  fxPwm_Trajectory.h
+ *  Cabeçalho contendo declaração da classe fxPwm_Trajectory,
+ *  uma trajetória do ciclo de trabalho (rampa, aproximação
+ *  exponencial ou forma de onda em tabela) que o Tick() avança
+ *  uma vez por período da porta, em ponto fixo.
+ *  -----------------------------------------------------------
+ *  Você pode usar livremente esse programa para quaisquer fins,
+ *  porém NÃO HÁ GARANTIA para qualquer propósito.
+ *  -----------------------------------------------------------
+ *  17-10-2026: primeira documentação.
+ */
+
+#ifndef fxPwm_Trajectory_H
+#define fxPwm_Trajectory_H
+
+#include <fxPwmTypes.h>
+
+class fxPwm_Port;
+
+//Modos de uma trajetória.
+//NONE: nunca configurada. Ao ser atribuída a uma porta, começa no ciclo de trabalho dela (HOLD).
+//HOLD: ciclo de trabalho fixo.
+//RAMP: rampa linear até o alvo, em uma quantidade de períodos.
+//APPROACH: aproximação exponencial do alvo, andando 1/2^shift da distância a cada período.
+//TABLE: forma de onda numa tabela em PROGMEM, percorrida por um acumulador de fase.
+#define fxPwm_TRAJECTORY_NONE     0
+#define fxPwm_TRAJECTORY_HOLD     1
+#define fxPwm_TRAJECTORY_RAMP     2
+#define fxPwm_TRAJECTORY_APPROACH 3
+#define fxPwm_TRAJECTORY_TABLE    4
+
+//Tabela com um período de senoide, de 0 até fxPwm_DUTY16_MAX, começando em 0. Fica em PROGMEM.
+#define fxPwm_SINE_TABLE_BITS 6
+extern const UINT16 fxPwm_SineTable[1<<fxPwm_SINE_TABLE_BITS] PROGMEM;
+
+//Classe que encapsula uma trajetória do ciclo de trabalho de uma porta (fxPwm_Port::SetTrajectory).
+//No início de cada período da porta, o Tick() avança a trajetória um passo e aplica o valor,
+//sem FLOAT e sem nada a fazer no loop(). O valor vai direto para a porta, sem mapeamento.
+//Os métodos de configuração podem ser chamados a qualquer momento: a trajetória continua do valor atual.
+class fxPwm_Trajectory{
+private:
+  //Modo (fxPwm_TRAJECTORY_HOLD etc.).
+  volatile UINT8 mode;
+  //Valor atual, em ponto fixo 16.16: a parte inteira é o ciclo de trabalho de 16 bits.
+  volatile UINT32 value;
+  //Alvo da rampa e da aproximação, em ponto fixo 16.16.
+  UINT32 target;
+  //Passo da rampa, em ponto fixo 16.16, e quantidade de passos que faltam.
+  INT32 step;
+  UINT32 remaining;
+  //Divisor da aproximação, em potência de 2.
+  UINT8 shift;
+  //Tabela em PROGMEM, com 2^tableBits valores.
+  const UINT16 *table;
+  UINT8 tableBits;
+  //Acumulador de fase da tabela: os tableBits bits mais altos são o índice, e os 16 seguintes a interpolação.
+  UINT32 phase;
+  //Soma no acumulador de fase a cada período.
+  UINT32 increment;
+
+  //Porta que a trajetória move, ou NULL.
+  fxPwm_Port *port;
+
+  //Congela a trajetória no valor atual e o retorna.
+  UINT32 Freeze();
+public:
+  friend class fxPwm_T1;
+  friend class fxPwm_Port;
+
+  //Inicializa uma trajetória sem modo: ela começa no ciclo de trabalho da porta a que for atribuída.
+  fxPwm_Trajectory();
+
+  //Destrutor. Tira a trajetória da porta.
+  ~fxPwm_Trajectory();
+
+  //Fixa o ciclo de trabalho, de 0 até fxPwm_DUTY16_MAX.
+  void Hold(UINT16 duty16);
+  //Rampa linear do valor atual até duty16, em periods períodos da porta. Com periods 0, vai direto.
+  void Ramp(UINT16 duty16, UINT32 periods);
+  //Aproximação exponencial do valor atual até duty16: a cada período anda 1/2^shift da distância
+  //(constante de tempo de cerca de 2^shift períodos), e chega exatamente no alvo. shift de 0 até 15.
+  void Approach(UINT16 duty16, UINT8 shift);
+  //Forma de onda numa tabela em PROGMEM com 2^tableBits valores de 0 até fxPwm_DUTY16_MAX (tableBits de 1 até 16).
+  //A cada período o acumulador de fase anda increment (veja Increment()), com interpolação linear entre os valores.
+  //A fase recomeça do início da tabela.
+  void Table(const UINT16 *table, UINT8 tableBits, UINT32 increment);
+  //Soma no acumulador de fase para que a tabela seja percorrida em wavePeriod, com a porta em pwmPeriod (ambos na mesma unidade).
+  static UINT32 Increment(UINT32 pwmPeriod, UINT32 wavePeriod);
+
+  //Retorna o modo (fxPwm_TRAJECTORY_HOLD etc.).
+  UINT8 GetMode();
+  //Retorna o ciclo de trabalho atual, de 0 até fxPwm_DUTY16_MAX.
+  UINT16 GetDuty16();
+  //Indica se a trajetória chegou ao fim (rampa ou aproximação no alvo, ou valor fixo). Uma tabela nunca acaba.
+  BOOL IsDone();
+  //Retorna a porta que a trajetória move, ou NULL.
+  fxPwm_Port *GetPort();
+};
+
+#endif